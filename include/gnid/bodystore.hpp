@@ -0,0 +1,85 @@
+#ifndef BODYSTORE_HPP
+#define BODYSTORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gnid/matrix/matrix.hpp"
+
+namespace gnid
+{
+
+class Rigidbody;
+class ThreadPool;
+
+/**
+ * \brief The state of the rigid bodies of a scene, stored by component
+ *
+ * \details
+ *     Every rigid body in a scene has an index into the arrays here, which
+ *     hold the state the scene integrates every update. Keeping each
+ *     component in its own contiguous array lets the integration run as a
+ *     tight loop over the arrays without going through the nodes, and lets
+ *     it be split across threads.
+ *
+ *     A rigid body that is not in a scene keeps its state itself. It is
+ *     moved into the arrays when the body is added, and back into the body
+ *     when it is removed.
+ */
+class BodyStore
+{
+public:
+    /* The rigid body is asleep and is not integrated. */
+    static const uint8_t SLEEPING = 1;
+
+    ~BodyStore();
+
+    size_t size() const { return bodies.size(); }
+
+    /**
+     * \brief Add a rigid body to the end of the arrays
+     */
+    void add(const std::shared_ptr<Rigidbody> &rb);
+
+    /**
+     * \brief Remove a rigid body from the arrays
+     *
+     * \details
+     *     The last rigid body takes the place of the removed one.
+     */
+    void remove(const std::shared_ptr<Rigidbody> &rb);
+
+    /**
+     * \brief Copy the world positions of the awake bodies from their nodes
+     */
+    void readPositions();
+
+    /**
+     * \brief Move the awake bodies by their velocities, then add gravity
+     *
+     * \details
+     *     Only the arrays are changed, the new positions still have to be
+     *     written back to the nodes. If pool is not null, large stores are
+     *     integrated on its threads.
+     */
+    void integrate(float dt, const tmat::Vector3f &gravity, ThreadPool *pool);
+
+    std::vector<std::shared_ptr<Rigidbody>> bodies;
+    std::vector<tmat::Vector3f> positions;
+    std::vector<tmat::Vector3f> velocities;
+    std::vector<float> inverseMasses;
+    std::vector<uint8_t> flags;
+
+private:
+    void integrateRange(
+            size_t first,
+            size_t last,
+            float dt,
+            const tmat::Vector3f &gravity);
+};
+
+} /* namespace */
+
+#endif
@@ -36,6 +36,18 @@ public:
      */
     void add(const Box &other);
 
+    /**
+     * \brief Adds the bounds of the given shape to the box
+     *
+     * \details
+     *     The shape is transformed by shapeToWorld, and worldToShape must be
+     *     its inverse.
+     */
+    void add(
+            const Shape &shape,
+            const tmat::Matrix4f &shapeToWorld,
+            const tmat::Matrix4f &worldToShape);
+
     /**
      * \brief Returns true if this box overlaps the given box
      */
@@ -51,6 +63,27 @@ public:
      */
     bool contains(const tmat::Vector3f &other) const;
 
+    /**
+     * \brief
+     *     Returns the distance from the point to the nearest point in the box,
+     *     or zero if the point is inside the box
+     */
+    float distance(const tmat::Vector3f &point) const;
+
+    /**
+     * \brief Returns true if the ray hits the box within maxDistance
+     *
+     * \details
+     *     The distance along the ray where it enters the box is stored in
+     *     distance, in multiples of direction. A ray starting inside the box
+     *     enters it at zero.
+     */
+    bool raycast(
+            float &distance,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
     /**
      * \brief Returns the lower corner of the box
      */
@@ -83,6 +116,7 @@ public:
 
     /******** Collider shape methods. ********/
     tmat::Vector3f support(const tmat::Vector3f &d) const override;
+    ShapeType type() const override { return BOX; }
 
 private:
     tmat::Vector3f min_;
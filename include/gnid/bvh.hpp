@@ -0,0 +1,366 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "gnid/collisionpruner.hpp"
+
+namespace gnid
+{
+
+/* Forward declarations. */
+class Collider;
+
+/**
+ * \brief A bounding volume hierarchy for partitioning colliders in space
+ *
+ * \details
+ *     The hierarchy is built top down using a binned surface area heuristic
+ *     (SAH). Nodes are stored in a flat array in depth first order, with the
+ *     left child of an inner node directly following it. Each frame the tree
+ *     is refit to the new bounding boxes of its colliders. If refitting makes
+ *     the tree too expensive compared to when it was built, or colliders were
+ *     added or removed, it is rebuilt.
+ */
+class Bvh
+{
+public:
+    /**
+     * \brief Create an empty bounding volume hierarchy
+     *
+     * \param maxCollidersPerLeaf
+     *     The maximum number of colliders allowed in each leaf node
+     */
+    Bvh(unsigned int maxCollidersPerLeaf = 4);
+
+    /**
+     * \brief Add a collider to the tree
+     *
+     * \details
+     *     The collider will not be in the tree until update() is called.
+     */
+    void add(std::shared_ptr<Collider> collider);
+
+    /**
+     * \brief Remove a collider from the tree
+     *
+     * \details
+     *     The tree will be rebuilt the next time update() is called.
+     */
+    void remove(std::shared_ptr<Collider> collider);
+
+    /**
+     * \brief Clear all colliders from the tree
+     */
+    void clear();
+
+    /**
+     * \brief Update the tree from the new positions of the colliders
+     *
+     * \details
+     *     This function should be called at least once per frame, after the
+     *     colliders have updated their bounding boxes.
+     */
+    void update();
+
+    /**
+     * \brief Rebuild the tree from scratch
+     */
+    void regenerate();
+
+    /**
+     * \brief
+     *     List the colliders whose bounding boxes overlap and store them in
+     *     the list
+     */
+    void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list) const;
+
+    /**
+     * \brief List all of the colliders in the tree and add them to the list
+     */
+    void listAllNodes(std::vector<std::shared_ptr<Collider>> &list) const;
+
+    /**
+     * \brief Find the nearest collider hit by the ray
+     *
+     * \details
+     *     The tree is searched from front to back, skipping nodes further away
+     *     than the nearest hit found so far. Returns true if a collider is hit
+     *     within maxDistance, in which case the hit is stored in hit. The
+     *     direction must be normalized.
+     */
+    bool raycast(
+            RaycastHit &hit,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
+    /**
+     * \brief
+     *     Find the nearest collider hit by the shape moving along the given
+     *     direction
+     *
+     * \details
+     *     Works like raycast(), where the ray is the shape transformed by
+     *     shapeToWorld.
+     */
+    bool sweep(
+            RaycastHit &hit,
+            const Shape &shape,
+            const tmat::Matrix4f &shapeToWorld,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes overlap the box
+     *
+     * \details
+     *     The colliders accepted by the filter are added to the list, which
+     *     **will not** be cleared. The search does not allocate.
+     */
+    void queryBox(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const Box &box,
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes overlap the sphere
+     *
+     * \details
+     *     Works like queryBox().
+     */
+    void querySphere(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const tmat::Vector3f &center,
+            float radius,
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes are nearest the point
+     *
+     * \details
+     *     The list **will not** be cleared. It must already be sorted nearest
+     *     first, and nearer colliders are inserted into it using
+     *     CollisionPruner::insertNearest(). Subtrees further than the furthest
+     *     listed collider are skipped once the list is full.
+     */
+    void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            const tmat::Vector3f &point,
+            size_t count,
+            float maxDistance = std::numeric_limits<float>::infinity(),
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Returns the maximum number of colliders allowed in each leaf
+     */
+    const unsigned int &maxCollidersPerLeaf() const
+    {
+        return maxCollidersPerLeaf_;
+    }
+
+    /**
+     * \brief
+     *     How much the SAH cost of the tree may grow from refitting before
+     *     the tree is rebuilt
+     *
+     * \details
+     *     The cost is relative to the cost of the tree when it was last built,
+     *     so a value of 1.5 rebuilds the tree once it becomes 50% more
+     *     expensive to traverse.
+     */
+    float &rebuildThreshold() { return rebuildThreshold_; }
+
+    /**
+     * \brief Return the number of nodes in the tree
+     */
+    unsigned int nodeCount() const { return nodes_.size(); }
+
+    /**
+     * \brief Return the depth of the tree
+     */
+    int depth() const;
+
+private:
+    /**
+     * \brief A node in the hierarchy
+     *
+     * \details
+     *     Inner nodes have a count of zero. The left child of an inner node is
+     *     always the next node in the array. Leaf nodes store a range of items.
+     */
+    class Node
+    {
+    public:
+        float min[3];
+        float max[3];
+        unsigned int right;
+        unsigned int first;
+        unsigned int count;
+        bool hasNonStaticColliders;
+
+        bool isLeaf() const { return count > 0; }
+    };
+
+    /**
+     * \brief A collider stored in a leaf, with a copy of its bounds
+     */
+    class Item
+    {
+    public:
+        float min[3];
+        float max[3];
+        unsigned int collider;
+        bool isStatic;
+    };
+
+    const unsigned int maxCollidersPerLeaf_;
+    float rebuildThreshold_;
+    float builtCost_;
+    bool needsRebuild_;
+
+    std::vector<Node> nodes_;
+    std::vector<Item> items_;
+    std::vector<std::shared_ptr<Collider>> colliders_;
+    std::unordered_map<const Collider *, unsigned int> indices_;
+
+    /**
+     * \brief Recursively build the subtree for the given range of items
+     */
+    void build(unsigned int first, unsigned int count);
+
+    /**
+     * \brief
+     *     Refit all of the node bounds bottom up and return the SAH cost of the
+     *     tree
+     */
+    float refit();
+
+    /**
+     * \brief Copy the bounds of each collider into its item
+     */
+    void updateItems();
+
+    /**
+     * \brief Find the nearest collider under the given node hit by a moving box
+     *
+     * \details
+     *     The box starts at boxMin and boxMax and moves along the direction.
+     *     Colliders whose bounds the box passes through are checked with the
+     *     given test, which is passed the maximum distance for the hit. The
+     *     nearer child of each node is visited first, and maxDistance shrinks
+     *     to each hit found so that further nodes are skipped.
+     */
+    template<typename Test>
+    bool cast(
+            RaycastHit &hit,
+            unsigned int index,
+            const float *boxMin,
+            const float *boxMax,
+            const tmat::Vector3f &direction,
+            float &maxDistance,
+            const Test &test) const;
+
+    /**
+     * \brief
+     *     Add the colliders under the given node whose bounds are within the
+     *     radius of the query bounds
+     */
+    void query(
+            std::vector<std::shared_ptr<Collider>> &list,
+            unsigned int index,
+            const float *min,
+            const float *max,
+            float radiusSquared,
+            const QueryFilter &filter) const;
+
+    /**
+     * \brief Insert the colliders under the given node nearest the point
+     */
+    void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            unsigned int index,
+            const float *point,
+            size_t count,
+            float maxDistance,
+            const QueryFilter &filter) const;
+
+    void listOverlappingItems(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list,
+            const Node &first,
+            const Node &second) const;
+
+    int depth(unsigned int index) const;
+};
+
+/**
+ * \brief A collision pruner based on a bounding volume hierarchy
+ */
+class BvhPruner : public CollisionPruner
+{
+public:
+    /**
+     * \brief Create the pruner from the given bounding volume hierarchy
+     */
+    BvhPruner(std::shared_ptr<Bvh> bvh);
+
+    void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list) const override;
+
+    void listAllNodes(
+            std::vector<std::shared_ptr<Collider>> &list) const override;
+
+    void add(std::shared_ptr<Collider>) override;
+    void remove(std::shared_ptr<Collider>) override;
+
+    /**
+     * \brief Update the bounding volume hierarchy
+     */
+    void update() override;
+
+    bool raycast(
+            RaycastHit &hit,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const override;
+
+    bool sweep(
+            RaycastHit &hit,
+            const Shape &shape,
+            const tmat::Matrix4f &from,
+            const tmat::Matrix4f &to) const override;
+
+    void queryBox(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const Box &box,
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    void querySphere(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const tmat::Vector3f &center,
+            float radius,
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            const tmat::Vector3f &point,
+            size_t count,
+            float maxDistance = std::numeric_limits<float>::infinity(),
+            const QueryFilter &filter = QueryFilter()) const override;
+private:
+    const std::shared_ptr<Bvh> bvh_;
+};
+
+} /* namespace */
+
+#endif
@@ -29,6 +29,24 @@ class Camera : public Node
          *     world matrix
          */
         const tmat::Matrix4f &viewMatrix() const;
+
+        /**
+         * \brief Keep the current world matrix to blend from when rendering
+         */
+        void savePreviousMatrix();
+
+        /**
+         * \brief
+         *     Returns the world matrix of the camera when savePreviousMatrix()
+         *     was last called
+         */
+        const tmat::Matrix4f &previousWorldMatrix() const;
+
+        /**
+         * \brief Returns true if savePreviousMatrix() has been called
+         */
+        bool hasPreviousWorldMatrix() const;
+
         void onSceneChanged(std::shared_ptr<Scene> newScene) override;
         
         std::shared_ptr<Node> clone() override
@@ -39,6 +57,8 @@ class Camera : public Node
         }
     private:
         tmat::Matrix4f projectionMatrix_;
+        tmat::Matrix4f previousWorldMatrix_;
+        bool hasPreviousWorldMatrix_ = false;
 };
 
 }; /* namespace */
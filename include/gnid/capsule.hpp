@@ -16,6 +16,7 @@ public:
     Capsule(float radius, tmat::Vector3f start, tmat::Vector3f end);
 
     tmat::Vector3f support(const tmat::Vector3f &d) const override;
+    ShapeType type() const override { return CAPSULE; }
 
     const float &radius() const { return radius_; }
     const tmat::Vector3f &start() const { return start_; }
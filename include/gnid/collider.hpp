@@ -1,14 +1,17 @@
 #ifndef COLLIDER_HPP
 #define COLLIDER_HPP
 
+#include <cassert>
+#include <cstdint>
 #include <memory>
+#include <limits>
 #include <list>
 #include <vector>
-#include <queue>
 
 #include "gnid/matrix/matrix.hpp"
 #include "gnid/box.hpp"
 #include "gnid/node.hpp"
+#include "gnid/shape.hpp"
 
 #include "gnid/observable.hpp"
 #include "gnid/observer.hpp"
@@ -16,8 +19,9 @@
 namespace gnid
 {
 
-class Shape;
 class Collision;
+class DistanceResult;
+class RaycastHit;
 
 /**
  * \brief A node capable of collision
@@ -28,9 +32,6 @@ class Collision;
  *     meaning it will not move during collisions but can still be collided
  *     against. If it does have a Rigidbody as an ancestor, its behavior is
  *     determined by its first Rigidbody ancestor.
- *
- * \todo
- *      - Add caching of initial axis for GJK.
  */
 class Collider : public Node
 {
@@ -54,8 +55,11 @@ public:
     /**
      * \brief
      *     Called after the collider is moved to calculate its new bounding box
+     *
+     * \details
+     *     Returns true if the bounding box was recalculated.
      */
-    void calcBox();
+    bool calcBox();
 
     /**
      * \brief Return the overlap between this collider and another one
@@ -64,7 +68,14 @@ public:
      *     Returns true if this collider is overlapping the other collider. If
      *     they are overlapping, the minimum amount needed to move the shapes so
      *     that they are not overlapping is stored in out. The initial axis to
-     *     use for the next iteration is stored in initialAxis
+     *     use for the next iteration is stored in initialAxis. If they are not
+     *     overlapping, this is an axis separating them, and passing it back in
+     *     on the next frame lets most pairs that are still apart return after
+     *     a single support point. It is left alone if they are overlapping.
+     *
+     *     If either shape is a TriangleMesh, the other is tested against the
+     *     triangles near it and out is the deepest of their overlaps. The
+     *     initial axis is not used.
      *
      * \param[out]    out         The overlap between the two shapes
      * \param[in,out] initialAxis The initial axis to start from
@@ -77,6 +88,78 @@ public:
             const std::shared_ptr<Collider> &other,
             const float tolerance = 0.001f) const;
 
+    /**
+     * \brief Find the distance between this collider and another one
+     *
+     * \details
+     *     Returns true if the colliders are apart, in which case the distance,
+     *     the closest points and the normal are stored in result. Unlike
+     *     getOverlap(), EPA is never run, so overlapping colliders only set the
+     *     distance to zero and return false.
+     *
+     *     Colliders closer than the tolerance count as touching, so they are
+     *     not apart.
+     *
+     *     If either shape is a TriangleMesh, only the triangles within
+     *     maxDistance of the other collider's bounding box are checked, and
+     *     the distance is infinite if there are none. Otherwise maxDistance is
+     *     not used.
+     *
+     * \param[out] result      The distance and closest points
+     * \param[in]  other       The other collider
+     * \param[in]  maxDistance How far away mesh triangles are checked
+     * \param[in]  tolerance   How close the distance must be to the true one
+     */
+    bool getDistance(
+            DistanceResult &result,
+            const std::shared_ptr<Collider> &other,
+            float maxDistance = std::numeric_limits<float>::infinity(),
+            const float tolerance = 0.001f) const;
+
+    /**
+     * \brief Returns the world space point on the collider furthest along d
+     */
+    tmat::Vector3f support(const tmat::Vector3f &d) const;
+
+    /**
+     * \brief Cast a ray against this collider
+     *
+     * \details
+     *     Returns true if the ray hits the collider within maxDistance, in
+     *     which case the distance, normal and point of hit are filled in. The
+     *     collider of hit is left for the caller to set. A ray starting inside
+     *     the collider hits it at a distance of zero, except for a
+     *     TriangleMesh, which has no inside.
+     *
+     * \param[out] hit         The hit, only changed if the ray hits
+     * \param[in]  origin      The start of the ray in world space
+     * \param[in]  direction   The unit direction of the ray
+     * \param[in]  maxDistance The length of the ray
+     * \param[in]  tolerance   The tolerance to use for the distance
+     */
+    bool raycast(
+            RaycastHit &hit,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance,
+            const float tolerance = 0.001f) const;
+
+    /**
+     * \brief Move a shape in a straight line and find where it hits this one
+     *
+     * \details
+     *     Works like raycast(), except that the ray is the given shape
+     *     transformed by shapeToWorld. The point of hit is on this collider.
+     *     The shape is only translated, not rotated, as it moves.
+     */
+    bool sweep(
+            RaycastHit &hit,
+            const Shape &shape,
+            const tmat::Matrix4f &shapeToWorld,
+            const tmat::Vector3f &direction,
+            float maxDistance,
+            const float tolerance = 0.001f) const;
+
     /**
      * \brief Returns an observable for when the collider enters a collision
      *
@@ -123,6 +206,31 @@ public:
      */
     bool &isTrigger();
 
+    /**
+     * \brief Returns whether the collider is a trigger or not
+     */
+    const bool &isTrigger() const;
+
+    /**
+     * \brief The friction coefficient of the collider's surface
+     *
+     * \details
+     *     Two colliders touching use the geometric mean of their coefficients.
+     *     The default is 0.5.
+     */
+    float &friction();
+    const float &friction() const;
+
+    /**
+     * \brief How much the collider bounces, between zero and one
+     *
+     * \details
+     *     Two colliders touching use the larger of their values. The default
+     *     is zero, which does not bounce at all.
+     */
+    float &restitution();
+    const float &restitution() const;
+
     /**
      * \brief Returns whether the collider is static
      *
@@ -148,46 +256,143 @@ public:
 private:
 
     /**
-     * \brief A triangle class used in the EPA algorithm
+     * \brief A simplex of at most four points used in the GJK algorithm
+     *
+     * \details
+     *     The points are stored in place, so that GJK does not allocate.
+     */
+    class Simplex
+    {
+    public:
+        Simplex() : size_(0) {}
+
+        void push_back(const tmat::Vector3f &point)
+        {
+            assert(size_ < 4);
+            points_[size_ ++] = point;
+        }
+
+        void resize(size_t size) { assert(size <= 4); size_ = size; }
+        size_t size() const { return size_; }
+
+        tmat::Vector3f &operator[](size_t i)
+        {
+            assert(i < size_);
+            return points_[i];
+        }
+
+        const tmat::Vector3f &operator[](size_t i) const
+        {
+            assert(i < size_);
+            return points_[i];
+        }
+
+        const tmat::Vector3f *begin() const { return points_; }
+        const tmat::Vector3f *end() const { return points_ + size_; }
+
+    private:
+        tmat::Vector3f points_[4];
+        size_t size_;
+    };
+
+    /**
+     * \brief A triangle of the polytope used in the EPA algorithm
+     *
+     * \details
+     *     Edge i goes from vertex i to vertex i + 1. The triangle across edge i
+     *     is neighbors[i], which has the same edge as its edge
+     *     neighborEdges[i].
      */
     class Triangle
     {
     public:
-        Triangle(
-                const int ia,
-                const int ib,
-                const int ic,
-                const std::vector<tmat::Vector3f> &vertices);
+        uint32_t vertices[3];
+        uint32_t neighbors[3];
+        uint32_t neighborEdges[3];
+        tmat::Vector3f normal;
+        float distance;
+
+        /* True if the triangle is no longer part of the polytope. */
+        bool removed;
+    };
+
+    /**
+     * \brief The polytope expanded by the EPA algorithm
+     *
+     * \details
+     *     Each thread keeps one polytope whose buffers are reused between
+     *     calls, so that EPA only allocates while the buffers grow to fit the
+     *     largest polytope seen so far.
+     */
+    class Polytope
+    {
+    public:
+        /* The index used for a missing neighbor. */
+        static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+        std::vector<tmat::Vector3f> vertices;
+        std::vector<Triangle> triangles;
 
-        const int &indexA() const { return ia; }
-        const int &indexB() const { return ib; }
-        const int &indexC() const { return ic; }
+        /* Triangles to check, along with the edge they were reached across. */
+        std::vector<std::pair<uint32_t, uint32_t>> stack;
 
-        const tmat::Vector3f &normal() const { return normal_; }
-        const float &distance() const { return distance_; };
+        /* The edges between the visible and hidden triangles. */
+        std::vector<std::pair<uint32_t, uint32_t>> horizon;
+
+        /**
+         * \brief Create a tetrahedron from the simplex
+         */
+        void reset(const Simplex &simplex);
+
+        /**
+         * \brief Add a triangle without any neighbors
+         */
+        void addTriangle(uint32_t a, uint32_t b, uint32_t c);
+
+        /**
+         * \brief Make the triangles across the given edges neighbors
+         */
+        void link(
+                uint32_t first,
+                uint32_t firstEdge,
+                uint32_t second,
+                uint32_t secondEdge);
 
         /**
          * \brief
-         *     Returns true if this triangle is closer to the origin than the
-         *     other
+         *     Link the edges without neighbors of the triangles from first on
+         *     to each other
          */
-        bool operator<(const Triangle &other) const;
+        void connect(uint32_t first);
 
-    private:
-        int ia;
-        int ib;
-        int ic;
-        tmat::Vector3f normal_;
-        float distance_;
+        /**
+         * \brief Returns the index of the triangle closest to the origin
+         */
+        uint32_t closest() const;
+
+        /**
+         * \brief Replace the triangles visible from the new vertex
+         *
+         * \details
+         *     The triangles visible from the vertex are found by walking the
+         *     neighbors of the given visible triangle. They are replaced with a
+         *     fan of triangles from the new vertex to the edges of the horizon.
+         */
+        void expand(uint32_t visible, const tmat::Vector3f &vertex);
     };
 
+    /* The polytope used by EPA on each thread. */
+    static thread_local Polytope polytope_;
+
     const std::shared_ptr<Shape> shape_;
     Box box_;
     bool isTrigger_ = false;
     bool isStatic_ = true;
+    float friction_ = 0.5f;
+    float restitution_ = 0;
 
     typedef bool (Collider::*NearestSimplexFunction)(
-            std::vector<tmat::Vector3f> &s,
+            Simplex &s,
             tmat::Vector3f &d) const;
 
     /* Nearest simplex lookup table. */
@@ -205,35 +410,165 @@ private:
      * \return True if s contains the origin.
      */
     bool nearestSimplex(
-            std::vector<tmat::Vector3f> &s,
+            Simplex &s,
             tmat::Vector3f &d) const;
 
     /* Implementations for each vertex count. */
     bool nearestSimplex1(
-            std::vector<tmat::Vector3f> &s,
+            Simplex &s,
             tmat::Vector3f &d) const;
     bool nearestSimplex2(
-            std::vector<tmat::Vector3f> &s,
+            Simplex &s,
             tmat::Vector3f &d) const;
     bool nearestSimplex3(
-            std::vector<tmat::Vector3f> &s,
+            Simplex &s,
             tmat::Vector3f &d) const;
     bool nearestSimplex4(
-            std::vector<tmat::Vector3f> &s,
+            Simplex &s,
             tmat::Vector3f &d) const;
 
     bool gjk(
             tmat::Vector3f &d,
-            std::vector<tmat::Vector3f> &s,
-            const std::shared_ptr<Collider> &other) const;
+            Simplex &s,
+            const Shape &otherShape,
+            const tmat::Matrix4f &otherToWorld,
+            const tmat::Matrix4f &worldToOther) const;
 
     void epa(
             tmat::Vector3f &out,
-            std::priority_queue<Triangle> &triangles,
-            std::vector<tmat::Vector3f> &vertices,
-            const std::shared_ptr<Collider> &other,
+            const Simplex &s,
+            const Shape &otherShape,
+            const tmat::Matrix4f &otherToWorld,
+            const tmat::Matrix4f &worldToOther,
+            const float tolerance) const;
+
+    /**
+     * \brief Finds the overlap with a shape using GJK and EPA
+     *
+     * \details
+     *     Works like getOverlap(), with the other shape transformed by
+     *     otherToWorld, and worldToOther its inverse.
+     */
+    bool getShapeOverlap(
+            tmat::Vector3f &out,
+            tmat::Vector3f &initialAxis,
+            const Shape &otherShape,
+            const tmat::Matrix4f &otherToWorld,
+            const tmat::Matrix4f &worldToOther,
+            const float tolerance) const;
+
+    /**
+     * \brief Finds the distance to a shape using GJK
+     *
+     * \details
+     *     Works like getDistance(), with the other shape transformed by
+     *     otherToWorld, and worldToOther its inverse.
+     */
+    bool getShapeDistance(
+            DistanceResult &result,
+            const Shape &otherShape,
+            const tmat::Matrix4f &otherToWorld,
+            const tmat::Matrix4f &worldToOther,
+            const float tolerance) const;
+
+    /**
+     * \brief
+     *     Finds the distance to the nearest triangle of a collider whose shape
+     *     is a TriangleMesh
+     */
+    bool getMeshDistance(
+            DistanceResult &result,
+            const Collider &mesh,
+            float maxDistance,
+            const float tolerance) const;
+
+    /* The triangles near a shape tested against a mesh, on each thread. */
+    static thread_local std::vector<uint32_t> meshTriangles_;
+
+    /**
+     * \brief Finds the overlap with a collider whose shape is a TriangleMesh
+     *
+     * \details
+     *     Each triangle near this collider is tested on its own, and the
+     *     deepest overlap is stored in out. This collider's shape must not be
+     *     a mesh.
+     */
+    bool getMeshOverlap(
+            tmat::Vector3f &out,
+            const Collider &mesh,
             const float tolerance) const;
 
+    /**
+     * \brief Works like raycast() for a collider whose shape is a TriangleMesh
+     */
+    bool raycastMesh(
+            RaycastHit &hit,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
+    /**
+     * \brief Works like sweep() for a collider whose shape is a TriangleMesh
+     */
+    bool sweepMesh(
+            RaycastHit &hit,
+            const Shape &shape,
+            const tmat::Matrix4f &shapeToWorld,
+            const tmat::Vector3f &direction,
+            float maxDistance,
+            const float tolerance) const;
+
+    typedef bool (Collider::*OverlapFunction)(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+
+    /*
+     * Overlap tests for pairs of shapes with a closed form answer, indexed by
+     * the types of this shape and the other shape. Pairs without one use GJK.
+     */
+    static OverlapFunction
+        overlapFunctions[Shape::TYPE_COUNT][Shape::TYPE_COUNT];
+
+    /**
+     * \brief Finds the overlap for a pair of shapes without GJK
+     *
+     * \details
+     *     Stores whether or not the shapes overlap in overlapping, and the
+     *     overlap in out using the same convention as getOverlap(). Returns
+     *     false if the shapes are transformed in a way the test can't handle,
+     *     such as a sphere scaled unevenly, or if the answer is degenerate.
+     *     GJK is used in that case.
+     */
+    bool overlapSphereSphere(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+    bool overlapSphereCapsule(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+    bool overlapSphereBox(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+    bool overlapCapsuleSphere(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+    bool overlapCapsuleCapsule(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+    bool overlapBoxSphere(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+    bool overlapBoxBox(
+            bool &overlapping,
+            tmat::Vector3f &out,
+            const Collider &other) const;
+
     void notifyCollisionObservers(
             Collision collision,
             std::vector<std::weak_ptr<Observer<Collision>>> &observers);
@@ -243,6 +578,11 @@ private:
      */
     void updateBox();
 
+    /**
+     * \brief Called after the collider becomes static or stops being static
+     */
+    void onStaticChanged();
+
     std::shared_ptr<Observable<Collision>> makeCollisionObservable(
             std::vector<std::weak_ptr<Observer<Collision>>> &observers);
 
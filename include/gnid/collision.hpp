@@ -5,6 +5,7 @@
 #include <memory>
 #include <functional>
 
+#include "gnid/contactmanifold.hpp"
 #include "gnid/matrix/matrix.hpp"
 
 namespace gnid
@@ -42,6 +43,15 @@ public:
      */
     const tmat::Vector3f &overlap() const { return overlap_; }
 
+    /**
+     * \brief The points where the two colliders touch
+     *
+     * \details
+     *     The manifold is kept for as long as the colliders keep colliding,
+     *     and its normal points from the first collider to the second.
+     */
+    const ContactManifold &manifold() const { return manifold_; }
+
     /**
      * \brief
      *     Swap colliders positions and calculate the overlap relative to the
@@ -59,11 +69,13 @@ public:
 private:
     std::array<std::shared_ptr<Collider>, 2> colliders_;
     mutable tmat::Vector3f overlap_;
+    mutable ContactManifold manifold_;
 
     /* Whether or not the collider has been visited this cycle. */
     mutable bool visited_;
 
     friend class Scene;
+    friend class ContactSolver;
 };
 
 } /* namespace */
@@ -1,10 +1,15 @@
 #ifndef COLLISIONPRUNER_HPP
 #define COLLISIONPRUNER_HPP
 
+#include <limits>
 #include <memory>
 #include <vector>
 
+#include "gnid/box.hpp"
 #include "gnid/collider.hpp"
+#include "gnid/matrix/matrix.hpp"
+#include "gnid/queryfilter.hpp"
+#include "gnid/raycasthit.hpp"
 
 namespace gnid
 {
@@ -43,6 +48,104 @@ public:
                 std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
             > &list) const = 0;
 
+    /**
+     * \brief List all of the nodes being pruned and add them to the list
+     */
+    virtual void listAllNodes(
+            std::vector<std::shared_ptr<Collider>> &list) const = 0;
+
+    /**
+     * \brief Find the nearest collider hit by the ray
+     *
+     * \details
+     *     Returns true if a collider is hit within maxDistance, in which case
+     *     the hit is stored in hit. The direction does not need to be
+     *     normalized. The default implementation tests the bounding box of
+     *     every collider, so pruners should override it with a faster search
+     *     where they can.
+     */
+    virtual bool raycast(
+            RaycastHit &hit,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
+    /**
+     * \brief
+     *     Find the nearest collider hit by the shape as it moves from one
+     *     transform to another
+     *
+     * \details
+     *     Works like raycast(). The shape only moves by the difference between
+     *     the translations of the two transforms and keeps the rotation of
+     *     from. The distance of the hit is measured in world units along that
+     *     path.
+     */
+    virtual bool sweep(
+            RaycastHit &hit,
+            const Shape &shape,
+            const tmat::Matrix4f &from,
+            const tmat::Matrix4f &to) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes overlap the box
+     *
+     * \details
+     *     The colliders accepted by the filter are added to the list, which
+     *     **will not** be cleared. The k-d tree, BVH and hash grid pruners
+     *     search without allocating, so reusing the same list keeps their
+     *     queries from allocating. The default implementation lists every
+     *     collider into a temporary list and checks each of them.
+     */
+    virtual void queryBox(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const Box &box,
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes overlap the sphere
+     *
+     * \details
+     *     Works like queryBox().
+     */
+    virtual void querySphere(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const tmat::Vector3f &center,
+            float radius,
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes are nearest the point
+     *
+     * \details
+     *     The list is cleared and filled with at most count colliders accepted
+     *     by the filter, along with their distance from the point, nearest
+     *     first. Colliders further than maxDistance are not listed. If the
+     *     list already has room for count colliders, the searches of the k-d
+     *     tree, BVH and hash grid pruners do not allocate. The default
+     *     implementation lists every collider into a temporary list.
+     */
+    virtual void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            const tmat::Vector3f &point,
+            size_t count,
+            float maxDistance = std::numeric_limits<float>::infinity(),
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Add the collider to a list sorted nearest first
+     *
+     * \details
+     *     The list is kept to at most count colliders by dropping the furthest
+     *     one. This is used by queryNearest(), and can be used by the trees
+     *     that pruners search.
+     */
+    static void insertNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            size_t count,
+            float distance,
+            const std::shared_ptr<Collider> &collider);
+
     /**
      * \brief Adds the given node to be pruned
      */
@@ -61,6 +164,51 @@ public:
      *     world matrices.
      */
     virtual void update() = 0;
+
+    /**
+     * \brief Called when the bounding box of a static collider changes
+     *
+     * \details
+     *     Static colliders are not expected to move, so pruners may stop
+     *     checking them for changes. The scene calls this function before
+     *     update() for each static collider that moved, or was just added.
+     */
+    virtual void staticColliderMoved(std::shared_ptr<Collider>) {}
+
+    /**
+     * \brief
+     *     Lists the pairs that started and stopped overlapping during the last
+     *     call to update()
+     *
+     * \details
+     *     Neither list will be cleared. Pruners that do not keep track of
+     *     their pairs between updates return false and leave the lists
+     *     untouched, which is the default behavior. A pair that is not in
+     *     either list and was listed by the previous update is still
+     *     overlapping.
+     */
+    virtual bool listPairChanges(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &,
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &) const
+    {
+        return false;
+    }
+
+protected:
+    /**
+     * \brief
+     *     Calculates the unit direction and distance a sweep moves the shape
+     *     from one transform to the other
+     */
+    static void sweepPath(
+            tmat::Vector3f &direction,
+            float &distance,
+            const tmat::Matrix4f &from,
+            const tmat::Matrix4f &to);
 };
 
 } /* namespace */
@@ -0,0 +1,133 @@
+#ifndef CONTACTMANIFOLD_HPP
+#define CONTACTMANIFOLD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gnid/matrix/matrix.hpp"
+
+namespace gnid
+{
+
+class Collider;
+
+/**
+ * \brief A point where two colliders touch
+ */
+class ContactPoint
+{
+public:
+    /* The point on each collider, in the space of that collider. */
+    tmat::Vector3f localPoints[2];
+
+    /* The point on each collider in world space. */
+    tmat::Vector3f points[2];
+
+    /* How far the colliders overlap at the point along the normal. */
+    float depth;
+
+    /*
+     * Identifies the corners of the shapes that made the point, so that the
+     * point can be found again on the next frame.
+     */
+    uint64_t feature;
+
+    /* The number of frames the point has been kept for. */
+    int lifetime;
+
+    /*
+     * The impulses applied at the point by the solver, kept so the next
+     * frame can start from them. The impulse along the normal is applied to
+     * the second collider, and the opposite to the first. The friction
+     * impulse is applied the same way.
+     */
+    float normalImpulse;
+    tmat::Vector3f frictionImpulse;
+};
+
+/**
+ * \brief The points where two colliders touch, kept from frame to frame
+ *
+ * \details
+ *     Each frame the points already in the manifold are moved along with the
+ *     colliders, and the ones that have drifted apart are removed. New points
+ *     are then found from the overlap and either replace the points they
+ *     match or are added. The manifold holds at most four points, keeping the
+ *     deepest one and those spread out the most.
+ *
+ *     The first collider is the one the normal points away from.
+ */
+class ContactManifold
+{
+public:
+    static const size_t MAX_POINTS = 4;
+
+    /*
+     * How far a point can move away from the other collider, or along its
+     * surface, before it is removed.
+     */
+    static constexpr float BREAKING_DISTANCE = 0.02f;
+
+    ContactManifold() : size_(0), normal_(tmat::Vector3f::zero) {}
+
+    /**
+     * \brief Returns the world space normal from the first collider
+     */
+    const tmat::Vector3f &normal() const { return normal_; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const ContactPoint &operator[](size_t i) const { return points_[i]; }
+    ContactPoint &operator[](size_t i) { return points_[i]; }
+    const ContactPoint *begin() const { return points_; }
+    const ContactPoint *end() const { return points_ + size_; }
+
+    /**
+     * \brief Update the manifold from the overlap found this frame
+     *
+     * \details
+     *     The overlap points from a to b, as found by Collider::getOverlap().
+     *     If it is zero, the points are only refreshed.
+     */
+    void update(
+            const Collider &a,
+            const Collider &b,
+            const tmat::Vector3f &overlap);
+
+    /**
+     * \brief Move the points along with the colliders
+     *
+     * \details
+     *     The depth of each point is found again, and points which have moved
+     *     more than BREAKING_DISTANCE apart are removed.
+     */
+    void refresh(const Collider &a, const Collider &b);
+
+    /**
+     * \brief Swap the colliders the points belong to
+     */
+    void swapColliders();
+
+    void clear() { size_ = 0; }
+
+private:
+    ContactPoint points_[MAX_POINTS];
+    size_t size_;
+    tmat::Vector3f normal_;
+
+    /**
+     * \brief Replace the point it matches, or add it
+     *
+     * \details
+     *     If the manifold is full, the point left out is the one that keeps
+     *     the rest spread out the most.
+     */
+    void add(const ContactPoint &point);
+
+    void remove(size_t i);
+};
+
+} /* namespace */
+
+#endif
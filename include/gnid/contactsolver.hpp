@@ -0,0 +1,165 @@
+#ifndef CONTACTSOLVER_HPP
+#define CONTACTSOLVER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "gnid/collision.hpp"
+#include "gnid/contactmanifold.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+namespace gnid
+{
+
+class Rigidbody;
+
+/**
+ * \brief Resolves the contacts between rigid bodies using sequential impulses
+ *
+ * \details
+ *     Every contact point of every collision is a constraint that keeps the
+ *     bodies from moving into each other, with friction limited by the
+ *     impulse along the normal. The constraints are solved together, one at
+ *     a time, for a number of iterations. Each point keeps its impulses in
+ *     its ContactManifold, and the next solve starts from them, so that
+ *     resting contacts settle within a few frames.
+ *
+ *     Overlaps are corrected either by asking the bodies to move apart a
+ *     little faster (Baumgarte stabilization), or by moving them apart
+ *     directly without changing their velocities (split impulses).
+ *
+ *     Rigid bodies only move and do not rotate, so the impulses only change
+ *     their velocities.
+ */
+class ContactSolver
+{
+public:
+    /**
+     * \brief The number of times the velocity constraints are solved
+     */
+    int &velocityIterations() { return velocityIterations_; }
+
+    /**
+     * \brief The number of times the overlaps are solved with split impulses
+     */
+    int &positionIterations() { return positionIterations_; }
+
+    /**
+     * \brief
+     *     The fraction of the overlap beyond allowedPenetration() corrected
+     *     in each update
+     */
+    float &correctionFactor() { return correctionFactor_; }
+
+    /**
+     * \brief How far colliders may overlap before they are pushed apart
+     *
+     * \details
+     *     Allowing a small overlap keeps resting contacts from jittering.
+     */
+    float &allowedPenetration() { return allowedPenetration_; }
+
+    /**
+     * \brief Whether overlaps are corrected with split impulses
+     *
+     * \details
+     *     If true, overlapping bodies are moved apart directly, which does not
+     *     add any energy. Otherwise, which is the default, their velocities
+     *     are changed to move them apart, so nothing is moved after the
+     *     collisions are found.
+     */
+    bool &splitImpulse() { return splitImpulse_; }
+
+    /**
+     * \brief The slowest colliders can hit each other and still bounce
+     */
+    float &restitutionThreshold() { return restitutionThreshold_; }
+
+    /**
+     * \brief Solve the contacts of the collisions
+     *
+     * \details
+     *     Only awake rigid bodies are moved by the contacts, and everything
+     *     else is treated as if it can't move. The rigid bodies moved by
+     *     split impulses are added to movedBodies.
+     *
+     *     The contacts are solved in the order of the collisions, so the
+     *     same collisions in the same order always give the same result.
+     *     Nothing is solved if dt is not positive, since the overlaps can't
+     *     be corrected in no time.
+     */
+    void solve(
+            const std::vector<const Collision *> &collisions,
+            float dt,
+            std::unordered_set<std::shared_ptr<Rigidbody>> &movedBodies);
+
+private:
+    /**
+     * \brief A contact point between two bodies
+     *
+     * \details
+     *     The bodies are indices into the body arrays, where a body that can't
+     *     move has an inverse mass of zero.
+     */
+    class Constraint
+    {
+    public:
+        size_t bodies[2];
+        ContactPoint *point;
+        tmat::Vector3f normal;
+        float friction;
+
+        /* The normal velocity the solver aims for. */
+        float velocityBias;
+
+        /* The normal velocity split impulses aim for. */
+        float positionBias;
+
+        /* One over the sum of the inverse masses. */
+        float mass;
+
+        float positionImpulse;
+    };
+
+    int velocityIterations_ = 10;
+    int positionIterations_ = 4;
+    float correctionFactor_ = 0.2f;
+    float allowedPenetration_ = 0.01f;
+    bool splitImpulse_ = false;
+    float restitutionThreshold_ = 1.0f;
+
+    std::vector<Constraint> constraints_;
+
+    /* The points of collisions that have an overlap but no manifold. */
+    std::vector<ContactPoint> extraPoints_;
+
+    /*
+     * The bodies touched by the contacts. The first body is the one that
+     * can't move, which everything that is not an awake rigid body shares.
+     */
+    std::vector<std::shared_ptr<Rigidbody>> bodies_;
+    std::vector<float> inverseMasses_;
+    std::vector<tmat::Vector3f> velocities_;
+    std::vector<tmat::Vector3f> positionVelocities_;
+    std::unordered_map<Rigidbody *, size_t> bodyIndices_;
+
+    /**
+     * \brief Returns the index of the body a collider moves with
+     */
+    size_t bodyOf(const std::shared_ptr<Collider> &collider);
+
+    /**
+     * \brief Apply an impulse to the second body and the opposite to the first
+     */
+    void applyImpulse(
+            const Constraint &constraint,
+            const tmat::Vector3f &impulse,
+            std::vector<tmat::Vector3f> &velocities);
+};
+
+} /* namespace */
+
+#endif
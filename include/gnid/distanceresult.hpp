@@ -0,0 +1,54 @@
+#ifndef DISTANCERESULT_HPP
+#define DISTANCERESULT_HPP
+
+#include "gnid/matrix/matrix.hpp"
+
+namespace gnid
+{
+
+/**
+ * \brief The result of finding the distance between two colliders
+ */
+class DistanceResult
+{
+public:
+    /**
+     * \brief The distance between the colliders, or zero if they overlap
+     */
+    float distance = 0;
+
+    /**
+     * \brief The world space point on each collider closest to the other one
+     *
+     * \details
+     *     The points are only meaningful if the colliders are apart.
+     */
+    tmat::Vector3f points[2];
+
+    /**
+     * \brief The world space unit normal from the first collider to the second
+     *
+     * \details
+     *     The normal is zero if the colliders overlap.
+     */
+    tmat::Vector3f normal;
+
+    /**
+     * \brief
+     *     The points of the Minkowski difference, first minus second, that the
+     *     closest point to the origin lies on
+     *
+     * \details
+     *     If the colliders overlap, these are the points around the origin.
+     */
+    tmat::Vector3f simplex[4];
+
+    /**
+     * \brief The number of points in the simplex
+     */
+    int simplexSize = 0;
+};
+
+} /* namespace */
+
+#endif
@@ -7,6 +7,8 @@
 #include <memory>
 #include <string>
 
+#include "gnid/stepaccumulator.hpp"
+
 /**
  * \brief The gnidEngine namespace
  */
@@ -143,9 +145,45 @@ public:
 
     /**
      * \brief Perform one iteration of the game loop
+     *
+     * \details
+     *     If fixedTimestep() is zero, the scene is updated once by the time
+     *     since the last tick. Otherwise the elapsed time is added to an
+     *     accumulator, and the scene is updated by fixedTimestep() for as
+     *     long as the accumulator holds a whole step, at most maxSubsteps()
+     *     times. The scene is then rendered interpolationAlpha() of the way
+     *     between the last two updates.
      */
     void tick();
 
+    /**
+     * \brief The time the scene is updated by in each step, in seconds
+     *
+     * \details
+     *     Zero, which is the default, updates the scene once a tick by the
+     *     time since the last tick.
+     */
+    float &fixedTimestep();
+
+    /**
+     * \brief The most fixed steps the scene is updated by in a single tick
+     *
+     * \details
+     *     If the game falls further behind than this, for example because of
+     *     a hitch, the time that could not be simulated is dropped instead of
+     *     making the next ticks even slower. The default is 5.
+     */
+    int &maxSubsteps();
+
+    /**
+     * \brief How far the time left in the accumulator is into the next step
+     *
+     * \details
+     *     The value is between zero and one, and is one if fixedTimestep() is
+     *     zero.
+     */
+    float interpolationAlpha() const;
+
     GLFWwindow *window();
 
 private:
@@ -158,6 +196,8 @@ private:
 
     double time_;
 
+    StepAccumulator steps_;
+
     static void keyCallback(
             GLFWwindow* window,
             int key,
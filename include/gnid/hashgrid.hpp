@@ -0,0 +1,192 @@
+#ifndef HASHGRID_HPP
+#define HASHGRID_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "gnid/collisionpruner.hpp"
+
+namespace gnid
+{
+
+/* Forward declarations. */
+class Collider;
+
+/**
+ * \brief A collision pruner using a uniform hashed grid
+ *
+ * \details
+ *     Space is divided into cubic cells of a fixed size, and each collider is
+ *     added to every cell its bounding box touches. Only cells that contain
+ *     colliders are stored, so the grid can cover very large worlds. Colliders
+ *     are only moved between cells when their moved() flag is set.
+ *
+ *     The grid works best when most colliders are about the size of a cell.
+ *     Colliders that would touch more than maxCellsPerCollider() cells, such
+ *     as the ground, are kept in a separate list and checked against every
+ *     other collider instead.
+ */
+class HashGridPruner : public CollisionPruner
+{
+public:
+    /**
+     * \brief Create an empty grid
+     *
+     * \param cellSize The width of each cell
+     * \param maxCellsPerCollider
+     *     The maximum number of cells a collider may be added to before it is
+     *     treated as a large collider
+     */
+    HashGridPruner(float cellSize = 4.0f, unsigned int maxCellsPerCollider = 64);
+
+    void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list) const override;
+
+    void listAllNodes(
+            std::vector<std::shared_ptr<Collider>> &list) const override;
+
+    void add(std::shared_ptr<Collider> collider) override;
+    void remove(std::shared_ptr<Collider> collider) override;
+
+    /**
+     * \brief Move the colliders that moved since the last update between cells
+     */
+    void update() override;
+
+    /**
+     * \brief Find the colliders whose bounding boxes overlap the box
+     *
+     * \details
+     *     Small boxes only visit the cells they touch, while boxes touching
+     *     more cells than there are colliders check every collider instead.
+     *     The search does not allocate.
+     */
+    void queryBox(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const Box &box,
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    void querySphere(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const tmat::Vector3f &center,
+            float radius,
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    /**
+     * \brief Find the colliders whose bounding boxes are nearest the point
+     *
+     * \details
+     *     Checks every collider, without allocating.
+     */
+    void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            const tmat::Vector3f &point,
+            size_t count,
+            float maxDistance = std::numeric_limits<float>::infinity(),
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    /**
+     * \brief Returns the width of each cell
+     */
+    const float &cellSize() const { return cellSize_; }
+
+    /**
+     * \brief
+     *     Returns the maximum number of cells a collider may be added to before
+     *     it is treated as a large collider
+     */
+    const unsigned int &maxCellsPerCollider() const
+    {
+        return maxCellsPerCollider_;
+    }
+
+    /**
+     * \brief Returns the number of cells containing at least one collider
+     */
+    size_t cellCount() const { return cells_.size(); }
+
+private:
+    /**
+     * \brief A collider tracked by the grid
+     */
+    class Proxy
+    {
+    public:
+        std::shared_ptr<Collider> collider;
+        float min[3];
+        float max[3];
+
+        /* The range of cells the collider was added to, inclusive. */
+        int cellMin[3];
+        int cellMax[3];
+
+        bool isStatic;
+        bool inUse;
+
+        /* True if the collider is in the cells or the large list. */
+        bool binned;
+        bool isLarge;
+
+        /* True if the cells must be updated even if the collider didn't move. */
+        bool dirty;
+    };
+
+    /**
+     * \brief A cell containing at least one collider
+     */
+    class Cell
+    {
+    public:
+        uint64_t key;
+        int coord[3];
+        std::vector<uint32_t> proxies;
+    };
+
+    const float cellSize_;
+    const unsigned int maxCellsPerCollider_;
+
+    std::vector<Proxy> proxies_;
+    std::vector<uint32_t> freeProxies_;
+    std::unordered_map<const Collider *, uint32_t> proxyIndices_;
+
+    /* The cells are kept packed together so that they are quick to visit. */
+    std::vector<Cell> cells_;
+    std::unordered_map<uint64_t, uint32_t> cellIndices_;
+    std::vector<uint32_t> largeProxies_;
+
+    static uint64_t cellKey(int x, int y, int z);
+    int cellCoord(float value) const;
+
+    /**
+     * \brief Add the proxy to its cells, or to the large list
+     */
+    void bin(uint32_t index);
+
+    /**
+     * \brief Remove the proxy from its cells, or from the large list
+     */
+    void unbin(uint32_t index);
+
+    bool overlaps(const Proxy &first, const Proxy &second) const;
+
+    /**
+     * \brief
+     *     Add the colliders whose bounds are within the radius of the query
+     *     bounds
+     */
+    void query(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const float *min,
+            const float *max,
+            float radiusSquared,
+            const QueryFilter &filter) const;
+};
+
+} /* namespace */
+
+#endif
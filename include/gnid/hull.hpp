@@ -1,6 +1,8 @@
 #ifndef HULL_HPP
 #define HULL_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <cassert>
 
@@ -12,20 +14,58 @@ namespace gnid
 
 /**
  * \brief A convex hull shape made of a polyhedron
- *
- * \todo
- *      - Implement faster algorithm, currently just does a simple O(n) search
- *        on the points.
  */
 class Hull : public Shape
 {
 public:
-    Hull(const std::vector<tmat::Vector3f> &points);
+    /**
+     * \brief Create a hull from the given points
+     *
+     * \details
+     *     Only the points on the corners of the hull are kept, since the
+     *     others can never be support points. If the points are flat, all of
+     *     them are kept.
+     *
+     *     If findEdges is true and the hull has enough corners, its edges are
+     *     found so that support() can climb along them from the corner it
+     *     last returned instead of checking every point. Otherwise, or if the
+     *     points are flat, support() checks every point.
+     */
+    Hull(const std::vector<tmat::Vector3f> &points, bool findEdges = true);
 
     tmat::Vector3f support(const tmat::Vector3f &d) const override;
+    ShapeType type() const override { return HULL; }
+
+    /**
+     * \brief Returns true if support() climbs along the edges of the hull
+     */
+    bool climbs() const { return !neighbors_.empty(); }
+
+    /**
+     * \brief Returns the points kept from the ones the hull was created from
+     */
+    const std::vector<tmat::Vector3f> &points() const { return points_; }
 
 private:
-    const std::vector<tmat::Vector3f> points_;
+    /* Hulls with fewer corners than this check every point. */
+    static const size_t MIN_CLIMBING_VERTICES = 32;
+
+    std::vector<tmat::Vector3f> points_;
+
+    /*
+     * The corners joined to point i by an edge are the neighbors_ from
+     * neighborOffsets_[i] up to neighborOffsets_[i + 1].
+     */
+    std::vector<uint32_t> neighborOffsets_;
+    std::vector<uint32_t> neighbors_;
+
+    /*
+     * The corner the last climb ended on for directions in each octant, so
+     * that colliders sharing the hull don't undo each other's progress when
+     * GJK asks for opposite directions. Any corner is a correct place to
+     * start from, so threads sharing the hull only need them to be atomic.
+     */
+    mutable std::atomic<uint32_t> starts_[8];
 };
 
 } /* namespace */
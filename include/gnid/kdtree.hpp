@@ -1,8 +1,10 @@
 #ifndef KDTREE_HPP
 #define KDTREE_HPP
 
+#include <cstdint>
+#include <limits>
 #include <memory>
-#include <stack>
+#include <unordered_map>
 #include <vector>
 
 #include "gnid/collisionpruner.hpp"
@@ -13,16 +15,33 @@ namespace gnid
 /* Forward declarations. */
 class Node;
 class Collider;
+class ThreadPool;
 
 /**
  * \brief A k-D tree for partitioning nodes in space
+ *
+ * \details
+ *     The nodes of the tree are stored in a single array, and refer to their
+ *     children and parent by index. The colliders of each leaf are stored as a
+ *     range of one shared item array. When the tree is generated, nodes and
+ *     items are laid out in depth first order so that traversing the tree
+ *     mostly reads memory in order.
+ *
+ *     Regenerating part of the tree appends the new nodes to the end of the
+ *     array, leaving the old ones unused. Once there are more unused nodes or
+ *     items than used ones, update() packs the arrays back into depth first
+ *     order.
  */
 class KdTree
 {
 public:
-    KdTree();
-    KdTree(const KdTree &other);
-    KdTree(KdTree &&other);
+    /**
+     * \brief Create an empty tree
+     *
+     * \param maxNodesPerLeaf
+     *     The maximum number of colliders allowed in each leaf node
+     */
+    KdTree(unsigned int maxNodesPerLeaf = 1);
 
     /**
      * \brief Return the bounding box for the KdTree node
@@ -47,6 +66,17 @@ public:
      */
     void add(std::shared_ptr<Collider> collider);
 
+    /**
+     * \brief Remove a collider from the KdTree
+     *
+     * \details
+     *     The leaf holding the collider is found directly, so this takes time
+     *     proportional to the depth of the tree. If the leaf becomes empty, it
+     *     is collapsed into its sibling. Returns false if the collider is not in
+     *     the tree.
+     */
+    bool remove(std::shared_ptr<Collider> collider);
+
     /**
      * \brief Clear all nodes from the tree
      */
@@ -62,11 +92,127 @@ public:
                 std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
             > &list) const;
 
+    /**
+     * \brief
+     *     List the pairs of nodes from this tree and the other tree whose
+     *     bounding boxes overlap and store them in the list
+     *
+     * \details
+     *     The first collider of each pair is from this tree. Pairs within
+     *     either tree are not listed.
+     */
+    void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list,
+            const KdTree &other) const;
+
+    /**
+     * \brief
+     *     List the nodes whose bounding boxes overlap using the threads of the
+     *     given pool
+     *
+     * \details
+     *     The traversal is split into independent pairs of subtrees, which are
+     *     searched in parallel. The same pairs are listed in the same order
+     *     regardless of the number of threads in the pool.
+     */
+    void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list,
+            ThreadPool &threadPool) const;
+
+    /**
+     * \brief
+     *     List the overlapping pairs between this tree and the other tree using
+     *     the threads of the given pool
+     */
+    void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list,
+            const KdTree &other,
+            ThreadPool &threadPool) const;
+
     /**
      * \brief List all of the nodes in the tree and add them to the list
      */
     void listAllNodes(std::vector<std::shared_ptr<Collider>> &list) const;
 
+    /**
+     * \brief Find the nearest collider hit by the ray
+     *
+     * \details
+     *     The tree is searched from front to back, skipping nodes further away
+     *     than the nearest hit found so far. Returns true if a collider is hit
+     *     within maxDistance, in which case the hit is stored in hit. The
+     *     direction must be normalized.
+     */
+    bool raycast(
+            RaycastHit &hit,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
+    /**
+     * \brief
+     *     Find the nearest collider hit by the shape moving along the given
+     *     direction
+     *
+     * \details
+     *     Works like raycast(), where the ray is the shape transformed by
+     *     shapeToWorld.
+     */
+    bool sweep(
+            RaycastHit &hit,
+            const Shape &shape,
+            const tmat::Matrix4f &shapeToWorld,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes overlap the box
+     *
+     * \details
+     *     The colliders accepted by the filter are added to the list, which
+     *     **will not** be cleared. The search does not allocate.
+     */
+    void queryBox(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const Box &box,
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes overlap the sphere
+     *
+     * \details
+     *     Works like queryBox().
+     */
+    void querySphere(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const tmat::Vector3f &center,
+            float radius,
+            const QueryFilter &filter = QueryFilter()) const;
+
+    /**
+     * \brief Find the colliders whose bounding boxes are nearest the point
+     *
+     * \details
+     *     The list **will not** be cleared. It must already be sorted nearest
+     *     first, and nearer colliders from this tree are inserted into it
+     *     using CollisionPruner::insertNearest(). This way, the nearest
+     *     colliders of several trees can be found by passing the same list to
+     *     each of them. Subtrees further than the furthest listed collider are
+     *     skipped once the list is full.
+     */
+    void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            const tmat::Vector3f &point,
+            size_t count,
+            float maxDistance = std::numeric_limits<float>::infinity(),
+            const QueryFilter &filter = QueryFilter()) const;
+
     /**
      * \brief Regenerate the tree
      */
@@ -98,53 +244,260 @@ public:
     void print(int indent = 0);
 
 private:
+    /* The index used for a missing node. */
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    /* The index of the root node. */
+    static constexpr uint32_t ROOT = 0;
+
+    /**
+     * \brief A node of the tree
+     */
+    class Node
+    {
+    public:
+        float min[3];
+        float max[3];
+        float median;
+        uint32_t axisIndex;
+
+        uint32_t parent;
+        uint32_t left;
+        uint32_t right;
+
+        /* The range of items for a leaf node. */
+        uint32_t first;
+        uint32_t count;
+
+        /* The total number of colliders in the subtree. */
+        uint32_t total;
+
+        bool hasNonStaticNodes;
+
+        /* True if the bounds must be recalculated on the next update. */
+        bool dirty;
+
+        bool isLeaf() const { return left == NONE; }
+    };
+
+    /**
+     * \brief A collider in the tree
+     */
+    class Slot
+    {
+    public:
+        /* A copy of the collider's bounding box. */
+        float min[3];
+        float max[3];
+
+        uint32_t leaf;
+        uint32_t position;  /* The index of the slot in the items. */
+        bool isStatic;
+    };
+
     const unsigned int maxNodesPerLeaf_;
-    unsigned int axisIndex;
-    float median;
     float maxShift_;
-    unsigned int totalNodes;    /* The total number of nodes in the tree. */
-    bool needsUpdate_;
-    bool hasNonStaticNodes_;
 
-    mutable bool visited_;
+    std::vector<Node> nodes_;
+
+    /* The slot indices of each leaf's colliders. */
+    std::vector<uint32_t> items_;
+
+    /* The colliders and slots share the same indices. */
+    std::vector<std::shared_ptr<Collider>> colliders_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+    std::unordered_map<const Collider *, uint32_t> slotIndices_;
+
+    /* The number of nodes and items no longer used by the tree. */
+    size_t garbageNodes_;
+    size_t garbageItems_;
+
+    /* Slot indices used while generating the tree. */
+    std::vector<uint32_t> scratch_;
 
-    std::vector<std::shared_ptr<Collider>> nodes;
     Box box_;
-    std::unique_ptr<KdTree> left, right;
 
+    bool update(uint32_t index);
+
+    /**
+     * \brief
+     *     List the overlapping pairs between the given nodes of the given
+     *     trees
+     *
+     * \details
+     *     If the trees and nodes are the same, the pairs within the node are
+     *     listed.
+     */
     static void listOverlappingNodes(
             std::vector<
                 std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
             > &list,
-            const KdTree &first,
-            const KdTree &second);
+            const KdTree &firstTree,
+            const KdTree &secondTree,
+            uint32_t first,
+            uint32_t second);
+
+    static void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list,
+            const KdTree &firstTree,
+            const KdTree &secondTree,
+            ThreadPool &threadPool);
 
     /**
-     * \brief clearVisited() should be called before calling this function
+     * \brief Check a pair of nodes from the given trees
+     *
+     * \details
+     *     Pairs of leaf nodes have their overlapping colliders added to the
+     *     list. Otherwise the pairs of child nodes that need to be checked are
+     *     pushed onto the stack.
      */
-    void listOverlappingNodesRecursive(
+    static void visitPair(
             std::vector<
                 std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
-            > &list) const;
+            > &list,
+            const KdTree &firstTree,
+            const KdTree &secondTree,
+            uint32_t a,
+            uint32_t b,
+            std::vector<std::pair<uint32_t, uint32_t>> &stack);
+
+    /**
+     * \brief Find the nearest collider under the given node hit by a moving box
+     *
+     * \details
+     *     The box starts at boxMin and boxMax and moves along the direction.
+     *     Colliders whose bounds the box passes through are checked with the
+     *     given test, which is passed the maximum distance for the hit. The
+     *     nearer child of each node is visited first, and maxDistance shrinks
+     *     to each hit found so that further nodes are skipped.
+     */
+    template<typename Test>
+    bool cast(
+            RaycastHit &hit,
+            uint32_t index,
+            const float *boxMin,
+            const float *boxMax,
+            const tmat::Vector3f &direction,
+            float &maxDistance,
+            const Test &test) const;
 
-    void generate();
-    
     /**
-     * \brief Clear the visited flag for all nodes in the tree.
+     * \brief
+     *     Add the colliders under the given node whose bounds are within the
+     *     radius of the query bounds
      */
-    void clearVisited() const;
+    void query(
+            std::vector<std::shared_ptr<Collider>> &list,
+            uint32_t index,
+            const float *min,
+            const float *max,
+            float radiusSquared,
+            const QueryFilter &filter) const;
+
+    /**
+     * \brief Insert the colliders under the given node nearest the point
+     */
+    void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            uint32_t index,
+            const float *point,
+            size_t count,
+            float maxDistance,
+            const QueryFilter &filter) const;
+
+    /**
+     * \brief Copy the bounding box of the collider into its slot
+     */
+    void copyBounds(uint32_t slot);
+
+    /**
+     * \brief Recalculate the bounds of the node from its children or items
+     */
+    void refit(uint32_t index);
+
+    /**
+     * \brief Recalculate the bounds from the given node up to the root
+     */
+    void refitAncestors(uint32_t index);
+
+    /**
+     * \brief Replace the node with its child that is not the given child
+     */
+    void collapse(uint32_t index, uint32_t emptyChild);
+
+    /**
+     * \brief Regenerate the subtree at the given index
+     */
+    void regenerate(uint32_t index);
+
+    /**
+     * \brief
+     *     Generate the subtree at the given index from the slots in the given
+     *     range of the scratch list
+     */
+    void generate(uint32_t index, uint32_t begin, uint32_t end);
+
+    /**
+     * \brief Add the slots in the subtree to the scratch list
+     */
+    void listSlots(uint32_t index);
+
+    /**
+     * \brief Count the nodes in the subtree
+     */
+    size_t countNodes(uint32_t index) const;
+
+    /**
+     * \brief Pack the nodes and items into depth first order
+     */
+    void compact();
+
+    uint32_t compact(
+            uint32_t index,
+            uint32_t parent,
+            std::vector<Node> &nodes,
+            std::vector<uint32_t> &items);
+
+    /**
+     * \brief Set the box of the tree from the bounds of the root node
+     */
+    void updateBox();
+
+    int depth(uint32_t index) const;
+    void print(uint32_t index, int indent) const;
 };
 
 /**
- * \brief A collision pruner based on a k-D tree
+ * \brief A collision pruner based on k-D trees
+ *
+ * \details
+ *     Static colliders are kept in their own tree, separate from the colliders
+ *     that can move. The static tree is only updated after static colliders
+ *     are added, removed or moved, so level geometry is not touched once it is
+ *     loaded. Pairs are found within the dynamic tree and between the dynamic
+ *     and static trees, so static colliders are never checked against each
+ *     other.
+ *
+ *     Colliders are placed in a tree by isStatic() when they are added. The
+ *     scene re-adds colliders whose static state changes.
  */
 class KdTreePruner : public CollisionPruner
 {
 public:
     /**
-     * \brief Create the pruner from the given k-D tree
+     * \brief Create the pruner from the given k-D trees
+     *
+     * \param kdTree The tree for the colliders that can move
+     * \param staticTree
+     *     The tree for the static colliders. If null, a tree with the same
+     *     leaf size as the dynamic tree is created.
      */
-    KdTreePruner(std::shared_ptr<KdTree> kdTree);
+    KdTreePruner(
+            std::shared_ptr<KdTree> kdTree,
+            std::shared_ptr<KdTree> staticTree = nullptr);
 
     void listOverlappingNodes(
             std::vector<
@@ -155,15 +508,80 @@ public:
     void remove(std::shared_ptr<Collider>) override;
 
     /**
-     * \brief Update the k-D tree
+     * \brief Update the k-D trees
      * 
      * \details
-     *     This function should not be called if the k-D tree is updated from
+     *     This function should not be called if the k-D trees are updated from
      *     another source, for example using the KdTree.update() function.
      */
     void update() override;
+
+    void staticColliderMoved(std::shared_ptr<Collider> collider) override;
+
+    void listAllNodes(
+            std::vector<std::shared_ptr<Collider>> &list) const override;
+
+    /**
+     * \brief Find the nearest collider hit by the ray in either tree
+     */
+    bool raycast(
+            RaycastHit &hit,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const override;
+
+    /**
+     * \brief Find the nearest collider hit by the moving shape in either tree
+     */
+    bool sweep(
+            RaycastHit &hit,
+            const Shape &shape,
+            const tmat::Matrix4f &from,
+            const tmat::Matrix4f &to) const override;
+
+    void queryBox(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const Box &box,
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    void querySphere(
+            std::vector<std::shared_ptr<Collider>> &list,
+            const tmat::Vector3f &center,
+            float radius,
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    void queryNearest(
+            std::vector<std::pair<float, std::shared_ptr<Collider>>> &list,
+            const tmat::Vector3f &point,
+            size_t count,
+            float maxDistance = std::numeric_limits<float>::infinity(),
+            const QueryFilter &filter = QueryFilter()) const override;
+
+    /**
+     * \brief Returns the tree for the colliders that can move
+     */
+    const std::shared_ptr<KdTree> &kdTree() const { return kdTree_; }
+
+    /**
+     * \brief Returns the tree for the static colliders
+     */
+    const std::shared_ptr<KdTree> &staticTree() const { return staticTree_; }
+
+    /**
+     * \brief The thread pool used to find the pairs
+     *
+     * \details
+     *     If the pool is null, which is the default, the pairs are found on the
+     *     calling thread.
+     */
+    std::shared_ptr<ThreadPool> &threadPool() { return threadPool_; }
 private:
     const std::shared_ptr<KdTree> kdTree_;
+    const std::shared_ptr<KdTree> staticTree_;
+    std::shared_ptr<ThreadPool> threadPool_;
+
+    /* True if the static tree must be updated. */
+    bool staticTreeChanged_;
 };
 
 } /* namespace */
@@ -21,6 +21,7 @@ public:
     ModelBuilder &fromObj(const std::string &path);
     ModelBuilder &loadMesh(bool loadMesh = true);
     ModelBuilder &loadPhysics(bool loadPhysics = false);
+    ModelBuilder &physicsMode(ObjParser::PhysicsMode mode);
     ModelBuilder &materials(
             const std::unordered_map<std::string, std::shared_ptr<Material>>
             &materials);
@@ -40,6 +41,7 @@ private:
     std::shared_ptr<MaterialMapping> materialsPtr_;
     bool loadMesh_ = false;
     bool loadPhysics_ = false;
+    ObjParser::PhysicsMode physicsMode_ = ObjParser::TRIANGLES;
     std::unique_ptr<ObjParser> objParser_;
     std::ifstream stream_;
     tmat::Matrix4f transform_ = tmat::Matrix4f::identity;
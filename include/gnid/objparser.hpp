@@ -16,6 +16,7 @@
 #include "gnid/emptynode.hpp"
 #include "gnid/collider.hpp"
 #include "gnid/hull.hpp"
+#include "gnid/trianglemesh.hpp"
 #include "gnid/node.hpp"
 #include "gnid/matrix/matrix.hpp"
 
@@ -29,6 +30,21 @@ namespace gnid
 class ObjParser
 {
 public:
+    /**
+     * \brief How buildPhysicsNode() turns the parsed data into colliders
+     */
+    typedef enum
+    {
+        /* A collider for every triangle. */
+        TRIANGLES,
+
+        /* A collider for the convex hull of every object or group. */
+        HULLS,
+
+        /* A single collider with a TriangleMesh of every triangle. */
+        MESH
+    } PhysicsMode;
+
     /**
      * \brief Create an OBJ parser for the given stream
      */
@@ -64,8 +80,15 @@ public:
      *
      * \details
      *     This method must be called after parse is called.
+     *
+     *     Each object or group becomes one convex collider in HULLS mode, so
+     *     concave objects should be split up into convex parts in the file.
+     *     MESH mode suits static level geometry, which then takes up a single
+     *     entry in the scene's collision pruner.
+     *
+     * \param mode How the triangles are turned into colliders
      */
-    std::shared_ptr<Node> buildPhysicsNode();
+    std::shared_ptr<Node> buildPhysicsNode(PhysicsMode mode = TRIANGLES);
 
 private:
     std::istream &stream;
@@ -74,6 +97,10 @@ private:
     {
     public:
         std::string material;
+
+        /* The index of the object or group the mesh is part of. */
+        int object;
+
         std::vector<int> vIndices;
         std::vector<int> nIndices;
         std::vector<int> tIndices;
@@ -87,6 +114,9 @@ private:
     bool smooth;
     bool done;
 
+    /* The number of objects and groups started so far. */
+    int objects = 0;
+
     int line = 1;
 
     typedef enum
@@ -157,6 +187,11 @@ private:
 
     Mesh &mesh();
 
+    /**
+     * \brief Put the faces that follow in a new object
+     */
+    void startObject();
+
     std::shared_ptr<Node> buildRendererNode(
             const Mesh &mesh,
             std::shared_ptr<Material> material);
@@ -0,0 +1,51 @@
+#ifndef QUERYFILTER_HPP
+#define QUERYFILTER_HPP
+
+#include "gnid/collider.hpp"
+
+namespace gnid
+{
+
+/**
+ * \brief Chooses which kinds of colliders a query should find
+ *
+ * \details
+ *     By default, every collider is accepted.
+ */
+class QueryFilter
+{
+public:
+    /**
+     * \brief Whether colliders without a rigidbody are accepted
+     */
+    bool staticColliders = true;
+
+    /**
+     * \brief Whether colliders with a rigidbody are accepted
+     */
+    bool dynamicColliders = true;
+
+    /**
+     * \brief Whether triggers are accepted
+     */
+    bool triggers = true;
+
+    /**
+     * \brief Whether colliders that are not triggers are accepted
+     */
+    bool solids = true;
+
+    /**
+     * \brief Returns true if the collider should be found by the query
+     */
+    bool accepts(const Collider &collider) const
+    {
+        if(!(collider.isStatic() ? staticColliders : dynamicColliders))
+            return false;
+        return collider.isTrigger() ? triggers : solids;
+    }
+};
+
+} /* namespace */
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef QUICKHULL_HPP
+#define QUICKHULL_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "gnid/matrix/matrix.hpp"
+
+namespace gnid
+{
+
+/**
+ * \brief Finds the convex hull of a set of points using quickhull
+ *
+ * \details
+ *     The hull is made of triangles, so flat faces with more than three
+ *     corners are split up. Points on a face are left out of the hull.
+ *
+ *     If the points do not span a volume, for example if they all lie on a
+ *     plane, there is no hull and isValid() returns false.
+ */
+class QuickHull
+{
+public:
+    QuickHull(const std::vector<tmat::Vector3f> &points);
+
+    /**
+     * \brief Returns true if a hull was found
+     */
+    bool isValid() const { return !faces_.empty(); }
+
+    /**
+     * \brief Returns the indices of the points on the hull in increasing order
+     */
+    const std::vector<uint32_t> &vertices() const { return vertices_; }
+
+    /**
+     * \brief Returns the triangles of the hull
+     *
+     * \details
+     *     Each triangle is three indices into the points, counter-clockwise
+     *     when seen from outside of the hull.
+     */
+    const std::vector<std::array<uint32_t, 3>> &faces() const
+    { return faces_; }
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    /*
+     * The points are kept in double precision, so that which side of a face
+     * a point is on can be told almost exactly for float coordinates.
+     */
+    typedef tmat::Vector<3, double> Point;
+
+    class Face
+    {
+    public:
+        uint32_t vertices[3];
+
+        /* The face across each edge, and the index of the edge in it. */
+        uint32_t neighbors[3];
+        uint32_t neighborEdges[3];
+
+        Point normal;
+        double distance;
+        bool removed;
+
+        /* The points in front of the face not yet added to the hull. */
+        std::vector<uint32_t> outside;
+    };
+
+    /**
+     * \brief Finds four points spanning a volume to start the hull from
+     *
+     * \details
+     *     Returns false if there are none.
+     */
+    bool findInitialPoints(uint32_t *initial) const;
+
+    void addFace(uint32_t a, uint32_t b, uint32_t c);
+
+    void link(
+            uint32_t first,
+            uint32_t firstEdge,
+            uint32_t second,
+            uint32_t secondEdge);
+
+    /**
+     * \brief Links the faces from first onward to their neighbors
+     */
+    void connect(uint32_t first);
+
+    /**
+     * \brief Adds each point to the outside of the first face it is in front of
+     *
+     * \details
+     *     Points behind all of the faces from first onward are inside the hull
+     *     and are dropped.
+     */
+    void assign(const std::vector<uint32_t> &points, uint32_t first);
+
+    /**
+     * \brief Adds the point furthest in front of the face to the hull
+     */
+    void addPoint(uint32_t face);
+
+    /**
+     * \brief Returns true if the edges form a single loop
+     *
+     * \details
+     *     Each edge is a face and the index of the edge in it.
+     */
+    bool isLoop(const std::vector<std::pair<uint32_t, uint32_t>> &edges) const;
+
+    std::vector<Point> points_;
+    double tolerance_;
+
+    /* Set if rounding errors left the hull in a broken state. */
+    bool failed_;
+
+    std::vector<Face> hull_;
+
+    /* Scratch space for adding points. */
+    std::vector<std::pair<uint32_t, uint32_t>> stack_;
+    std::vector<std::pair<uint32_t, uint32_t>> horizon_;
+    std::vector<uint32_t> orphans_;
+
+    std::vector<uint32_t> vertices_;
+    std::vector<std::array<uint32_t, 3>> faces_;
+};
+
+} /* namespace */
+
+#endif
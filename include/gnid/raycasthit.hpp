@@ -0,0 +1,47 @@
+#ifndef RAYCASTHIT_HPP
+#define RAYCASTHIT_HPP
+
+#include <memory>
+
+#include "gnid/matrix/matrix.hpp"
+
+namespace gnid
+{
+
+class Collider;
+
+/**
+ * \brief The result of a raycast or a sweep
+ */
+class RaycastHit
+{
+public:
+    /**
+     * \brief The collider that was hit
+     */
+    std::shared_ptr<Collider> collider;
+
+    /**
+     * \brief The distance traveled along the ray before the hit
+     */
+    float distance = 0;
+
+    /**
+     * \brief The world space normal of the surface that was hit
+     *
+     * \details
+     *     The normal points away from the collider that was hit. If the ray
+     *     started inside the collider, the normal is the opposite of the ray's
+     *     direction.
+     */
+    tmat::Vector3f normal;
+
+    /**
+     * \brief The world space point on the collider that was hit
+     */
+    tmat::Vector3f point;
+};
+
+} /* namespace */
+
+#endif
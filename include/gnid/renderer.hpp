@@ -1,5 +1,6 @@
 #ifndef RENDERER_HPP
 #define RENDERER_HPP
+#include <list>
 #include <memory>
 #include <set>
 
@@ -54,6 +55,10 @@ class Binding
         const std::shared_ptr<RendererMesh> mesh;
         const std::shared_ptr<Node> node;
 
+        /* The world matrix of the node before the last scene update. */
+        mutable tmat::Matrix4f previousWorldMatrix;
+        mutable bool hasPreviousWorldMatrix = false;
+
         Binding(
             std::shared_ptr<Material> material,
             std::shared_ptr<RendererMesh> mesh,
@@ -73,8 +78,20 @@ class Renderer
     public:
         /**
          * \brief Render from the given camera
+         *
+         * \details
+         *     Each node is drawn alpha of the way from where it was when
+         *     savePreviousMatrices() was last called to where it is now.
+         */
+        void render(std::shared_ptr<Camera> camera, float alpha = 1) const;
+
+        /**
+         * \brief
+         *     Keep the world matrix of every node and of the cameras to blend
+         *     from
          */
-        void render(std::shared_ptr<Camera> camera) const;
+        void savePreviousMatrices(
+                const std::list<std::shared_ptr<Camera>> &cameras);
 
         /**
          * \brief Add a binding to be rendered
@@ -98,6 +115,14 @@ class Renderer
     private:
         std::set<Binding> bindings;
         std::set<std::shared_ptr<LightNode>> lights;
+        static tmat::Matrix4f blend(
+                const tmat::Matrix4f &previous,
+                const tmat::Matrix4f &current,
+                float alpha);
+        static tmat::Matrix4f modelMatrix(
+                const Binding &binding,
+                float alpha);
+        static tmat::Matrix4f viewMatrix(const Camera &camera, float alpha);
         void renderMesh(
             std::shared_ptr<RendererMesh> mesh,
             int instanceCount) const;
@@ -3,7 +3,9 @@
 
 #include <memory>
 #include <array>
+#include <cstddef>
 
+#include "gnid/bodystore.hpp"
 #include "gnid/node.hpp"
 #include "gnid/spatialnode.hpp"
 
@@ -36,37 +38,106 @@ public:
     /**
      * \brief The mass of the rigid body
      */
-    float &mass();
+    float mass() const;
+
+    /**
+     * \brief Set the mass of the rigid body
+     *
+     * \details
+     *     A rigid body without a positive mass is not moved by impulses.
+     */
+    void setMass(float mass);
+
+    /**
+     * \brief Whether the rigid body uses continuous collision detection
+     *
+     * \details
+     *     A continuous rigid body that moves further than its own extent in an
+     *     update sweeps its colliders along the way and stops where they first
+     *     hit a solid collider, so that fast bodies do not pass through thin
+     *     colliders. It is off by default.
+     */
+    bool &continuous();
 
     /**
      * \brief Apply an impulse to the rigid body
      */
     void addImpulse(const tmat::Vector3f &impulse);
 
+    /**
+     * \brief Returns true if the rigid body is asleep
+     *
+     * \details
+     *     The scene puts rigid bodies to sleep once they and everything
+     *     touching them have been resting for long enough. A sleeping rigid
+     *     body is not moved by the scene until it is woken, either by an
+     *     impulse or by an awake rigid body touching it.
+     */
+    bool sleeping() const
+    {
+        return store_
+            ? (store_->flags[index_] & BodyStore::SLEEPING) != 0
+            : sleeping_;
+    }
+
+    /**
+     * \brief Wake the rigid body if it is asleep
+     */
+    void wake();
+
     void onSceneChanged(std::shared_ptr<Scene> newScene) override;
 
     std::shared_ptr<Node> clone() override
     {
         auto ret = std::make_shared<Rigidbody>(*this);
+        ret->velocity_ = velocity();
+        ret->sleeping_ = sleeping();
+        ret->store_ = nullptr;
         ret->cloneChildren(shared_from_this());
         return ret;
     }
 
     const tmat::Vector3f &velocity() const
     {
-        return velocity_;
+        return store_ ? store_->velocities[index_] : velocity_;
     }
 
 private:
+    /*
+     * The state of the rigid body while it is not in a scene. In a scene,
+     * the state is kept in the scene's BodyStore instead.
+     */
     tmat::Vector3f velocity_;
+    bool sleeping_;
+
     float mass_;
+    bool continuous_;
+
+    /* The number of updates the rigid body has been moving slowly for. */
+    int restingFrames_;
+
+    /* The store of the scene the rigid body is in, and its index there. */
+    BodyStore *store_;
+    size_t index_;
 
     friend class Scene;
+    friend class ContactSolver;
+    friend class BodyStore;
+
+    tmat::Vector3f &velocityRef()
+    {
+        return store_ ? store_->velocities[index_] : velocity_;
+    }
+
+    float inverseMass() const
+    {
+        return mass_ > 0 ? 1 / mass_ : 0;
+    }
 
     /**
-     * \brief Update the rigid body's physics
+     * \brief Put the rigid body to sleep, stopping it
      */
-    void physicsUpdate(float dt);
+    void sleep();
 };
 
 } /* namespace */
@@ -2,11 +2,15 @@
 #define SCENE_HPP
 
 #include <list>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "gnid/matrix/matrix.hpp"
 #include "gnid/renderer.hpp"
 #include "gnid/kdtree.hpp"
+#include "gnid/bodystore.hpp"
 #include "gnid/collision.hpp"
+#include "gnid/contactsolver.hpp"
 
 namespace gnid
 {
@@ -18,6 +22,7 @@ class Box;
 class Rigidbody;
 class RendererNode;
 class Collider;
+class ThreadPool;
 
 /**
  * \brief A scene
@@ -44,8 +49,14 @@ class Scene : public std::enable_shared_from_this<Scene>
 
         /**
          * \brief Render the scene
+         *
+         * \details
+         *     Nodes are drawn alpha of the way from where they were before the
+         *     last update to where they are now, so that a scene updated with
+         *     a fixed timestep moves smoothly. By default, nodes are drawn
+         *     where they are now.
          */
-        void render();
+        void render(float alpha = 1);
 
         /**
          * \brief Update the scene using a timestep
@@ -59,6 +70,23 @@ class Scene : public std::enable_shared_from_this<Scene>
          */
         tmat::Vector3f &gravity();
 
+        /**
+         * \brief The speed rigid bodies must stay below to fall asleep
+         */
+        float &sleepVelocity();
+
+        /**
+         * \brief The number of updates before resting rigid bodies fall asleep
+         *
+         * \details
+         *     Rigid bodies touching each other form an island, which only falls
+         *     asleep once every body in it has moved slower than
+         *     sleepVelocity() for this many updates. An island is woken as soon
+         *     as any body in it is woken. If this is zero, rigid bodies never
+         *     fall asleep. The default is 60.
+         */
+        int &sleepFrames();
+
         /**
          * \brief Register a collider node for use in the scene
          */
@@ -108,30 +136,154 @@ class Scene : public std::enable_shared_from_this<Scene>
          * \brief Unregister a light node
          */
         void unregisterNode(std::shared_ptr<LightNode> lightNode);
+
+        /**
+         * \brief Return the collision pruner used by the scene
+         */
+        const std::shared_ptr<CollisionPruner> &pruner() const;
+
+        /**
+         * \brief Set the collision pruner used by the scene
+         *
+         * \details
+         *     All of the colliders registered with the scene are added to the
+         *     new pruner. By default, the scene uses a KdTreePruner.
+         */
+        void setPruner(std::shared_ptr<CollisionPruner> pruner);
+
+        /**
+         * \brief The thread pool used to check the pairs of colliders
+         *
+         * \details
+         *     The pairs listed by the pruner are checked for overlap in
+         *     parallel, and the collisions found are then handled in order on
+         *     the calling thread. If the pool is null, which is the default,
+         *     the pairs are checked on the calling thread.
+         */
+        std::shared_ptr<ThreadPool> &threadPool();
+
+        /**
+         * \brief The solver that resolves the contacts between rigid bodies
+         */
+        ContactSolver &solver();
     private:
+        /**
+         * \brief The result of checking a pair of colliders for overlap
+         */
+        class PairResult
+        {
+        public:
+            std::shared_ptr<Collider> a;
+            std::shared_ptr<Collider> b;
+
+            /* The overlap from a to b, if they overlap. */
+            tmat::Vector3f overlap;
+
+            /* The axis GJK ended on, relative to a. */
+            tmat::Vector3f axis;
+
+            bool overlapping;
+
+            /* False if the result of the last check was used again. */
+            bool checked;
+        };
+
+        /**
+         * \brief Check a pair of colliders listed by the pruner for overlap
+         *
+         * \details
+         *     Nothing in the scene is changed, so pairs can be checked on
+         *     several threads at once. Returns false if the pair does not need
+         *     to be checked.
+         */
+        bool checkPair(
+                PairResult &result,
+                const std::shared_ptr<Collider> &a,
+                const std::shared_ptr<Collider> &b,
+                bool tracksPairs,
+                const std::unordered_set<Collision> &newPairs) const;
+
         void handleCollision(
                 std::shared_ptr<Collider> a,
                 std::shared_ptr<Collider> b,
                 tmat::Vector3f overlap);
 
         /**
-         * \brief Update the momentums when two bodies collide
+         * \brief
+         *     Move a continuous rigidbody by motion, stopping at the first hit
+         *
+         * \details
+         *     Bodies that do not move further than their own extent are moved
+         *     normally and left to the discrete collision checks. The
+         *     colliders in the way are found with the pruner as it was after
+         *     the last update.
+         */
+        void moveContinuous(
+                const std::shared_ptr<Rigidbody> &rb,
+                const tmat::Vector3f &motion);
+
+        /**
+         * \brief Put resting islands of rigid bodies to sleep
+         *
+         * \details
+         *     Rigid bodies are joined into islands through the collisions
+         *     between them. Islands with a body awake are woken entirely, and
+         *     islands that have all been resting long enough are put to sleep.
          */
-        void updateMomentums(
-                std::shared_ptr<Rigidbody> as,
-                std::shared_ptr<Rigidbody> bs,
-                const tmat::Vector3f &overlap);
+        void updateIslands();
 
         friend class Node;
 
         std::unordered_set<Collision> collisions;
         std::list<std::shared_ptr<Collider>> colliders;
         std::list<std::shared_ptr<Camera>> cameras;
-        std::list<std::shared_ptr<Rigidbody>> rigidbodies;
-        std::shared_ptr<KdTree> kdTree;
-        KdTreePruner pruner;
+        std::shared_ptr<CollisionPruner> pruner_;
         Renderer renderer;
         tmat::Vector3f gravity_;
+        float sleepVelocity_;
+        int sleepFrames_;
+        ContactSolver solver_;
+
+        /* The state of the rigid bodies, integrated together. */
+        BodyStore bodyStore_;
+
+        /*
+         * The parent of each rigid body in the forest of islands, by its
+         * index in the body store.
+         */
+        std::vector<size_t> islandParents_;
+        std::vector<bool> islandResting_;
+        std::vector<bool> islandAwake_;
+
+        std::shared_ptr<ThreadPool> threadPool_;
+
+        /*
+         * The results of checking the pairs, with one list for each group of
+         * pairs checked together.
+         */
+        std::vector<std::vector<PairResult>> pairResults_;
+
+        /* The colliders found while moving continuous rigidbodies. */
+        std::vector<std::shared_ptr<Node>> continuousNodes_;
+        std::vector<std::shared_ptr<Collider>> continuousColliders_;
+        std::vector<std::shared_ptr<Collider>> continuousCandidates_;
+
+        /*
+         * The collisions found this frame, in the order the pairs were
+         * checked, so that the solver does not depend on the order of the
+         * collisions in memory.
+         */
+        std::vector<const Collision *> frameCollisions_;
+
+        /* Rigidbodies moved by the solver this frame and last frame. */
+        std::unordered_set<std::shared_ptr<Rigidbody>> resolvedBodies_;
+        std::unordered_set<std::shared_ptr<Rigidbody>> lastResolvedBodies_;
+
+        /*
+         * The axis GJK found for each pair the last time it was checked,
+         * relative to the first collider of the key.
+         */
+        std::unordered_map<Collision, tmat::Vector3f> separatingAxes_;
 };
 
 }; /* namespace */
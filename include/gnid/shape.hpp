@@ -14,10 +14,30 @@ class Box;
 class Shape
 {
 public:
+     typedef enum
+     {
+         SPHERE,
+         CAPSULE,
+         BOX,
+         HULL,
+         MESH,
+         OTHER,
+         TYPE_COUNT
+     } ShapeType;
+
      /**
       * \brief Returns the point on the shape with the highest dot product with d
       */
      virtual tmat::Vector3f support(const tmat::Vector3f &d) const = 0;
+
+     /**
+      * \brief Returns the type of the shape
+      *
+      * \details
+      *     Colliders use the type to pick a faster test than GJK for some pairs
+      *     of shapes. Shapes without one should return OTHER.
+      */
+     virtual ShapeType type() const { return OTHER; }
 };
 
 } /* namespace */
@@ -16,6 +16,7 @@ public:
     Sphere(float radius = 1.0f);
 
     tmat::Vector3f support(const tmat::Vector3f &d) const override;
+    ShapeType type() const override { return SPHERE; }
 
     const float &radius() const { return radius_; }
 
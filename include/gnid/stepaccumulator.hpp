@@ -0,0 +1,64 @@
+#ifndef STEPACCUMULATOR_HPP
+#define STEPACCUMULATOR_HPP
+
+namespace gnid
+{
+
+/**
+ * \brief Splits the time between frames into fixed steps
+ *
+ * \details
+ *     Elapsed time is added to an accumulator, and taken back out a whole step
+ *     at a time. The time left over is carried into the next frame, and tells
+ *     how far the frame is between the last two steps.
+ */
+class StepAccumulator
+{
+public:
+    /**
+     * \brief The length of each step, in seconds
+     *
+     * \details
+     *     Zero, which is the default, makes every frame a single step of the
+     *     time since the last frame.
+     */
+    float &step();
+
+    /**
+     * \brief The most steps taken in a single frame
+     *
+     * \details
+     *     If the steps fall further behind than this, for example because of
+     *     a hitch, the time that could not be stepped is dropped instead of
+     *     making the next frames even slower. The default is 5.
+     */
+    int &maxSubsteps();
+
+    /**
+     * \brief
+     *     Add the time since the last frame and return how many steps to take
+     *
+     * \details
+     *     Returns one if step() is zero.
+     */
+    int advance(float dt);
+
+    /**
+     * \brief How far the time left in the accumulator is into the next step
+     *
+     * \details
+     *     The value is between zero and one, and is one if step() is zero.
+     */
+    float alpha() const;
+
+private:
+    float step_ = 0;
+    int maxSubsteps_ = 5;
+
+    /* Time that has passed but has not been stepped yet. */
+    double accumulator_ = 0;
+};
+
+} /* namespace */
+
+#endif
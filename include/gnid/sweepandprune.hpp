@@ -0,0 +1,195 @@
+#ifndef SWEEPANDPRUNE_HPP
+#define SWEEPANDPRUNE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "gnid/collisionpruner.hpp"
+
+namespace gnid
+{
+
+/* Forward declarations. */
+class Collider;
+
+/**
+ * \brief A collision pruner using incremental sweep and prune
+ *
+ * \details
+ *     The pruner keeps a sorted list of the bounding box endpoints of every
+ *     collider along each axis. Since most colliders only move a little each
+ *     frame, the lists are kept sorted using insertion sort, which takes close
+ *     to linear time when the lists are almost sorted. Overlapping pairs are
+ *     kept between updates and only change when endpoints swap places, so the
+ *     pruner can report which pairs were added and removed by each update.
+ *
+ *     Colliders added and removed between updates are handled together by
+ *     the next update. The endpoints of new colliders are sorted on their
+ *     own and merged into the lists in a single pass, which also finds
+ *     their pairs, so building a scene does not take quadratic time.
+ */
+class SweepAndPrunePruner : public CollisionPruner
+{
+public:
+    SweepAndPrunePruner();
+
+    void listOverlappingNodes(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &list) const override;
+
+    void listAllNodes(
+            std::vector<std::shared_ptr<Collider>> &list) const override;
+
+    /**
+     * \brief Adds the given collider to be pruned
+     *
+     * \details
+     *     The collider's pairs will be found the next time update() is called.
+     */
+    void add(std::shared_ptr<Collider> collider) override;
+
+    /**
+     * \brief Removes the given collider
+     *
+     * \details
+     *     The collider's endpoints and pairs are removed the next time
+     *     update() is called, and it is not listed anymore until then.
+     */
+    void remove(std::shared_ptr<Collider> collider) override;
+
+    /**
+     * \brief Update the endpoint lists from the new collider bounding boxes
+     */
+    void update() override;
+
+    bool listPairChanges(
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &added,
+            std::vector<
+                std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+            > &removed) const override;
+
+private:
+    /**
+     * \brief The start or end of a collider's bounding box along an axis
+     */
+    class Endpoint
+    {
+    public:
+        float value;
+
+        /*
+         * The proxy index shifted left by one, with the lowest bit set for the
+         * end of the box.
+         */
+        uint32_t data;
+
+        uint32_t proxy() const { return data >> 1; }
+        bool isMax() const { return data & 1; }
+
+        /**
+         * \brief
+         *     Returns true if this endpoint should be sorted before the other
+         *
+         * \details
+         *     Starts are sorted before ends with the same value, so boxes that
+         *     are touching are considered overlapping like in Box::overlaps().
+         */
+        bool operator<(const Endpoint &other) const
+        {
+            return value < other.value
+                || (value == other.value && !isMax() && other.isMax());
+        }
+    };
+
+    /**
+     * \brief A collider tracked by the pruner
+     */
+    class Proxy
+    {
+    public:
+        std::shared_ptr<Collider> collider;
+        float min[3];
+        float max[3];
+        bool isStatic;
+        bool inUse;
+
+        /* Added since the last update, so without endpoints yet. */
+        bool pending;
+    };
+
+    std::vector<Endpoint> endpoints_[3];
+    std::vector<Proxy> proxies_;
+    std::unordered_map<const Collider *, uint32_t> proxyIndices_;
+
+    /*
+     * Proxies that can be reused, proxies freed since the last update, and
+     * proxies added since the last update.
+     */
+    std::vector<uint32_t> freeProxies_;
+    std::vector<uint32_t> removedProxies_;
+    std::vector<uint32_t> pendingProxies_;
+
+    /* Scratch space for merging the endpoints of the pending proxies. */
+    std::vector<Endpoint> newEndpoints_;
+    std::vector<Endpoint> mergedEndpoints_;
+
+    /*
+     * The proxies whose boxes are open while sweeping the merged endpoints,
+     * split by whether they were pending, and the position of each one in
+     * its list.
+     */
+    std::vector<uint32_t> activeOld_;
+    std::vector<uint32_t> activeNew_;
+    std::vector<uint32_t> activePositions_;
+
+    /* The overlapping pairs, keyed by their proxy indices. */
+    std::unordered_set<uint64_t> pairs_;
+
+    /* Pairs changed since the last update, and whether they existed then. */
+    std::unordered_map<uint64_t, bool> changes_;
+
+    std::vector<
+        std::pair<std::shared_ptr<Collider>, std::shared_ptr<Collider>>
+    > added_, removed_;
+
+    static uint64_t pairKey(uint32_t a, uint32_t b);
+
+    void addPair(uint32_t a, uint32_t b);
+    void removePair(uint32_t a, uint32_t b);
+    bool overlaps(uint32_t a, uint32_t b) const;
+
+    /**
+     * \brief Insertion sort the endpoints along the axis, updating pairs
+     */
+    void sortAxis(int axis);
+
+    /**
+     * \brief Mark a proxy as removed, to be taken out by the next update
+     */
+    void removeProxy(uint32_t index);
+
+    /**
+     * \brief Take the endpoints and pairs of the removed proxies out
+     */
+    void flushRemoved();
+
+    /**
+     * \brief Merge the endpoints of the pending proxies and find their pairs
+     */
+    void flushPending();
+
+    /**
+     * \brief Drop the pairs that were both added and removed by an update
+     */
+    void cancelReadded();
+};
+
+} /* namespace */
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gnid
+{
+
+/**
+ * \brief A fixed set of worker threads for running work in parallel
+ *
+ * \details
+ *     The pool runs loops whose iterations are independent of each other.
+ *     Iterations are handed out one at a time as threads become free, so
+ *     iterations that take different amounts of time are still spread evenly.
+ *     The thread calling parallelFor() also runs iterations, so a pool with no
+ *     worker threads runs everything on the calling thread.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * \brief Create a pool that runs work on the given number of threads
+     *
+     * \details
+     *     The count includes the thread calling parallelFor(), so one fewer
+     *     worker thread is started. By default, one thread is used for each
+     *     hardware thread.
+     */
+    ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &other) = delete;
+    ThreadPool &operator=(const ThreadPool &other) = delete;
+
+    /**
+     * \brief Call the function for each index from zero to count
+     *
+     * \details
+     *     Returns once every call has finished. The calls may run in any order
+     *     and on any thread. Only one loop runs at a time, so calling this
+     *     function from several threads at once is safe but does not add any
+     *     parallelism.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &function);
+
+    /**
+     * \brief Returns the number of threads work is run on
+     */
+    unsigned int threadCount() const { return workers_.size() + 1; }
+
+private:
+    std::vector<std::thread> workers_;
+
+    /* Only one loop runs at a time. */
+    std::mutex loopMutex_;
+
+    /* Protects the state below that is not atomic. */
+    std::mutex mutex_;
+    std::condition_variable started_;
+    std::condition_variable finished_;
+
+    const std::function<void(size_t)> *function_;
+    size_t count_;
+    std::atomic<size_t> next_;
+
+    /* Increased for every loop so that workers know there is new work. */
+    uint64_t generation_;
+
+    /* The number of workers that have not finished the current loop. */
+    unsigned int busyWorkers_;
+
+    bool stopping_;
+
+    /**
+     * \brief The function run by each worker thread
+     */
+    void run();
+
+    /**
+     * \brief Run iterations of the current loop until none are left
+     */
+    void work();
+};
+
+} /* namespace */
+
+#endif
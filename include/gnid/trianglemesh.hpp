@@ -0,0 +1,150 @@
+#ifndef TRIANGLEMESH_HPP
+#define TRIANGLEMESH_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "gnid/box.hpp"
+#include "gnid/matrix/matrix.hpp"
+#include "gnid/shape.hpp"
+
+namespace gnid
+{
+
+/**
+ * \brief A shape made of many triangles, such as the geometry of a level
+ *
+ * \details
+ *     The mesh does not need to be convex or closed. Colliders test other
+ *     shapes against only the triangles near them, which are found using a
+ *     bounding volume hierarchy built when the mesh is created. The triangles
+ *     are two sided.
+ *
+ *     A mesh has no inside, so a shape entirely inside a closed mesh does not
+ *     overlap it. Meshes are meant for static geometry and never collide with
+ *     each other.
+ */
+class TriangleMesh : public Shape
+{
+public:
+    /**
+     * \brief Create a mesh from vertices and the indices of its triangles
+     *
+     * \details
+     *     Every three indices make a triangle. Triangles with no area are left
+     *     out.
+     *
+     * \param vertices             The corners of the triangles
+     * \param indices              Three indices into vertices per triangle
+     * \param maxTrianglesPerLeaf  The most triangles in a leaf of the hierarchy
+     */
+    TriangleMesh(
+            const std::vector<tmat::Vector3f> &vertices,
+            const std::vector<uint32_t> &indices,
+            unsigned int maxTrianglesPerLeaf = 4);
+
+    /**
+     * \brief Returns the vertex furthest along d
+     *
+     * \details
+     *     This checks every vertex, and is only meant for finding the bounds of
+     *     the mesh.
+     */
+    tmat::Vector3f support(const tmat::Vector3f &d) const override;
+    ShapeType type() const override { return MESH; }
+
+    /**
+     * \brief Returns the number of triangles in the mesh
+     */
+    size_t triangleCount() const { return triangles_.size(); }
+
+    /**
+     * \brief Returns the corners of the given triangle
+     *
+     * \details
+     *     The corners are counter-clockwise when seen from the front.
+     */
+    std::array<tmat::Vector3f, 3> triangle(uint32_t index) const
+    {
+        const auto &t = triangles_[index];
+        return { vertices_[t[0]], vertices_[t[1]], vertices_[t[2]] };
+    }
+
+    /**
+     * \brief List the triangles whose bounding boxes overlap the given box
+     *
+     * \details
+     *     The box is in the space of the mesh. The indices are added to the
+     *     end of the list.
+     */
+    void listOverlappingTriangles(
+            const Box &box,
+            std::vector<uint32_t> &list) const;
+
+    /**
+     * \brief Returns true if the ray hits a triangle
+     *
+     * \details
+     *     The ray is in the space of the mesh. The distance to the nearest hit,
+     *     in multiples of direction, and the triangle hit are stored if the ray
+     *     hits within maxDistance.
+     */
+    bool raycast(
+            float &distance,
+            uint32_t &triangle,
+            const tmat::Vector3f &origin,
+            const tmat::Vector3f &direction,
+            float maxDistance) const;
+
+    /**
+     * \brief Returns the number of nodes in the hierarchy
+     */
+    unsigned int nodeCount() const { return nodes_.size(); }
+
+private:
+    /**
+     * \brief A node in the hierarchy
+     *
+     * \details
+     *     As in Bvh, inner nodes have a count of zero and their left child is
+     *     the next node in the array. Leaf nodes store a range of triangles.
+     */
+    class Node
+    {
+    public:
+        float min[3];
+        float max[3];
+        uint32_t right;
+        uint32_t first;
+        uint32_t count;
+
+        bool isLeaf() const { return count > 0; }
+    };
+
+    const unsigned int maxTrianglesPerLeaf_;
+
+    std::vector<tmat::Vector3f> vertices_;
+
+    /* The triangles, sorted so that each leaf has a range of them. */
+    std::vector<std::array<uint32_t, 3>> triangles_;
+
+    std::vector<Node> nodes_;
+
+    /**
+     * \brief Recursively build the subtree for the given range of triangles
+     *
+     * \details
+     *     The triangles are listed in order, which is sorted as the tree is
+     *     built, and centers holds the center of each triangle's bounds.
+     */
+    void build(
+            uint32_t first,
+            uint32_t count,
+            std::vector<uint32_t> &order,
+            const std::vector<tmat::Vector3f> &centers);
+};
+
+} /* namespace */
+
+#endif
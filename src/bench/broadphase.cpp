@@ -0,0 +1,447 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "gnid/box.hpp"
+#include "gnid/bvh.hpp"
+#include "gnid/capsule.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/hashgrid.hpp"
+#include "gnid/hull.hpp"
+#include "gnid/kdtree.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/sweepandprune.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/*
+ * Every allocation is counted so that the memory used by each pruner can be
+ * reported. The size of each allocation is kept in front of it.
+ */
+static atomic<size_t> allocatedBytes(0);
+static const size_t HEADER_SIZE = alignof(max_align_t);
+
+void *operator new(size_t size)
+{
+    char *block = static_cast<char *>(malloc(size + HEADER_SIZE));
+    if(!block)
+        throw bad_alloc();
+    *reinterpret_cast<size_t *>(block) = size;
+    allocatedBytes += size;
+    return block + HEADER_SIZE;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if(!pointer)
+        return;
+    char *block = static_cast<char *>(pointer) - HEADER_SIZE;
+    allocatedBytes -= *reinterpret_cast<size_t *>(block);
+    free(block);
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void *pointer, size_t size) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void *pointer, size_t size) noexcept
+{
+    operator delete(pointer);
+}
+
+/* The time step of each frame, in seconds. */
+static const float TIME_STEP = 1.0f / 60.0f;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+static Vector3f randomVector(float min, float max)
+{
+    return Vector3f {
+        randomFloat(min, max),
+        randomFloat(min, max),
+        randomFloat(min, max) };
+}
+
+/**
+ * \brief A synthetic world of moving colliders
+ */
+class World
+{
+public:
+    shared_ptr<EmptyNode> root;
+    vector<shared_ptr<Rigidbody>> bodies;
+    vector<shared_ptr<Collider>> colliders;
+
+    /* The scripted velocity of each body. */
+    vector<Vector3f> velocities;
+
+    /* Bodies bounce back when they leave this cube. */
+    float extent;
+
+    bool stacked;
+};
+
+/**
+ * \brief Create a shape about one unit across
+ *
+ * \details
+ *     Spheres, capsules and hulls are used in turn.
+ */
+static shared_ptr<Shape> makeShape(int index)
+{
+    switch(index % 3)
+    {
+    case 0:
+        return make_shared<Sphere>(randomFloat(0.4f, 0.5f));
+    case 1:
+        return make_shared<Capsule>(
+                randomFloat(0.2f, 0.3f),
+                Vector3f { 0, -0.25f, 0 },
+                Vector3f { 0, 0.25f, 0 });
+    default:
+    {
+        /* A randomly stretched cube. */
+        Vector3f size = randomVector(0.3f, 0.5f);
+        vector<Vector3f> points;
+        for(int i = 0; i < 8; i ++)
+        {
+            points.push_back(Vector3f {
+                    (i & 1) ? size[0] : -size[0],
+                    (i & 2) ? size[1] : -size[1],
+                    (i & 4) ? size[2] : -size[2] });
+        }
+        return make_shared<Hull>(points);
+    }
+    }
+}
+
+/**
+ * \brief Returns the starting position of each body for the layout
+ *
+ * \details
+ *     - uniform: spread evenly over a cube that grows with the count, so the
+ *       density stays the same.
+ *     - clustered: packed around a few centers, so some areas are crowded and
+ *       the rest is empty.
+ *     - stacked: columns of bodies resting on each other, as in a pile of
+ *       crates.
+ */
+static Vector3f startPosition(
+        const string &layout,
+        int index,
+        int count,
+        float extent,
+        const vector<Vector3f> &clusters)
+{
+    if(layout == "clustered")
+    {
+        const Vector3f &center = clusters[index % clusters.size()];
+        Vector3f offset = Vector3f::zero;
+
+        /* Summing uniform values bunches them toward the center. */
+        for(int i = 0; i < 3; i ++)
+            offset += randomVector(-1.5f, 1.5f);
+        return center + offset;
+    }
+    else if(layout == "stacked")
+    {
+        const int height = 10;
+        int columns = ceil(sqrt(ceil(count / static_cast<float>(height))));
+        int column = index / height;
+        return Vector3f {
+            (column % columns - columns * 0.5f) * 1.5f,
+            (index % height) * 0.95f + 0.5f,
+            (column / columns - columns * 0.5f) * 1.5f };
+    }
+    return randomVector(-extent, extent);
+}
+
+static World makeWorld(const string &layout, int count)
+{
+    srand(1);
+
+    World world;
+    world.root = make_shared<EmptyNode>();
+    world.extent = 2.0f * cbrt(static_cast<float>(count));
+    world.stacked = layout == "stacked";
+
+    vector<Vector3f> clusters;
+    for(int i = 0; i < max(1, count / 500); i ++)
+        clusters.push_back(randomVector(-world.extent, world.extent));
+
+    for(int i = 0; i < count; i ++)
+    {
+        auto body = make_shared<Rigidbody>();
+        body->transformWorld(getTranslateMatrix(
+                    startPosition(layout, i, count, world.extent, clusters)));
+
+        auto collider = make_shared<Collider>(makeShape(i));
+        body->add(collider);
+        world.root->add(body);
+
+        world.bodies.push_back(body);
+        world.colliders.push_back(collider);
+
+        if(world.stacked)
+            world.velocities.push_back(Vector3f::zero);
+        else
+            world.velocities.push_back(randomVector(-2.0f, 2.0f));
+    }
+
+    /* Add a static ground under everything. */
+    auto ground = make_shared<SpatialNode>();
+    Box groundBox;
+    groundBox.add(Vector3f { -world.extent * 2, -1, -world.extent * 2 });
+    groundBox.add(Vector3f { world.extent * 2, 0, world.extent * 2 });
+    ground->transformWorld(getTranslateMatrix(
+                Vector3f { 0, world.stacked ? 0 : -world.extent, 0 }));
+    auto groundCollider = make_shared<Collider>(make_shared<Box>(groundBox));
+    ground->add(groundCollider);
+    world.root->add(ground);
+    world.colliders.push_back(groundCollider);
+
+    for(auto &collider : world.colliders)
+        collider->calcBox();
+
+    return world;
+}
+
+/**
+ * \brief Move every body by its scripted velocity
+ */
+static void step(World &world, int frame)
+{
+    for(size_t i = 0; i < world.bodies.size(); i ++)
+    {
+        auto &body = world.bodies[i];
+        body->newFrame();
+
+        Vector3f velocity = world.velocities[i];
+        if(world.stacked)
+        {
+            /* Sway the stacks so that the bodies slide against each other. */
+            float phase = frame * TIME_STEP * 2.0f + i * 0.1f;
+            velocity = Vector3f { cos(phase), 0, sin(phase) } * 0.5f;
+        }
+        else
+        {
+            /* Bounce off of the edges of the world. */
+            Vector3f position = transform(body->worldMatrix(), Vector3f::zero);
+            for(int j = 0; j < 3; j ++)
+            {
+                if(fabs(position[j]) > world.extent
+                    && (position[j] > 0) == (velocity[j] > 0))
+                {
+                    velocity[j] = -velocity[j];
+                }
+            }
+            world.velocities[i] = velocity;
+        }
+
+        body->transformWorld(getTranslateMatrix(velocity * TIME_STEP));
+    }
+
+    for(auto &collider : world.colliders)
+        collider->calcBox();
+}
+
+/**
+ * \brief Runs the pruner over the world and prints a line of results
+ */
+static void run(
+        const string &layout,
+        const string &name,
+        const function<shared_ptr<CollisionPruner>()> &makePruner,
+        int count,
+        int frameCount)
+{
+    World world = makeWorld(layout, count);
+
+    vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> pairs;
+    pairs.reserve(count * 8);
+
+    auto start = chrono::steady_clock::now();
+
+    auto pruner = makePruner();
+    for(auto &collider : world.colliders)
+    {
+        pruner->add(collider);
+        if(collider->isStatic())
+            pruner->staticColliderMoved(collider);
+    }
+    pruner->update();
+    pruner->listOverlappingNodes(pairs);
+
+    auto built = chrono::steady_clock::now();
+
+    double updateTime = 0;
+    double listTime = 0;
+    size_t pairCount = 0;
+    for(int frame = 0; frame < frameCount; frame ++)
+    {
+        step(world, frame);
+
+        auto frameStart = chrono::steady_clock::now();
+        pruner->update();
+        auto updated = chrono::steady_clock::now();
+        pairs.clear();
+        pruner->listOverlappingNodes(pairs);
+        auto listed = chrono::steady_clock::now();
+
+        updateTime += chrono::duration<double>(updated - frameStart).count();
+        listTime += chrono::duration<double>(listed - updated).count();
+        pairCount += pairs.size();
+    }
+
+    /* The memory used by the pruner is what it frees when destroyed. */
+    size_t usedBytes = allocatedBytes;
+    pruner = nullptr;
+    size_t prunerBytes = usedBytes - allocatedBytes;
+
+    cout << layout << "\t"
+         << name << "\t"
+         << count << "\t"
+         << chrono::duration<double, milli>(built - start).count() << "\t"
+         << updateTime * 1000 / frameCount << "\t"
+         << listTime * 1000 / frameCount << "\t"
+         << pairCount / frameCount << "\t"
+         << pairCount / (updateTime + listTime) << "\t"
+         << prunerBytes / 1024 << endl;
+}
+
+/**
+ * \brief Splits a comma separated list
+ */
+static vector<string> split(const string &list)
+{
+    vector<string> ret;
+    stringstream stream(list);
+    string item;
+    while(getline(stream, item, ','))
+        ret.push_back(item);
+    return ret;
+}
+
+static void usage(const char *program)
+{
+    cerr << "usage: " << program << " [options]" << endl
+         << "  --layouts  uniform,clustered,stacked" << endl
+         << "  --pruners  kdtree,bvh,sap,hashgrid" << endl
+         << "  --counts   1000,10000" << endl
+         << "  --frames   60" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<string> layouts { "uniform", "clustered", "stacked" };
+    vector<string> pruners { "kdtree", "bvh", "sap", "hashgrid" };
+    vector<int> counts { 1000, 10000 };
+    int frameCount = 60;
+
+    for(int i = 1; i < argc; i ++)
+    {
+        if(i + 1 == argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        string value = argv[++ i];
+        if(!strcmp(argv[i - 1], "--layouts"))
+            layouts = split(value);
+        else if(!strcmp(argv[i - 1], "--pruners"))
+            pruners = split(value);
+        else if(!strcmp(argv[i - 1], "--counts"))
+        {
+            counts.clear();
+            for(auto &count : split(value))
+                counts.push_back(atoi(count.c_str()));
+        }
+        else if(!strcmp(argv[i - 1], "--frames"))
+            frameCount = max(1, atoi(value.c_str()));
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    cout << "layout\tpruner\tcount\tbuild ms\tupdate ms\tlist ms\tpairs"
+         << "\tpairs/s\tmemory KiB" << endl;
+
+    for(auto &layout : layouts)
+    {
+        for(int count : counts)
+        {
+            for(auto &name : pruners)
+            {
+                function<shared_ptr<CollisionPruner>()> makePruner;
+                if(name == "kdtree")
+                {
+                    makePruner = []()
+                    {
+                        return make_shared<KdTreePruner>(
+                                make_shared<KdTree>());
+                    };
+                }
+                else if(name == "bvh")
+                {
+                    makePruner = []()
+                    {
+                        return make_shared<BvhPruner>(make_shared<Bvh>());
+                    };
+                }
+                else if(name == "sap")
+                {
+                    makePruner = []()
+                    {
+                        return make_shared<SweepAndPrunePruner>();
+                    };
+                }
+                else if(name == "hashgrid")
+                {
+                    makePruner = []()
+                    {
+                        return make_shared<HashGridPruner>(2.0f);
+                    };
+                }
+                else
+                {
+                    cerr << "unknown pruner " << name << endl;
+                    return 1;
+                }
+
+                run(layout, name, makePruner, count, frameCount);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "gnid/capsule.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/hull.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/*
+ * Every allocation is counted so that they can be reported per call. Every
+ * form of new allocates with malloc(), and every form of delete frees through
+ * the unsized one, so that they always match.
+ */
+static size_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+    allocationCount ++;
+    void *pointer = malloc(size);
+    if(!pointer)
+        throw bad_alloc();
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    allocationCount ++;
+    void *pointer = malloc(size);
+    if(!pointer)
+        throw bad_alloc();
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+/* The number of times getOverlap() is called for each case. */
+static const int CALL_COUNT = 100000;
+
+static shared_ptr<Shape> makeShape(const string &name)
+{
+    if(name == "sphere")
+        return make_shared<Sphere>(0.5f);
+    if(name == "capsule")
+    {
+        return make_shared<Capsule>(
+                0.25f,
+                Vector3f { 0, -0.25f, 0 },
+                Vector3f { 0, 0.25f, 0 });
+    }
+
+    /* A box with slightly uneven sides, so that faces are not parallel. */
+    vector<Vector3f> points;
+    for(int i = 0; i < 8; i ++)
+    {
+        points.push_back(Vector3f {
+                (i & 1) ? 0.5f : -0.45f,
+                (i & 2) ? 0.5f : -0.4f,
+                (i & 4) ? 0.5f : -0.55f });
+    }
+    return make_shared<Hull>(points);
+}
+
+static shared_ptr<Collider> makeCollider(
+        const string &shape,
+        const Vector3f &position)
+{
+    static auto root = make_shared<EmptyNode>();
+
+    auto parent = make_shared<SpatialNode>();
+    parent->transformWorld(getTranslateMatrix(position));
+    auto collider = make_shared<Collider>(makeShape(shape));
+    parent->add(collider);
+    root->add(parent);
+
+    /* Stop the matrices from being recalculated on every call. */
+    parent->newFrame();
+    return collider;
+}
+
+/**
+ * \brief Times getOverlap() for two shapes at the given distance apart
+ */
+static void run(const string &first, const string &second, float distance)
+{
+    auto a = makeCollider(first, Vector3f::zero);
+    auto b = makeCollider(second, Vector3f { 0.1f, distance, 0.05f });
+
+    /* Calculate the world matrices before counting. */
+    Vector3f overlap;
+    Vector3f initialAxis = Vector3f::right;
+    bool overlapping = a->getOverlap(overlap, initialAxis, b);
+
+    size_t allocations = allocationCount;
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < CALL_COUNT; i ++)
+    {
+        initialAxis = Vector3f::right;
+        a->getOverlap(overlap, initialAxis, b);
+    }
+    auto end = chrono::steady_clock::now();
+    allocations = allocationCount - allocations;
+
+    /* Pass the axis found by each call on to the next, as the scene does. */
+    auto warmStart = chrono::steady_clock::now();
+    for(int i = 0; i < CALL_COUNT; i ++)
+        a->getOverlap(overlap, initialAxis, b);
+    auto warmEnd = chrono::steady_clock::now();
+
+    cout << first << "\t" << second << "\t" << distance << "\t"
+         << (overlapping ? "yes" : "no") << "\t"
+         << chrono::duration<double, nano>(end - start).count() / CALL_COUNT
+         << "\t"
+         << chrono::duration<double, nano>(warmEnd - warmStart).count()
+            / CALL_COUNT
+         << "\t"
+         << allocations / static_cast<double>(CALL_COUNT) << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    cout << "first\tsecond\tdistance\toverlap\tns/call\twarm ns/call"
+         << "\tallocations/call" << endl;
+
+    for(auto first : { "sphere", "capsule", "hull" })
+    {
+        for(auto second : { "sphere", "capsule", "hull" })
+        {
+            /* Separated, nearly touching and penetrating. */
+            for(float distance : { 2.0f, 1.05f, 0.7f })
+                run(first, second, distance);
+        }
+    }
+}
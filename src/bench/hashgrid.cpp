@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/hashgrid.hpp"
+#include "gnid/kdtree.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/* The number of frames to time each pruner for. */
+static const int FRAME_COUNT = 10;
+
+/* The fraction of colliders that move each frame. */
+static const float MOVING_FRACTION = 0.1f;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+/**
+ * \brief Runs the pruner over a world of the given number of colliders
+ *
+ * \details
+ *     The colliders are spheres spread uniformly over a cube so that the
+ *     density of the world stays the same as the number of colliders grows.
+ *     Prints the time taken to build the pruner and the average time taken by
+ *     each frame.
+ */
+static void run(const char *name, CollisionPruner &pruner, int count)
+{
+    srand(1);
+
+    auto root = make_shared<EmptyNode>();
+    vector<shared_ptr<SpatialNode>> parents;
+    vector<shared_ptr<Collider>> colliders;
+
+    const float extent = 2.0f * cbrt(static_cast<float>(count));
+    for(int i = 0; i < count; i ++)
+    {
+        auto parent = make_shared<Rigidbody>();
+        parent->transformWorld(getTranslateMatrix(Vector3f {
+                randomFloat(-extent, extent),
+                randomFloat(-extent, extent),
+                randomFloat(-extent, extent) }));
+
+        auto collider = make_shared<Collider>(
+                make_shared<Sphere>(randomFloat(0.5f, 1.0f)));
+        parent->add(collider);
+        root->add(parent);
+        collider->calcBox();
+
+        parents.push_back(parent);
+        colliders.push_back(collider);
+    }
+
+    vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> pairs;
+
+    auto start = chrono::steady_clock::now();
+    for(auto &collider : colliders)
+        pruner.add(collider);
+    pruner.update();
+    pruner.listOverlappingNodes(pairs);
+    auto built = chrono::steady_clock::now();
+
+    double frameTime = 0;
+    for(int frame = 0; frame < FRAME_COUNT; frame ++)
+    {
+        for(auto &parent : parents)
+            parent->newFrame();
+
+        for(int i = 0; i < count * MOVING_FRACTION; i ++)
+        {
+            parents[rand() % count]->transformWorld(
+                    getTranslateMatrix(Vector3f {
+                        randomFloat(-0.5f, 0.5f),
+                        randomFloat(-0.5f, 0.5f),
+                        randomFloat(-0.5f, 0.5f) }));
+        }
+
+        for(auto &collider : colliders)
+            collider->calcBox();
+
+        auto frameStart = chrono::steady_clock::now();
+        pairs.clear();
+        pruner.update();
+        pruner.listOverlappingNodes(pairs);
+        auto frameEnd = chrono::steady_clock::now();
+
+        frameTime += chrono::duration<double, milli>(frameEnd - frameStart)
+            .count();
+    }
+
+    cout << name << "\t" << count << "\t"
+         << chrono::duration<double, milli>(built - start).count() << "\t"
+         << frameTime / FRAME_COUNT << "\t"
+         << pairs.size() << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    cout << "pruner\tcount\tbuild ms\tframe ms\tpairs" << endl;
+    for(int count : { 1000, 10000, 100000 })
+    {
+        HashGridPruner hashGrid(4.0f);
+        run("hashgrid", hashGrid, count);
+
+        KdTreePruner kdTree(make_shared<KdTree>());
+        run("kdtree", kdTree, count);
+    }
+}
@@ -0,0 +1,187 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/hull.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/* The number of support() calls timed for each hull. */
+static const int SUPPORT_COUNT = 1000000;
+
+/* The number of getOverlap() calls timed for each pair of hulls. */
+static const int OVERLAP_COUNT = 20000;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+static Vector3f randomVector(float min, float max)
+{
+    return Vector3f {
+        randomFloat(min, max),
+        randomFloat(min, max),
+        randomFloat(min, max) };
+}
+
+/**
+ * \brief Returns points which are all corners of their hull
+ *
+ * \details
+ *     Eight points make a cube, and more are spread over a sphere.
+ */
+static vector<Vector3f> makePoints(int count)
+{
+    vector<Vector3f> points;
+    if(count == 8)
+    {
+        for(int i = 0; i < 8; i ++)
+        {
+            points.push_back(Vector3f {
+                    (i & 1) ? 0.5f : -0.5f,
+                    (i & 2) ? 0.5f : -0.5f,
+                    (i & 4) ? 0.5f : -0.5f });
+        }
+        return points;
+    }
+
+    /* A spiral gives evenly spaced points. */
+    for(int i = 0; i < count; i ++)
+    {
+        float y = 1 - (i + 0.5f) * 2 / count;
+        float radius = sqrt(1 - y * y);
+        float angle = i * 2.39996f;
+        points.push_back(
+                Vector3f { cos(angle) * radius, y, sin(angle) * radius }
+                * 0.5f);
+    }
+    return points;
+}
+
+/**
+ * \brief Returns the time per support() call in nanoseconds
+ *
+ * \details
+ *     If coherent is true, the direction turns slowly as it would between
+ *     GJK iterations on nearby frames. Otherwise it jumps around.
+ */
+static double timeSupport(
+        const Hull &hull,
+        const vector<Vector3f> &directions,
+        bool coherent)
+{
+    Vector3f sum = Vector3f::zero;
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < SUPPORT_COUNT; i ++)
+    {
+        Vector3f d;
+        if(coherent)
+        {
+            float angle = i * 0.001f;
+            d = Vector3f { cos(angle), sin(angle * 0.7f), sin(angle) };
+        }
+        else
+            d = directions[i % directions.size()];
+        sum += hull.support(d);
+    }
+    auto end = chrono::steady_clock::now();
+
+    /* Stop the calls from being optimized away. */
+    if(sum[0] == 1234.5f)
+        cout << sum;
+
+    return chrono::duration<double, nano>(end - start).count()
+        / SUPPORT_COUNT;
+}
+
+static shared_ptr<Collider> makeCollider(
+        const shared_ptr<Hull> &hull,
+        const Matrix4f &toWorld)
+{
+    static auto root = make_shared<EmptyNode>();
+
+    auto parent = make_shared<SpatialNode>();
+    parent->transformWorld(toWorld);
+    auto collider = make_shared<Collider>(hull);
+    parent->add(collider);
+    root->add(parent);
+
+    /* Stop the matrices from being recalculated on every call. */
+    parent->newFrame();
+    collider->newFrame();
+    return collider;
+}
+
+/**
+ * \brief Returns the time per getOverlap() call in nanoseconds
+ */
+static double timeOverlap(const shared_ptr<Hull> &hull, float distance)
+{
+    auto a = makeCollider(hull, Matrix4f::identity);
+    auto b = makeCollider(
+            hull,
+            getTranslateMatrix(Vector3f { 0.1f, distance, 0.05f })
+            * getRotateMatrix(0.5f, Vector3f { 1, 1, 0 }.normalized()));
+
+    Vector3f overlap;
+    Vector3f initialAxis;
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < OVERLAP_COUNT; i ++)
+    {
+        initialAxis = Vector3f::right;
+        a->getOverlap(overlap, initialAxis, b);
+    }
+    auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double, nano>(end - start).count()
+        / OVERLAP_COUNT;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<Vector3f> directions;
+    for(int i = 0; i < 4096; i ++)
+        directions.push_back(randomVector(-1, 1));
+
+    cout << "vertices\tsupport\tscan ns\tclimb ns" << endl;
+    for(int count : { 8, 16, 32, 64, 512 })
+    {
+        vector<Vector3f> points = makePoints(count);
+        auto scanned = make_shared<Hull>(points, false);
+        auto climbed = make_shared<Hull>(points);
+
+        for(bool coherent : { false, true })
+        {
+            cout << count << "\t"
+                 << (coherent ? "coherent" : "random") << "\t"
+                 << timeSupport(*scanned, directions, coherent) << "\t";
+            if(climbed->climbs())
+                cout << timeSupport(*climbed, directions, coherent);
+            else
+                cout << "-";
+            cout << endl;
+        }
+
+        /* Separated and penetrating. */
+        for(float distance : { 1.5f, 0.7f })
+        {
+            cout << count << "\tgetOverlap " << distance << "\t"
+                 << timeOverlap(scanned, distance) << "\t";
+            if(climbed->climbs())
+                cout << timeOverlap(climbed, distance);
+            else
+                cout << "-";
+            cout << endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "gnid/bodystore.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/threadpool.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/* The number of updates timed for each thread count. */
+static const int FRAME_COUNT = 200;
+
+int main(int argc, char *argv[])
+{
+    size_t bodyCount = argc > 1 ? atoi(argv[1]) : 100000;
+    unsigned int maxThreads = argc > 2
+        ? atoi(argv[2])
+        : max(1u, thread::hardware_concurrency());
+
+    /* Spatial nodes need a parent to have a world matrix. */
+    auto root = make_shared<EmptyNode>();
+    BodyStore store;
+    for(size_t i = 0; i < bodyCount; i ++)
+    {
+        auto body = make_shared<Rigidbody>();
+        body->addImpulse(Vector3f { 1, static_cast<float>(i % 10), 0 });
+        root->add(body);
+        store.add(body);
+    }
+    store.readPositions();
+
+    double serialTime = 0;
+    cout << "threads\tms/frame\tspeedup" << endl;
+    for(unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        unique_ptr<ThreadPool> pool;
+        if(threads > 1)
+            pool = make_unique<ThreadPool>(threads);
+
+        auto start = chrono::steady_clock::now();
+        for(int frame = 0; frame < FRAME_COUNT; frame ++)
+            store.integrate(1.0f / 60.0f, Vector3f { 0, -9.8f, 0 }, pool.get());
+        auto end = chrono::steady_clock::now();
+
+        double time =
+            chrono::duration<double, milli>(end - start).count() / FRAME_COUNT;
+        if(threads == 1)
+            serialTime = time;
+        cout << threads << "\t" << time << "\t" << serialTime / time << endl;
+    }
+
+    return 0;
+}
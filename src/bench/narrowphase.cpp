@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/hull.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/scene.hpp"
+#include "gnid/threadpool.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/* The number of updates timed for each thread count. */
+static const int FRAME_COUNT = 120;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+/**
+ * \brief Create a scene with stacks of hulls resting on a floor
+ */
+static shared_ptr<Scene> makeScene(
+        vector<shared_ptr<Rigidbody>> &bodies,
+        int columns)
+{
+    srand(1);
+
+    auto scene = make_shared<Scene>();
+    scene->init();
+
+    auto floor = make_shared<Box>();
+    floor->add(Vector3f { -100, -1, -100 });
+    floor->add(Vector3f { 100, 0, 100 });
+    scene->root->add(make_shared<Collider>(floor));
+
+    for(int x = 0; x < columns; x ++)
+    {
+        for(int z = 0; z < columns; z ++)
+        {
+            for(int y = 0; y < 8; y ++)
+            {
+                /* A randomly stretched cube. */
+                Vector3f size {
+                    randomFloat(0.4f, 0.5f),
+                    randomFloat(0.4f, 0.5f),
+                    randomFloat(0.4f, 0.5f) };
+                vector<Vector3f> points;
+                for(int i = 0; i < 8; i ++)
+                {
+                    points.push_back(Vector3f {
+                            (i & 1) ? size[0] : -size[0],
+                            (i & 2) ? size[1] : -size[1],
+                            (i & 4) ? size[2] : -size[2] });
+                }
+
+                auto body = make_shared<Rigidbody>();
+                body->transformWorld(getTranslateMatrix(Vector3f {
+                            x * 1.2f - columns * 0.6f,
+                            0.5f + y * 0.95f,
+                            z * 1.2f - columns * 0.6f }));
+                body->add(make_shared<Collider>(make_shared<Hull>(points)));
+                scene->root->add(body);
+                bodies.push_back(body);
+            }
+        }
+    }
+    return scene;
+}
+
+int main(int argc, char *argv[])
+{
+    int columns = argc > 1 ? atoi(argv[1]) : 16;
+    unsigned int maxThreads = argc > 2
+        ? atoi(argv[2])
+        : max(1u, thread::hardware_concurrency());
+
+    vector<Vector3f> expected;
+    double serialTime = 0;
+
+    cout << "threads\tms/frame\tspeedup" << endl;
+    for(unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        vector<shared_ptr<Rigidbody>> bodies;
+        auto scene = makeScene(bodies, columns);
+        if(threads > 1)
+            scene->threadPool() = make_shared<ThreadPool>(threads);
+
+        auto start = chrono::steady_clock::now();
+        for(int frame = 0; frame < FRAME_COUNT; frame ++)
+            scene->update(1.0f / 60.0f);
+        auto end = chrono::steady_clock::now();
+
+        double time =
+            chrono::duration<double, milli>(end - start).count() / FRAME_COUNT;
+        if(threads == 1)
+            serialTime = time;
+        cout << threads << "\t" << time << "\t" << serialTime / time << endl;
+
+        /* The results should not depend on the number of threads. */
+        for(size_t i = 0; i < bodies.size(); i ++)
+        {
+            Vector3f position = bodies[i]->position();
+            if(threads == 1)
+                expected.push_back(position);
+            else if(!(position == expected[i]))
+            {
+                cerr << "body " << i << " moved differently with "
+                     << threads << " threads" << endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
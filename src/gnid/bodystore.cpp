@@ -0,0 +1,106 @@
+#include "gnid/bodystore.hpp"
+
+#include <algorithm>
+
+#include "gnid/rigidbody.hpp"
+#include "gnid/threadpool.hpp"
+
+using namespace gnid;
+using namespace std;
+using namespace tmat;
+
+/* The number of bodies integrated together by one thread. */
+static const size_t BODY_CHUNK_SIZE = 4096;
+
+BodyStore::~BodyStore()
+{
+    /* Rigid bodies may outlive the scene, so give them their state back. */
+    while(!bodies.empty())
+        remove(bodies.back());
+}
+
+void BodyStore::add(const shared_ptr<Rigidbody> &rb)
+{
+    rb->store_ = this;
+    rb->index_ = bodies.size();
+
+    bodies.push_back(rb);
+    positions.push_back(Vector3f::zero);
+    velocities.push_back(rb->velocity_);
+    inverseMasses.push_back(rb->inverseMass());
+    flags.push_back(rb->sleeping_ ? SLEEPING : 0);
+}
+
+void BodyStore::remove(const shared_ptr<Rigidbody> &rb)
+{
+    size_t index = rb->index_;
+    rb->velocity_ = velocities[index];
+    rb->sleeping_ = (flags[index] & SLEEPING) != 0;
+    rb->store_ = nullptr;
+
+    size_t last = bodies.size() - 1;
+    if(index != last)
+    {
+        bodies[index] = bodies[last];
+        positions[index] = positions[last];
+        velocities[index] = velocities[last];
+        inverseMasses[index] = inverseMasses[last];
+        flags[index] = flags[last];
+        bodies[index]->index_ = index;
+    }
+
+    bodies.pop_back();
+    positions.pop_back();
+    velocities.pop_back();
+    inverseMasses.pop_back();
+    flags.pop_back();
+}
+
+void BodyStore::readPositions()
+{
+    for(size_t i = 0; i < bodies.size(); i ++)
+    {
+        if(!(flags[i] & SLEEPING))
+            positions[i] = bodies[i]->position();
+    }
+}
+
+void BodyStore::integrateRange(
+        size_t first,
+        size_t last,
+        float dt,
+        const Vector3f &gravity)
+{
+    /*
+     * Sleeping bodies are masked out rather than skipped, so that the loop
+     * has no branches. Gravity is an impulse proportional to the mass, so it
+     * does not move bodies without a mass either.
+     */
+    for(size_t i = first; i < last; i ++)
+    {
+        float awake = (flags[i] & SLEEPING) ? 0.0f : 1.0f;
+        float falling = inverseMasses[i] > 0 ? awake : 0.0f;
+        for(int j = 0; j < 3; j ++)
+        {
+            positions[i][j] += velocities[i][j] * dt * awake;
+            velocities[i][j] += gravity[j] * dt * falling;
+        }
+    }
+}
+
+void BodyStore::integrate(float dt, const Vector3f &gravity, ThreadPool *pool)
+{
+    size_t chunkCount = (bodies.size() + BODY_CHUNK_SIZE - 1) / BODY_CHUNK_SIZE;
+    if(!pool || chunkCount < 2)
+    {
+        integrateRange(0, bodies.size(), dt, gravity);
+        return;
+    }
+
+    pool->parallelFor(chunkCount, [&](size_t chunk)
+    {
+        size_t first = chunk * BODY_CHUNK_SIZE;
+        size_t last = min(first + BODY_CHUNK_SIZE, bodies.size());
+        integrateRange(first, last, dt, gravity);
+    });
+}
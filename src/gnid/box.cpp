@@ -1,8 +1,11 @@
 #include "gnid/box.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <utility>
 #include "gnid/matrix/matrix.hpp"
 
+using namespace std;
 using namespace gnid;
 using namespace tmat;
 
@@ -46,6 +49,28 @@ void Box::add(const Box &box)
     count_ ++;
 }
 
+void Box::add(
+        const Shape &shape,
+        const Matrix4f &shapeToWorld,
+        const Matrix4f &worldToShape)
+{
+    /* Calculate the extents in local space. */
+    auto forward = transformDirection(worldToShape, Vector3f::forward);
+    auto backward = transformDirection(worldToShape, -Vector3f::forward);
+    auto right = transformDirection(worldToShape, Vector3f::right);
+    auto left = transformDirection(worldToShape, -Vector3f::right);
+    auto up = transformDirection(worldToShape, Vector3f::up);
+    auto down = transformDirection(worldToShape, -Vector3f::up);
+
+    /* Convert to world space and add to the box. */
+    add(transform(shapeToWorld, shape.support(forward)));
+    add(transform(shapeToWorld, shape.support(backward)));
+    add(transform(shapeToWorld, shape.support(left)));
+    add(transform(shapeToWorld, shape.support(right)));
+    add(transform(shapeToWorld, shape.support(up)));
+    add(transform(shapeToWorld, shape.support(down)));
+}
+
 bool Box::overlaps(const Box &other) const
 {
     assert(count() > 0);
@@ -69,6 +94,60 @@ bool Box::contains(const Vector3f &other) const
     return min() <= other && max() >= other;
 }
 
+float Box::distance(const Vector3f &point) const
+{
+    assert(count() > 0);
+
+    float distanceSquared = 0;
+    for(int i = 0; i < 3; i ++)
+    {
+        float gap = 0;
+        if(point[i] < min()[i])
+            gap = min()[i] - point[i];
+        else if(point[i] > max()[i])
+            gap = point[i] - max()[i];
+        distanceSquared += gap * gap;
+    }
+    return sqrt(distanceSquared);
+}
+
+bool Box::raycast(
+        float &distance,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    assert(count() > 0);
+
+    /* Clip the ray against each pair of planes. */
+    float enter = 0;
+    float exit = maxDistance;
+    for(int i = 0; i < 3; i ++)
+    {
+        if(direction[i] == 0)
+        {
+            if(origin[i] < min()[i] || origin[i] > max()[i])
+                return false;
+            continue;
+        }
+
+        float near = (min()[i] - origin[i]) / direction[i];
+        float far = (max()[i] - origin[i]) / direction[i];
+        if(near > far)
+            swap(near, far);
+
+        if(near > enter)
+            enter = near;
+        if(far < exit)
+            exit = far;
+        if(enter > exit)
+            return false;
+    }
+
+    distance = enter;
+    return true;
+}
+
 Vector3f Box::center() const
 {
     assert(count() > 0);
@@ -0,0 +1,895 @@
+#include "gnid/bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "gnid/collider.hpp"
+
+using namespace std;
+using namespace tmat;
+using namespace gnid;
+
+/* The number of bins used when searching for the best split. */
+static const int BIN_COUNT = 16;
+
+/* The cost of traversing a node relative to testing a pair of boxes. */
+static const float TRAVERSAL_COST = 1.0f;
+
+/**
+ * \brief Returns half the surface area of the given bounds
+ */
+static float area(const float *min, const float *max)
+{
+    float x = max[0] - min[0];
+    float y = max[1] - min[1];
+    float z = max[2] - min[2];
+    return x * y + y * z + z * x;
+}
+
+/**
+ * \brief Grow the first bounds to contain the second
+ */
+static void grow(float *min, float *max, const float *otherMin, const float *otherMax)
+{
+    for(int i = 0; i < 3; i ++)
+    {
+        if(otherMin[i] < min[i])
+            min[i] = otherMin[i];
+        if(otherMax[i] > max[i])
+            max[i] = otherMax[i];
+    }
+}
+
+/**
+ * \brief Clear the bounds so that growing them takes the other bounds
+ */
+static void empty(float *min, float *max)
+{
+    for(int i = 0; i < 3; i ++)
+    {
+        min[i] = numeric_limits<float>::infinity();
+        max[i] = -numeric_limits<float>::infinity();
+    }
+}
+
+template<typename T, typename U>
+static bool overlaps(const T &a, const U &b)
+{
+    for(int i = 0; i < 3; i ++)
+    {
+        if(a.max[i] < b.min[i] || a.min[i] > b.max[i])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * \brief
+ *     Find where a ray from the origin enters the given bounds grown by a box
+ *     moving along the ray
+ *
+ * \details
+ *     Returns false if the box does not reach the bounds within maxDistance.
+ */
+template<typename T>
+static bool enters(
+        float &distance,
+        const T &bounds,
+        const float *boxMin,
+        const float *boxMax,
+        const Vector3f &direction,
+        float maxDistance)
+{
+    float enter = 0;
+    float exit = maxDistance;
+    for(int i = 0; i < 3; i ++)
+    {
+        float min = bounds.min[i] - boxMax[i];
+        float max = bounds.max[i] - boxMin[i];
+
+        if(direction[i] == 0)
+        {
+            if(min > 0 || max < 0)
+                return false;
+            continue;
+        }
+
+        float near = min / direction[i];
+        float far = max / direction[i];
+        if(near > far)
+            swap(near, far);
+
+        if(near > enter)
+            enter = near;
+        if(far < exit)
+            exit = far;
+        if(enter > exit)
+            return false;
+    }
+
+    distance = enter;
+    return true;
+}
+
+/**
+ * \brief Returns the squared distance between the bounds and the query bounds
+ */
+template<typename T>
+static float distanceSquared(const T &bounds, const float *min, const float *max)
+{
+    float distance = 0;
+    for(int i = 0; i < 3; i ++)
+    {
+        float gap = 0;
+        if(bounds.max[i] < min[i])
+            gap = min[i] - bounds.max[i];
+        else if(bounds.min[i] > max[i])
+            gap = bounds.min[i] - max[i];
+        distance += gap * gap;
+    }
+    return distance;
+}
+
+Bvh::Bvh(unsigned int maxCollidersPerLeaf)
+    : maxCollidersPerLeaf_(max(maxCollidersPerLeaf, 1u)),
+      rebuildThreshold_(1.5f),
+      builtCost_(0),
+      needsRebuild_(false)
+{
+}
+
+void Bvh::add(shared_ptr<Collider> collider)
+{
+    assert(indices_.find(collider.get()) == end(indices_));
+
+    indices_[collider.get()] = colliders_.size();
+    colliders_.push_back(collider);
+    needsRebuild_ = true;
+}
+
+void Bvh::remove(shared_ptr<Collider> collider)
+{
+    auto it = indices_.find(collider.get());
+    if(it == end(indices_))
+        return;
+
+    /*
+     * Leave the slot empty until the tree is rebuilt, so that the items of
+     * the current tree still refer to the right colliders.
+     */
+    colliders_[it->second] = nullptr;
+    indices_.erase(it);
+    needsRebuild_ = true;
+}
+
+void Bvh::clear()
+{
+    nodes_.clear();
+    items_.clear();
+    colliders_.clear();
+    indices_.clear();
+    builtCost_ = 0;
+    needsRebuild_ = false;
+}
+
+void Bvh::update()
+{
+    if(needsRebuild_)
+    {
+        regenerate();
+        return;
+    }
+
+    if(nodes_.empty())
+        return;
+
+    updateItems();
+
+    /* Rebuild if refitting made the tree too expensive. */
+    if(refit() > builtCost_ * rebuildThreshold_)
+        regenerate();
+}
+
+void Bvh::regenerate()
+{
+    needsRebuild_ = false;
+    nodes_.clear();
+
+    /* Close the gaps left by removed colliders. */
+    colliders_.erase(
+            std::remove(begin(colliders_), end(colliders_), nullptr),
+            end(colliders_));
+    for(unsigned int i = 0; i < colliders_.size(); i ++)
+        indices_[colliders_[i].get()] = i;
+
+    items_.resize(colliders_.size());
+
+    if(colliders_.empty())
+    {
+        builtCost_ = 0;
+        return;
+    }
+
+    for(unsigned int i = 0; i < items_.size(); i ++)
+        items_[i].collider = i;
+    updateItems();
+
+    nodes_.reserve(2 * items_.size() - 1);
+    build(0, items_.size());
+    builtCost_ = refit();
+}
+
+void Bvh::updateItems()
+{
+    for(auto &item : items_)
+    {
+        const auto &collider = colliders_[item.collider];
+        const Box &box = collider->box();
+        for(int i = 0; i < 3; i ++)
+        {
+            item.min[i] = box.min()[i];
+            item.max[i] = box.max()[i];
+        }
+        item.isStatic = collider->isStatic();
+    }
+}
+
+void Bvh::build(unsigned int first, unsigned int count)
+{
+    const unsigned int index = nodes_.size();
+    nodes_.emplace_back();
+
+    /* Calculate the bounds of the items and of their centers. */
+    float min[3], max[3], centerMin[3], centerMax[3];
+    empty(min, max);
+    empty(centerMin, centerMax);
+    for(unsigned int i = first; i < first + count; i ++)
+    {
+        float center[3];
+        for(int j = 0; j < 3; j ++)
+            center[j] = items_[i].min[j] + items_[i].max[j];
+        grow(min, max, items_[i].min, items_[i].max);
+        grow(centerMin, centerMax, center, center);
+    }
+
+    /* Stop if there are few enough items for a leaf. */
+    if(count <= maxCollidersPerLeaf_)
+    {
+        nodes_[index].first = first;
+        nodes_[index].count = count;
+        return;
+    }
+
+    /* Find the split plane with the lowest cost across all three axes. */
+    float bestCost = numeric_limits<float>::infinity();
+    int bestAxis = -1;
+    int bestSplit = 0;
+
+    for(int axis = 0; axis < 3; axis ++)
+    {
+        float extent = centerMax[axis] - centerMin[axis];
+        if(extent <= 0)
+            continue;
+
+        unsigned int binCounts[BIN_COUNT] = { 0 };
+        float binMin[BIN_COUNT][3], binMax[BIN_COUNT][3];
+        for(int i = 0; i < BIN_COUNT; i ++)
+            empty(binMin[i], binMax[i]);
+
+        /* Sort the items into bins by their centers. */
+        float scale = BIN_COUNT / extent;
+        for(unsigned int i = first; i < first + count; i ++)
+        {
+            float center = items_[i].min[axis] + items_[i].max[axis];
+            int bin = std::min(
+                    BIN_COUNT - 1,
+                    static_cast<int>((center - centerMin[axis]) * scale));
+            binCounts[bin] ++;
+            grow(binMin[bin], binMax[bin], items_[i].min, items_[i].max);
+        }
+
+        /* Sweep from the left to find the cost of each left side. */
+        float leftCosts[BIN_COUNT - 1];
+        unsigned int leftCounts[BIN_COUNT - 1];
+        float sweepMin[3], sweepMax[3];
+        unsigned int sweepCount = 0;
+        empty(sweepMin, sweepMax);
+        for(int i = 0; i < BIN_COUNT - 1; i ++)
+        {
+            sweepCount += binCounts[i];
+            if(binCounts[i])
+                grow(sweepMin, sweepMax, binMin[i], binMax[i]);
+            leftCounts[i] = sweepCount;
+            leftCosts[i] = sweepCount ? sweepCount * area(sweepMin, sweepMax) : 0;
+        }
+
+        /* Sweep from the right and combine with the left side. */
+        sweepCount = 0;
+        empty(sweepMin, sweepMax);
+        for(int i = BIN_COUNT - 1; i > 0; i --)
+        {
+            sweepCount += binCounts[i];
+            if(binCounts[i])
+                grow(sweepMin, sweepMax, binMin[i], binMax[i]);
+
+            /* Both sides must have at least one item. */
+            if(sweepCount == 0 || leftCounts[i - 1] == 0)
+                continue;
+
+            float cost = leftCosts[i - 1] + sweepCount * area(sweepMin, sweepMax);
+            if(cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+
+    /* Partition the items. */
+    unsigned int leftCount;
+    if(bestAxis < 0)
+    {
+        /* All of the centers are the same, so just split in half. */
+        leftCount = count / 2;
+    }
+    else
+    {
+        float scale = BIN_COUNT / (centerMax[bestAxis] - centerMin[bestAxis]);
+        float origin = centerMin[bestAxis];
+        auto middle = partition(
+                begin(items_) + first,
+                begin(items_) + first + count,
+                [bestAxis, bestSplit, scale, origin](const Item &item)
+                {
+                    float center = item.min[bestAxis] + item.max[bestAxis];
+                    int bin = std::min(
+                            BIN_COUNT - 1,
+                            static_cast<int>((center - origin) * scale));
+                    return bin < bestSplit;
+                });
+        leftCount = middle - (begin(items_) + first);
+    }
+
+    assert(leftCount > 0 && leftCount < count);
+
+    nodes_[index].count = 0;
+    build(first, leftCount);
+    nodes_[index].right = nodes_.size();
+    build(first + leftCount, count - leftCount);
+}
+
+float Bvh::refit()
+{
+    float cost = 0;
+
+    /* Children always come after their parents, so go backwards. */
+    for(unsigned int i = nodes_.size(); i -- > 0; )
+    {
+        Node &node = nodes_[i];
+        empty(node.min, node.max);
+
+        if(node.isLeaf())
+        {
+            node.hasNonStaticColliders = false;
+            for(unsigned int j = node.first; j < node.first + node.count; j ++)
+            {
+                grow(node.min, node.max, items_[j].min, items_[j].max);
+                if(!items_[j].isStatic)
+                    node.hasNonStaticColliders = true;
+            }
+            cost += area(node.min, node.max) * node.count;
+        }
+        else
+        {
+            const Node &left = nodes_[i + 1];
+            const Node &right = nodes_[node.right];
+            grow(node.min, node.max, left.min, left.max);
+            grow(node.min, node.max, right.min, right.max);
+            node.hasNonStaticColliders =
+                left.hasNonStaticColliders || right.hasNonStaticColliders;
+            cost += area(node.min, node.max) * TRAVERSAL_COST;
+        }
+    }
+
+    /* Make the cost relative to the size of the root. */
+    float rootArea = area(nodes_[0].min, nodes_[0].max);
+    return rootArea > 0 ? cost / rootArea : cost;
+}
+
+void Bvh::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list) const
+{
+    /* Colliders were added or removed without calling update(). */
+    assert(!needsRebuild_);
+
+    if(nodes_.empty())
+        return;
+
+    /*
+     * Pairs of nodes to check. A pair of the same node means to check the node
+     * against itself.
+     */
+    vector<pair<unsigned int, unsigned int>> stack;
+    stack.emplace_back(0, 0);
+
+    while(!stack.empty())
+    {
+        auto [a, b] = stack.back();
+        stack.pop_back();
+
+        const Node &first = nodes_[a];
+        const Node &second = nodes_[b];
+
+        /* Static colliders never need to be checked against each other. */
+        if(!first.hasNonStaticColliders && !second.hasNonStaticColliders)
+            continue;
+
+        /* Check a node against itself. */
+        if(a == b)
+        {
+            if(first.isLeaf())
+            {
+                listOverlappingItems(list, first, first);
+            }
+            else
+            {
+                stack.emplace_back(a + 1, a + 1);
+                stack.emplace_back(first.right, first.right);
+                stack.emplace_back(a + 1, first.right);
+            }
+        }
+        /* Check two different nodes against each other. */
+        else if(overlaps(first, second))
+        {
+            if(first.isLeaf() && second.isLeaf())
+            {
+                listOverlappingItems(list, first, second);
+            }
+            /* Descend into the larger node. */
+            else if(second.isLeaf()
+                    || (!first.isLeaf()
+                        && area(first.min, first.max)
+                            >= area(second.min, second.max)))
+            {
+                stack.emplace_back(a + 1, b);
+                stack.emplace_back(first.right, b);
+            }
+            else
+            {
+                stack.emplace_back(a, b + 1);
+                stack.emplace_back(a, second.right);
+            }
+        }
+    }
+}
+
+void Bvh::listOverlappingItems(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list,
+        const Node &first,
+        const Node &second) const
+{
+    const bool same = &first == &second;
+
+    for(unsigned int i = first.first; i < first.first + first.count; i ++)
+    {
+        /* Only check each pair once when checking a leaf against itself. */
+        unsigned int start = same ? i + 1 : second.first;
+
+        for(unsigned int j = start; j < second.first + second.count; j ++)
+        {
+            const Item &a = items_[i];
+            const Item &b = items_[j];
+
+            if((!a.isStatic || !b.isStatic) && overlaps(a, b))
+            {
+                list.emplace_back(colliders_[a.collider], colliders_[b.collider]);
+            }
+        }
+    }
+}
+
+void Bvh::listAllNodes(vector<shared_ptr<Collider>> &list) const
+{
+    for(auto &collider : colliders_)
+    {
+        if(collider)
+            list.push_back(collider);
+    }
+}
+
+bool Bvh::raycast(
+        RaycastHit &hit,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    /* A ray is a box of size zero. */
+    float point[3] = { origin[0], origin[1], origin[2] };
+
+    float entry;
+    if(nodes_.empty()
+        || !enters(entry, nodes_[0], point, point, direction, maxDistance))
+    {
+        return false;
+    }
+
+    return cast(
+            hit,
+            0,
+            point,
+            point,
+            direction,
+            maxDistance,
+            [&](RaycastHit &out, const Collider &collider, float distance)
+            {
+                return collider.raycast(out, origin, direction, distance);
+            });
+}
+
+bool Bvh::sweep(
+        RaycastHit &hit,
+        const Shape &shape,
+        const Matrix4f &shapeToWorld,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    if(nodes_.empty())
+        return false;
+
+    Box box;
+    box.add(shape, shapeToWorld, shapeToWorld.inverse());
+
+    float boxMin[3] = { box.min()[0], box.min()[1], box.min()[2] };
+    float boxMax[3] = { box.max()[0], box.max()[1], box.max()[2] };
+
+    float entry;
+    if(!enters(entry, nodes_[0], boxMin, boxMax, direction, maxDistance))
+        return false;
+
+    return cast(
+            hit,
+            0,
+            boxMin,
+            boxMax,
+            direction,
+            maxDistance,
+            [&](RaycastHit &out, const Collider &collider, float distance)
+            {
+                return collider.sweep(
+                        out,
+                        shape,
+                        shapeToWorld,
+                        direction,
+                        distance);
+            });
+}
+
+template<typename Test>
+bool Bvh::cast(
+        RaycastHit &hit,
+        unsigned int index,
+        const float *boxMin,
+        const float *boxMax,
+        const Vector3f &direction,
+        float &maxDistance,
+        const Test &test) const
+{
+    const Node &node = nodes_[index];
+    float distance;
+
+    if(node.isLeaf())
+    {
+        bool found = false;
+        for(unsigned int i = node.first; i < node.first + node.count; i ++)
+        {
+            /* Colliders removed since the last update are not searched. */
+            const Item &item = items_[i];
+            const auto &collider = colliders_[item.collider];
+            if(!collider
+                || !enters(
+                    distance,
+                    item,
+                    boxMin,
+                    boxMax,
+                    direction,
+                    maxDistance))
+            {
+                continue;
+            }
+
+            if(test(hit, *collider, maxDistance))
+            {
+                hit.collider = collider;
+                maxDistance = hit.distance;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    unsigned int children[2] = { index + 1, node.right };
+    float entries[2];
+    bool hits[2];
+    for(int i = 0; i < 2; i ++)
+    {
+        hits[i] = enters(
+                entries[i],
+                nodes_[children[i]],
+                boxMin,
+                boxMax,
+                direction,
+                maxDistance);
+    }
+
+    /* Visit the nearer child first, so that its hits can skip the other. */
+    if(hits[0] && hits[1] && entries[1] < entries[0])
+    {
+        swap(children[0], children[1]);
+        swap(entries[0], entries[1]);
+    }
+
+    bool found = false;
+    for(int i = 0; i < 2; i ++)
+    {
+        if(hits[i]
+            && entries[i] <= maxDistance
+            && cast(
+                hit,
+                children[i],
+                boxMin,
+                boxMax,
+                direction,
+                maxDistance,
+                test))
+        {
+            found = true;
+        }
+    }
+    return found;
+}
+
+void Bvh::queryBox(
+        vector<shared_ptr<Collider>> &list,
+        const Box &box,
+        const QueryFilter &filter) const
+{
+    if(nodes_.empty() || box.count() == 0)
+        return;
+
+    float min[3] = { box.min()[0], box.min()[1], box.min()[2] };
+    float max[3] = { box.max()[0], box.max()[1], box.max()[2] };
+    query(list, 0, min, max, 0, filter);
+}
+
+void Bvh::querySphere(
+        vector<shared_ptr<Collider>> &list,
+        const Vector3f &center,
+        float radius,
+        const QueryFilter &filter) const
+{
+    if(nodes_.empty())
+        return;
+
+    /* A sphere is a box of size zero grown by the radius. */
+    float point[3] = { center[0], center[1], center[2] };
+    query(list, 0, point, point, radius * radius, filter);
+}
+
+void Bvh::query(
+        vector<shared_ptr<Collider>> &list,
+        unsigned int index,
+        const float *min,
+        const float *max,
+        float radiusSquared,
+        const QueryFilter &filter) const
+{
+    const Node &node = nodes_[index];
+    if(distanceSquared(node, min, max) > radiusSquared)
+        return;
+
+    /* Subtrees of static colliders can be skipped as a whole. */
+    if(!filter.staticColliders && !node.hasNonStaticColliders)
+        return;
+
+    if(node.isLeaf())
+    {
+        for(unsigned int i = node.first; i < node.first + node.count; i ++)
+        {
+            /* Colliders removed since the last update are not searched. */
+            const Item &item = items_[i];
+            const auto &collider = colliders_[item.collider];
+            if(!collider)
+                continue;
+
+            if(distanceSquared(item, min, max) <= radiusSquared
+                && filter.accepts(*collider))
+            {
+                list.push_back(collider);
+            }
+        }
+        return;
+    }
+
+    query(list, index + 1, min, max, radiusSquared, filter);
+    query(list, node.right, min, max, radiusSquared, filter);
+}
+
+void Bvh::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        const Vector3f &point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
+{
+    if(nodes_.empty())
+        return;
+
+    float p[3] = { point[0], point[1], point[2] };
+    queryNearest(list, 0, p, count, maxDistance, filter);
+}
+
+void Bvh::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        unsigned int index,
+        const float *point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
+{
+    /* Once the list is full, only nearer colliders are of interest. */
+    if(list.size() >= count)
+    {
+        if(count == 0)
+            return;
+        maxDistance = min(maxDistance, list.back().first);
+    }
+
+    const Node &node = nodes_[index];
+    if(!filter.staticColliders && !node.hasNonStaticColliders)
+        return;
+
+    if(node.isLeaf())
+    {
+        for(unsigned int i = node.first; i < node.first + node.count; i ++)
+        {
+            const Item &item = items_[i];
+            const auto &collider = colliders_[item.collider];
+            if(!collider)
+                continue;
+
+            float distance = distanceSquared(item, point, point);
+            if(distance > maxDistance * maxDistance
+                || !filter.accepts(*collider))
+            {
+                continue;
+            }
+
+            CollisionPruner::insertNearest(
+                    list,
+                    count,
+                    sqrt(distance),
+                    collider);
+            if(list.size() >= count)
+                maxDistance = min(maxDistance, list.back().first);
+        }
+        return;
+    }
+
+    /* Visit the nearer child first so that more of the other is skipped. */
+    unsigned int children[2] = { index + 1, node.right };
+    float distances[2] = {
+        distanceSquared(nodes_[children[0]], point, point),
+        distanceSquared(nodes_[children[1]], point, point)
+    };
+    if(distances[1] < distances[0])
+    {
+        swap(children[0], children[1]);
+        swap(distances[0], distances[1]);
+    }
+
+    for(int i = 0; i < 2; i ++)
+    {
+        if(list.size() >= count)
+            maxDistance = min(maxDistance, list.back().first);
+        if(distances[i] <= maxDistance * maxDistance)
+            queryNearest(list, children[i], point, count, maxDistance, filter);
+    }
+}
+
+int Bvh::depth() const
+{
+    if(nodes_.empty())
+        return 0;
+    return depth(0);
+}
+
+int Bvh::depth(unsigned int index) const
+{
+    const Node &node = nodes_[index];
+    if(node.isLeaf())
+        return 1;
+    return 1 + max(depth(index + 1), depth(node.right));
+}
+
+BvhPruner::BvhPruner(shared_ptr<Bvh> bvh)
+    : bvh_(bvh)
+{
+}
+
+void BvhPruner::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list) const
+{
+    bvh_->listOverlappingNodes(list);
+}
+
+void BvhPruner::listAllNodes(vector<shared_ptr<Collider>> &list) const
+{
+    bvh_->listAllNodes(list);
+}
+
+void BvhPruner::add(shared_ptr<Collider> collider)
+{
+    bvh_->add(collider);
+}
+
+void BvhPruner::remove(shared_ptr<Collider> collider)
+{
+    bvh_->remove(collider);
+}
+
+void BvhPruner::update()
+{
+    bvh_->update();
+}
+
+bool BvhPruner::raycast(
+        RaycastHit &hit,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    return bvh_->raycast(hit, origin, direction.normalized(), maxDistance);
+}
+
+bool BvhPruner::sweep(
+        RaycastHit &hit,
+        const Shape &shape,
+        const Matrix4f &from,
+        const Matrix4f &to) const
+{
+    Vector3f direction;
+    float maxDistance;
+    sweepPath(direction, maxDistance, from, to);
+    return bvh_->sweep(hit, shape, from, direction, maxDistance);
+}
+
+void BvhPruner::queryBox(
+        vector<shared_ptr<Collider>> &list,
+        const Box &box,
+        const QueryFilter &filter) const
+{
+    bvh_->queryBox(list, box, filter);
+}
+
+void BvhPruner::querySphere(
+        vector<shared_ptr<Collider>> &list,
+        const Vector3f &center,
+        float radius,
+        const QueryFilter &filter) const
+{
+    bvh_->querySphere(list, center, radius, filter);
+}
+
+void BvhPruner::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        const Vector3f &point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
+{
+    list.clear();
+    bvh_->queryNearest(list, point, count, maxDistance, filter);
+}
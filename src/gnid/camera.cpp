@@ -36,6 +36,22 @@ const Matrix4f &Camera::viewMatrix() const
     return worldMatrixInverse();
 }
 
+void Camera::savePreviousMatrix()
+{
+    previousWorldMatrix_ = worldMatrix();
+    hasPreviousWorldMatrix_ = true;
+}
+
+const Matrix4f &Camera::previousWorldMatrix() const
+{
+    return previousWorldMatrix_;
+}
+
+bool Camera::hasPreviousWorldMatrix() const
+{
+    return hasPreviousWorldMatrix_;
+}
+
 void Camera::onSceneChanged(shared_ptr<Scene> newScene)
 {
     auto oldScene = getScene().lock();
@@ -1,16 +1,35 @@
 #include "gnid/collider.hpp"
 
+#include "gnid/box.hpp"
+#include "gnid/capsule.hpp"
+#include "gnid/distanceresult.hpp"
 #include "gnid/matrix/matrix.hpp"
+#include "gnid/raycasthit.hpp"
 #include "gnid/scene.hpp"
 #include "gnid/rigidbody.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/trianglemesh.hpp"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <limits>
-#include <map>
-#include <queue>
 
 using namespace gnid;
 using namespace tmat;
 
+/*
+ * The most points EPA adds before returning the closest triangle found so far.
+ */
+static const int MAX_EPA_ITERATIONS = 128;
+
+/* How far behind a triangle a new EPA vertex can be and still see it. */
+static const float EPA_COPLANAR_TOLERANCE = 1e-6f;
+
+thread_local Collider::Polytope Collider::polytope_;
+
+thread_local vector<uint32_t> Collider::meshTriangles_;
+
 Collider::NearestSimplexFunction
 Collider::nearestSimplexFunctions[4] = {
     &Collider::nearestSimplex1,
@@ -19,8 +38,53 @@ Collider::nearestSimplexFunctions[4] = {
     &Collider::nearestSimplex4
 };
 
+Collider::OverlapFunction
+Collider::overlapFunctions[Shape::TYPE_COUNT][Shape::TYPE_COUNT] = {
+    /* SPHERE */
+    {
+        &Collider::overlapSphereSphere,
+        &Collider::overlapSphereCapsule,
+        &Collider::overlapSphereBox,
+        nullptr,
+        nullptr,
+        nullptr
+    },
+    /* CAPSULE */
+    {
+        &Collider::overlapCapsuleSphere,
+        &Collider::overlapCapsuleCapsule,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr
+    },
+    /* BOX */
+    {
+        &Collider::overlapBoxSphere,
+        nullptr,
+        &Collider::overlapBoxBox,
+        nullptr,
+        nullptr,
+        nullptr
+    },
+    /* HULL */
+    { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr },
+    /* MESH, which is handled before the table is used */
+    { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr },
+    /* OTHER */
+    { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr }
+};
+
+/*
+ * How far from a right angle the axes of a collider's world matrix can be for
+ * the closed form overlap tests to be used, and how uneven its scale can be
+ * for spheres and capsules.
+ */
+static const float AXIS_TOLERANCE = 1e-4f;
+
 Collider::Collider(shared_ptr<Shape> shape)
-    : shape_(shape)
+    : shape_(shape),
+      forceUpdateBox_(true)
 {
     collisionEntered_ = makeCollisionObservable(collisionEnteredObservers);
     collisionExited_ = makeCollisionObservable(collisionExitedObservers);
@@ -64,39 +128,24 @@ void Collider::notifyCollisionObservers(
     }
 }
 
-void Collider::calcBox()
+bool Collider::calcBox()
 {
     /* Only update if the node has moved. */
-    if(moved() || forceUpdateBox_)
+    bool updated = moved() || forceUpdateBox_;
+    if(updated)
         updateBox();
     forceUpdateBox_ = false;
+    return updated;
 }
 
 void Collider::updateBox()
 {
-    const auto &thisToWorld = worldMatrix();
-    const auto &worldToThis = worldMatrixInverse();
-
-    /* Calculate the extents in local space. */
-    auto forward = transformDirection(worldToThis, Vector3f::forward);
-    auto backward = transformDirection(worldToThis, -Vector3f::forward);
-    auto right = transformDirection(worldToThis, Vector3f::right);
-    auto left = transformDirection(worldToThis, -Vector3f::right);
-    auto up = transformDirection(worldToThis, Vector3f::up);
-    auto down = transformDirection(worldToThis, -Vector3f::up);
-
-    /* Convert to world space and add to the box. */
     box_.clear();
-    box_.add(transform(thisToWorld, shape()->support(forward)));
-    box_.add(transform(thisToWorld, shape()->support(backward)));
-    box_.add(transform(thisToWorld, shape()->support(left)));
-    box_.add(transform(thisToWorld, shape()->support(right)));
-    box_.add(transform(thisToWorld, shape()->support(up)));
-    box_.add(transform(thisToWorld, shape()->support(down)));
+    box_.add(*shape(), worldMatrix(), worldMatrixInverse());
 }
 
 bool Collider::nearestSimplex1(
-        vector<Vector3f> &s,
+        Simplex &s,
         Vector3f &d) const
 {
     assert(s.size() == 1);
@@ -107,7 +156,7 @@ bool Collider::nearestSimplex1(
 }
 
 bool Collider::nearestSimplex2(
-        vector<Vector3f> &s,
+        Simplex &s,
         Vector3f &d) const
 {
     Vector3f ab = s[1] - s[0];
@@ -134,7 +183,7 @@ bool Collider::nearestSimplex2(
 }
 
 bool Collider::nearestSimplex3(
-        vector<Vector3f> &s,
+        Simplex &s,
         Vector3f &d) const
 {
     Vector3f ac = s[2] - s[0];
@@ -233,7 +282,7 @@ bool Collider::nearestSimplex3(
 }
 
 bool Collider::nearestSimplex4(
-        vector<Vector3f> &s,
+        Simplex &s,
         Vector3f &d) const
 {
     Vector3f ad = s[3] - s[0];
@@ -295,7 +344,7 @@ bool Collider::nearestSimplex4(
             else
             {
                 /* Choose the nearest face. */
-                vector<Vector3f> s1, s2;
+                Simplex s1, s2;
                 Vector3f d1, d2;
 
                 /* Create simplices for the triangles. */
@@ -345,7 +394,7 @@ bool Collider::nearestSimplex4(
         else
         {
             /* Choose the nearest face. */
-            vector<Vector3f> s1, s2;
+            Simplex s1, s2;
             Vector3f d1, d2;
 
             /* Create simplices for the triangles. */
@@ -383,7 +432,7 @@ bool Collider::nearestSimplex4(
     else
     {
         /* Choose the nearest face. */
-        vector<Vector3f> s1, s2;
+        Simplex s1, s2;
         Vector3f d1, d2;
 
         /* Create simplices for the triangles. */
@@ -419,7 +468,7 @@ bool Collider::nearestSimplex4(
 }
 
 bool Collider::nearestSimplex(
-        vector<Vector3f> &s,
+        Simplex &s,
         Vector3f &d) const
 {
     NearestSimplexFunction function;
@@ -430,55 +479,55 @@ bool Collider::nearestSimplex(
     return (this->*function)(s, d);
 }
 
-Collider::Triangle::Triangle(
-        const int ia,
-        const int ib,
-        const int ic,
-        const vector<Vector3f> &vertices)
-    : ia(ia), ib(ib), ic(ic)
+bool Collider::getOverlap(
+        Vector3f &out,
+        Vector3f &initialAxis,
+        const shared_ptr<Collider> &other,
+        const float tolerance) const
 {
-    auto ac = vertices[ic] - vertices[ia];
-    auto bc = vertices[ic] - vertices[ib];
-
-    normal_ = ac.cross(bc);
-
-    /* Just use right if the cross product is zero. */
-    if(normal_[0] == 0 && normal_[1] == 0 && normal_[2] == 0)
+    /* Meshes are tested one triangle at a time, and never with each other. */
+    if(other->shape_->type() == Shape::MESH)
     {
-        normal_ = Vector3f::right;
-        distance_ = 0;
-    }
-    /* Otherwise normalize the normal. */
-    else
-    {
-        normal_.normalize();
-        distance_ = normal_.dot(vertices[ic]);
+        if(shape_->type() == Shape::MESH)
+            return false;
+        return getMeshOverlap(out, *other, tolerance);
     }
-
-    /* If we have negative distance, flip the triangle. */
-    if(distance_ < 0)
+    if(shape_->type() == Shape::MESH)
     {
-        swap(this->ia, this->ic);
-        normal_ = -normal_;
-        distance_ = -distance_;
+        bool overlapping = other->getMeshOverlap(out, *this, tolerance);
+        out = -out;
+        return overlapping;
     }
-}
 
-bool Collider::Triangle::operator<(const Triangle &other) const
-{
-    return distance_ > other.distance_;
+    /* Use the closed form test for the pair of shapes if there is one. */
+    auto function =
+        overlapFunctions[shape_->type()][other->shape_->type()];
+    bool overlapping;
+    if(function && (this->*function)(overlapping, out, *other))
+        return overlapping;
+
+    return getShapeOverlap(
+            out,
+            initialAxis,
+            *other->shape_,
+            other->worldMatrix(),
+            other->worldMatrixInverse(),
+            tolerance);
 }
 
-bool Collider::getOverlap(
+bool Collider::getShapeOverlap(
         Vector3f &out,
         Vector3f &initialAxis,
-        const shared_ptr<Collider> &other,
+        const Shape &otherShape,
+        const Matrix4f &otherToWorld,
+        const Matrix4f &worldToOther,
         const float tolerance) const
 {
     const auto &thisToWorld = worldMatrix();
     const auto &worldToThis = worldMatrixInverse();
-    const auto &otherToWorld = other->worldMatrix();
-    const auto &worldToOther = other->worldMatrixInverse();
+
+    if(initialAxis == Vector3f::zero)
+        initialAxis = Vector3f::right;
 
     Vector3f a =
         transform(
@@ -487,15 +536,22 @@ bool Collider::getOverlap(
                     transformDirection(worldToThis, initialAxis)))
         - transform(
                 otherToWorld,
-                other->shape()->support(
+                otherShape.support(
                     transformDirection(worldToOther, -initialAxis)));
 
-    vector<Vector3f> s;
+    /*
+     * If the initial axis still separates the shapes, which is usually the
+     * case when it is the axis found last frame, we're done.
+     */
+    if(a.dot(initialAxis) < 0)
+        return false;
+
+    Simplex s;
     s.push_back(a);
 
     Vector3f d = -a;
 
-    if(gjk(d, s, other))
+    if(gjk(d, s, otherShape, otherToWorld, worldToOther))
     {
         /*
          * If the overlap is on a line, point, or triangle, we know that the
@@ -508,35 +564,27 @@ bool Collider::getOverlap(
         /* Otherwise, perform the Expanding Polytope Algorithm (EPA). */
         else
         {
-            /* Create a triangular mesh from the simplex. */
-            priority_queue<Triangle> triangles;
-            vector<Vector3f> &vertices = s;
-            
-            /* Create indices for the simplex. */
-            triangles.emplace(0, 2, 1, vertices);
-            triangles.emplace(0, 1, 3, vertices);
-            triangles.emplace(1, 2, 3, vertices);
-            triangles.emplace(2, 0, 3, vertices);
-
-            epa(out, triangles, vertices, other, tolerance);
+            epa(out, s, otherShape, otherToWorld, worldToOther, tolerance);
         }
 
         /* Return that there was an intersection. */
         return true;
     }
 
+    /* The last search direction separates the shapes. */
+    initialAxis = d;
     return false;
 }
 
 bool Collider::gjk(
         Vector3f &d,
-        vector<Vector3f> &s,
-        const shared_ptr<Collider> &other) const
+        Simplex &s,
+        const Shape &otherShape,
+        const Matrix4f &otherToWorld,
+        const Matrix4f &worldToOther) const
 {
     const auto &thisToWorld = worldMatrix();
     const auto &worldToThis = worldMatrixInverse();
-    const auto &otherToWorld = other->worldMatrix();
-    const auto &worldToOther = other->worldMatrixInverse();
 
     Vector3f a;
 
@@ -548,7 +596,7 @@ bool Collider::gjk(
                         transformDirection(worldToThis, d)))
             - transform(
                     otherToWorld,
-                    other->shape()->support(
+                    otherShape.support(
                         transformDirection(worldToOther, -d)));
 
         if(a.dot(d) <= 0)
@@ -570,22 +618,26 @@ bool Collider::gjk(
 
 void Collider::epa(
         Vector3f &out,
-        priority_queue<Triangle> &triangles,
-        vector<Vector3f> &vertices,
-        const shared_ptr<Collider> &other,
+        const Simplex &s,
+        const Shape &otherShape,
+        const Matrix4f &otherToWorld,
+        const Matrix4f &worldToOther,
         const float tolerance) const
 {
     const auto &thisToWorld = worldMatrix();
     const auto &worldToThis = worldMatrixInverse();
-    const auto &otherToWorld = other->worldMatrix();
-    const auto &worldToOther = other->worldMatrixInverse();
 
-    while(true)
+    Polytope &polytope = polytope_;
+    polytope.reset(s);
+
+    for(int iteration = 0; ; iteration ++)
     {
         /*
-         * Find the closest triangle to the origin on the simplex.
+         * Find the closest triangle to the origin on the polytope.
          */
-        const Triangle triangle = triangles.top();
+        uint32_t closest = polytope.closest();
+        const Vector3f normal = polytope.triangles[closest].normal;
+        const float distance = polytope.triangles[closest].distance;
 
         /*
          * Find the point on the Minkowski difference furthest along
@@ -594,92 +646,1417 @@ void Collider::epa(
         Vector3f a = transform(
                     thisToWorld,
                     shape()->support(
-                        transformDirection(worldToThis, triangle.normal())))
+                        transformDirection(worldToThis, normal)))
             - transform(
                     otherToWorld,
-                    other->shape()->support(
-                        transformDirection(worldToOther, -triangle.normal())));
+                    otherShape.support(
+                        transformDirection(worldToOther, -normal)));
 
         /*
          * If we can't expand the polytope anymore, we're at the closest
          * triangle.
          */
-        if(a.dot(triangle.normal()) - triangle.distance() <= tolerance
-                || a == vertices[vertices.size() - 1])
+        if(a.dot(normal) - distance <= tolerance
+                || a == polytope.vertices.back()
+                || iteration == MAX_EPA_ITERATIONS)
         {
-            out = triangle.normal() * triangle.distance();
+            out = normal * distance;
             break;
         }
+
+        /* Otherwise add the point to the polytope and continue expanding. */
+        polytope.expand(closest, a);
+    }
+}
+
+/**
+ * \brief One triangle of a TriangleMesh as a shape of its own
+ */
+class MeshTriangle : public Shape
+{
+public:
+    MeshTriangle(const array<Vector3f, 3> &corners) : corners_(corners) {}
+
+    Vector3f support(const Vector3f &d) const override
+    {
+        float a = d.dot(corners_[0]);
+        float b = d.dot(corners_[1]);
+        float c = d.dot(corners_[2]);
+        if(a >= b && a >= c)
+            return corners_[0];
+        return b >= c ? corners_[1] : corners_[2];
+    }
+
+private:
+    array<Vector3f, 3> corners_;
+};
+
+bool Collider::getMeshOverlap(
+        Vector3f &out,
+        const Collider &mesh,
+        const float tolerance) const
+{
+    const auto &thisToWorld = worldMatrix();
+    const auto &worldToThis = worldMatrixInverse();
+    const auto &meshToWorld = mesh.worldMatrix();
+    const auto &worldToMesh = mesh.worldMatrixInverse();
+    const auto &triangles = static_cast<const TriangleMesh &>(*mesh.shape_);
+
+    /* Find the triangles near the bounds of this shape in mesh space. */
+    Box box;
+    box.add(*shape_, worldToMesh * thisToWorld, worldToThis * meshToWorld);
+    vector<uint32_t> &candidates = meshTriangles_;
+    candidates.clear();
+    triangles.listOverlappingTriangles(box, candidates);
+
+    /*
+     * Pushing the shape out of the deepest triangle usually pushes it out of
+     * the others too, and any that are left are handled on the next frame.
+     */
+    bool overlapping = false;
+    out = Vector3f::zero;
+    for(uint32_t index : candidates)
+    {
+        MeshTriangle triangle(triangles.triangle(index));
+        Vector3f overlap = Vector3f::zero;
+        Vector3f initialAxis = Vector3f::right;
+        if(getShapeOverlap(
+                    overlap,
+                    initialAxis,
+                    triangle,
+                    meshToWorld,
+                    worldToMesh,
+                    tolerance))
+        {
+            overlapping = true;
+            if(overlap.dot(overlap) > out.dot(out))
+                out = overlap;
+        }
+    }
+    return overlapping;
+}
+
+void Collider::Polytope::reset(const Simplex &simplex)
+{
+    assert(simplex.size() == 4);
+
+    vertices.assign(simplex.begin(), simplex.end());
+    triangles.clear();
+
+    /* Wind the triangles so that their normals face out. */
+    Vector3f ab = vertices[1] - vertices[0];
+    Vector3f ac = vertices[2] - vertices[0];
+    Vector3f ad = vertices[3] - vertices[0];
+    if(ab.cross(ac).dot(ad) > 0)
+        swap(vertices[1], vertices[2]);
+
+    addTriangle(0, 1, 2);
+    addTriangle(0, 3, 1);
+    addTriangle(1, 3, 2);
+    addTriangle(2, 3, 0);
+    connect(0);
+}
+
+void Collider::Polytope::addTriangle(uint32_t a, uint32_t b, uint32_t c)
+{
+    Triangle triangle;
+    triangle.vertices[0] = a;
+    triangle.vertices[1] = b;
+    triangle.vertices[2] = c;
+    for(int i = 0; i < 3; i ++)
+    {
+        triangle.neighbors[i] = NONE;
+        triangle.neighborEdges[i] = NONE;
+    }
+    triangle.removed = false;
+
+    Vector3f ab = vertices[b] - vertices[a];
+    Vector3f ac = vertices[c] - vertices[a];
+    triangle.normal = ab.cross(ac);
+
+    /* Just use right if the cross product is zero. */
+    if(triangle.normal == Vector3f::zero)
+    {
+        triangle.normal = Vector3f::right;
+        triangle.distance = 0;
+    }
+    /* Otherwise normalize the normal. */
+    else
+    {
+        triangle.normal.normalize();
+        triangle.distance = triangle.normal.dot(vertices[a]);
+    }
+
+    triangles.push_back(triangle);
+}
+
+void Collider::Polytope::link(
+        uint32_t first,
+        uint32_t firstEdge,
+        uint32_t second,
+        uint32_t secondEdge)
+{
+    triangles[first].neighbors[firstEdge] = second;
+    triangles[first].neighborEdges[firstEdge] = secondEdge;
+    triangles[second].neighbors[secondEdge] = first;
+    triangles[second].neighborEdges[secondEdge] = firstEdge;
+}
+
+void Collider::Polytope::connect(uint32_t first)
+{
+    /* Neighbors share the same edge, going the opposite way. */
+    for(uint32_t i = first; i < triangles.size(); i ++)
+    {
+        for(uint32_t edge = 0; edge < 3; edge ++)
+        {
+            if(triangles[i].neighbors[edge] != NONE)
+                continue;
+
+            uint32_t start = triangles[i].vertices[edge];
+            uint32_t end = triangles[i].vertices[(edge + 1) % 3];
+            for(uint32_t j = i + 1; j < triangles.size(); j ++)
+            {
+                for(uint32_t other = 0; other < 3; other ++)
+                {
+                    if(triangles[j].vertices[other] == end
+                        && triangles[j].vertices[(other + 1) % 3] == start)
+                    {
+                        link(i, edge, j, other);
+                    }
+                }
+            }
+        }
+    }
+}
+
+uint32_t Collider::Polytope::closest() const
+{
+    uint32_t closest = NONE;
+    for(uint32_t i = 0; i < triangles.size(); i ++)
+    {
+        if(!triangles[i].removed
+            && (closest == NONE
+                || triangles[i].distance < triangles[closest].distance))
+        {
+            closest = i;
+        }
+    }
+    assert(closest != NONE);
+    return closest;
+}
+
+void Collider::Polytope::expand(uint32_t visible, const Vector3f &vertex)
+{
+    stack.clear();
+    horizon.clear();
+
+    /* Walk from the visible triangle, stopping at the hidden ones. */
+    triangles[visible].removed = true;
+    for(uint32_t edge = 0; edge < 3; edge ++)
+    {
+        stack.emplace_back(
+                triangles[visible].neighbors[edge],
+                triangles[visible].neighborEdges[edge]);
+    }
+
+    while(!stack.empty())
+    {
+        auto [index, edge] = stack.back();
+        stack.pop_back();
+
+        Triangle &triangle = triangles[index];
+        if(triangle.removed)
+            continue;
+
         /*
-         * Otherwise add the point to the polytope and continue
-         * expanding.
+         * A hidden triangle's edge is part of the horizon. Nearly coplanar
+         * triangles count as visible, so that rounding can't leave a new
+         * triangle with no area.
          */
+        Vector3f offset = vertex - vertices[triangle.vertices[0]];
+        if(offset.dot(triangle.normal) < -EPA_COPLANAR_TOLERANCE)
+        {
+            horizon.emplace_back(index, edge);
+            continue;
+        }
+
+        triangle.removed = true;
+        for(uint32_t i = 1; i < 3; i ++)
+        {
+            uint32_t next = (edge + i) % 3;
+            stack.emplace_back(
+                    triangle.neighbors[next],
+                    triangle.neighborEdges[next]);
+        }
+    }
+
+    /* Add the new vertex. */
+    uint32_t index = vertices.size();
+    vertices.push_back(vertex);
+
+    /* Create new triangles from the horizon edges to the new vertex. */
+    uint32_t first = triangles.size();
+    for(auto [hidden, edge] : horizon)
+    {
+        uint32_t start = triangles[hidden].vertices[edge];
+        uint32_t end = triangles[hidden].vertices[(edge + 1) % 3];
+        addTriangle(end, start, index);
+        link(triangles.size() - 1, 0, hidden, edge);
+    }
+    connect(first);
+}
+
+/**
+ * \brief A box in world space, which can be rotated
+ */
+class OrientedBox
+{
+public:
+    Vector3f center;
+
+    /* The unit axes of the box. */
+    Vector3f axes[3];
+
+    /* Half of the size of the box along each axis. */
+    float halfSizes[3];
+};
+
+/**
+ * \brief Finds the world space axes of the matrix and their lengths
+ *
+ * \details
+ *     The axes are normalized. Returns false if they are not at right angles,
+ *     for example if the matrix shears.
+ */
+static bool worldAxes(Vector3f *axes, float *scales, const Matrix4f &toWorld)
+{
+    /* The axes are the columns of the matrix. */
+    for(int i = 0; i < 3; i ++)
+    {
+        axes[i] = Vector3f { toWorld[0][i], toWorld[1][i], toWorld[2][i] };
+        scales[i] = axes[i].magnitude();
+        if(scales[i] == 0)
+            return false;
+        axes[i] *= 1 / scales[i];
+    }
+
+    return fabs(axes[0].dot(axes[1])) <= AXIS_TOLERANCE
+        && fabs(axes[1].dot(axes[2])) <= AXIS_TOLERANCE
+        && fabs(axes[2].dot(axes[0])) <= AXIS_TOLERANCE;
+}
+
+/**
+ * \brief Returns where the matrix moves the origin to
+ */
+static Vector3f worldOrigin(const Matrix4f &toWorld)
+{
+    return Vector3f { toWorld[0][3], toWorld[1][3], toWorld[2][3] };
+}
+
+/**
+ * \brief Finds how much the matrix scales distances
+ *
+ * \details
+ *     Returns false if the matrix does not scale evenly along all its axes,
+ *     in which case spheres don't stay spheres.
+ */
+static bool uniformScale(float &scale, const Matrix4f &toWorld)
+{
+    Vector3f axes[3];
+    float scales[3];
+    if(!worldAxes(axes, scales, toWorld))
+        return false;
+
+    scale = scales[0];
+    return fabs(scales[1] - scale) <= AXIS_TOLERANCE * scale
+        && fabs(scales[2] - scale) <= AXIS_TOLERANCE * scale;
+}
+
+static bool worldBox(
+        OrientedBox &out,
+        const Box &box,
+        const Matrix4f &toWorld)
+{
+    float scales[3];
+    if(!worldAxes(out.axes, scales, toWorld))
+        return false;
+
+    out.center = transform(toWorld, box.center());
+    Vector3f size = box.size();
+    for(int i = 0; i < 3; i ++)
+        out.halfSizes[i] = size[i] * scales[i] * 0.5f;
+    return true;
+}
+
+/**
+ * \brief Returns the point on the segment from start to end closest to point
+ */
+static Vector3f closestSegmentPoint(
+        const Vector3f &point,
+        const Vector3f &start,
+        const Vector3f &end)
+{
+    Vector3f direction = end - start;
+    float lengthSquared = direction.dot(direction);
+    if(lengthSquared == 0)
+        return start;
+
+    float t = (point - start).dot(direction) / lengthSquared;
+    return start + direction * min(max(t, 0.0f), 1.0f);
+}
+
+/**
+ * \brief Finds the closest points between two segments
+ *
+ * \details
+ *     See Real-Time Collision Detection by Christer Ericson, section 5.1.9.
+ */
+static void closestSegmentPoints(
+        Vector3f &onA,
+        Vector3f &onB,
+        const Vector3f &startA,
+        const Vector3f &endA,
+        const Vector3f &startB,
+        const Vector3f &endB)
+{
+    Vector3f directionA = endA - startA;
+    Vector3f directionB = endB - startB;
+    Vector3f offset = startA - startB;
+    float a = directionA.dot(directionA);
+    float e = directionB.dot(directionB);
+    float f = directionB.dot(offset);
+
+    /* Both segments are points. */
+    if(a == 0 && e == 0)
+    {
+        onA = startA;
+        onB = startB;
+        return;
+    }
+
+    float s, t;
+    if(a == 0)
+    {
+        s = 0;
+        t = min(max(f / e, 0.0f), 1.0f);
+    }
+    else
+    {
+        float c = directionA.dot(offset);
+        if(e == 0)
+        {
+            t = 0;
+            s = min(max(-c / a, 0.0f), 1.0f);
+        }
         else
         {
-            map<pair<int, int>, int> edgeCounts;
+            float b = directionA.dot(directionB);
+            float denominator = a * e - b * b;
 
-            /* List of triangles to be re-added. */
-            vector<Triangle> okayTriangles;
+            /* Pick any point on the first segment if they are parallel. */
+            s = denominator != 0
+                ? min(max((b * f - c * e) / denominator, 0.0f), 1.0f)
+                : 0;
 
-            /*
-             * Find the triangles "visible" from the added vertex. We only need
-             * to check the ones who are closer than the point.
-             */
-            while(!triangles.empty()
-                    && triangles.top().distance() <= a.magnitude())
+            /* Clamp to the second segment, then find the first point again. */
+            t = (b * s + f) / e;
+            if(t < 0)
             {
-                const Triangle top = triangles.top();
-                triangles.pop();
-
-                /* If the face is "visible", add its edges. */
-                if((a - vertices[top.indexA()]).dot(top.normal()) >= 0)
-                {
-                    /* Add the edges. */
-                    if(top.indexA() < top.indexB())
-                        edgeCounts[make_pair(top.indexA(), top.indexB())] ++;
-                    else
-                        edgeCounts[make_pair(top.indexB(), top.indexA())] ++;
-
-                    if(top.indexB() < top.indexC())
-                        edgeCounts[make_pair(top.indexB(), top.indexC())] ++;
-                    else
-                        edgeCounts[make_pair(top.indexC(), top.indexB())] ++;
-
-                    if(top.indexC() < top.indexA())
-                        edgeCounts[make_pair(top.indexC(), top.indexA())] ++;
-                    else
-                        edgeCounts[make_pair(top.indexA(), top.indexC())] ++;
-                }
-                /* If the face is not "visible", re-add it to the queue. */
-                else
-                {
-                    okayTriangles.push_back(top);
-                }
+                t = 0;
+                s = min(max(-c / a, 0.0f), 1.0f);
+            }
+            else if(t > 1)
+            {
+                t = 1;
+                s = min(max((b - c) / a, 0.0f), 1.0f);
             }
+        }
+    }
 
-            /* Add the new vertex. */
-            vertices.push_back(a);
+    onA = startA + directionA * s;
+    onB = startB + directionB * t;
+}
 
-            /* Re-add the triangles. */
-            for(auto &&triangle : okayTriangles)
+/**
+ * \brief Finds the overlap of two spheres
+ *
+ * \details
+ *     Returns false if the centers are too close together to tell which way
+ *     the spheres should be pushed apart.
+ */
+static bool overlapSpheres(
+        bool &overlapping,
+        Vector3f &out,
+        const Vector3f &centerA,
+        float radiusA,
+        const Vector3f &centerB,
+        float radiusB)
+{
+    Vector3f offset = centerB - centerA;
+    float radius = radiusA + radiusB;
+    float distanceSquared = offset.dot(offset);
+    if(distanceSquared >= radius * radius)
+    {
+        overlapping = false;
+        return true;
+    }
+
+    float distance = sqrt(distanceSquared);
+    if(distance <= AXIS_TOLERANCE * radius)
+        return false;
+
+    overlapping = true;
+    out = offset * ((radius - distance) / distance);
+    return true;
+}
+
+/**
+ * \brief Tests an axis for the separating axis test between two boxes
+ *
+ * \details
+ *     Returns false if the boxes are apart along the axis. Otherwise, if they
+ *     overlap less along it than along the best axis so far, it becomes the
+ *     best axis, pointing from the first box to the second.
+ */
+static bool testBoxAxis(
+        float &bestOverlap,
+        Vector3f &bestAxis,
+        Vector3f axis,
+        const OrientedBox &a,
+        const OrientedBox &b)
+{
+    /* Skip the cross products of nearly parallel edges. */
+    float lengthSquared = axis.dot(axis);
+    if(lengthSquared <= AXIS_TOLERANCE)
+        return true;
+    axis *= 1 / sqrt(lengthSquared);
+
+    float radiusA = 0, radiusB = 0;
+    for(int i = 0; i < 3; i ++)
+    {
+        radiusA += a.halfSizes[i] * fabs(a.axes[i].dot(axis));
+        radiusB += b.halfSizes[i] * fabs(b.axes[i].dot(axis));
+    }
+
+    float distance = (b.center - a.center).dot(axis);
+    float overlap = radiusA + radiusB - fabs(distance);
+    if(overlap <= 0)
+        return false;
+
+    if(overlap < bestOverlap)
+    {
+        bestOverlap = overlap;
+        bestAxis = distance < 0 ? -axis : axis;
+    }
+    return true;
+}
+
+bool Collider::overlapSphereSphere(
+        bool &overlapping,
+        Vector3f &out,
+        const Collider &other) const
+{
+    const auto &toWorld = worldMatrix();
+    const auto &otherToWorld = other.worldMatrix();
+
+    const auto &sphere = static_cast<const Sphere &>(*shape_);
+    const auto &otherSphere = static_cast<const Sphere &>(*other.shape_);
+
+    float scale, otherScale;
+    if(!uniformScale(scale, toWorld)
+        || !uniformScale(otherScale, otherToWorld))
+    {
+        return false;
+    }
+
+    return overlapSpheres(
+            overlapping,
+            out,
+            worldOrigin(toWorld),
+            sphere.radius() * scale,
+            worldOrigin(otherToWorld),
+            otherSphere.radius() * otherScale);
+}
+
+bool Collider::overlapSphereCapsule(
+        bool &overlapping,
+        Vector3f &out,
+        const Collider &other) const
+{
+    const auto &toWorld = worldMatrix();
+    const auto &otherToWorld = other.worldMatrix();
+
+    const auto &sphere = static_cast<const Sphere &>(*shape_);
+    const auto &capsule = static_cast<const Capsule &>(*other.shape_);
+
+    float scale, otherScale;
+    if(!uniformScale(scale, toWorld)
+        || !uniformScale(otherScale, otherToWorld))
+    {
+        return false;
+    }
+
+    /* The capsule is a sphere at the closest point on its segment. */
+    Vector3f center = worldOrigin(toWorld);
+    Vector3f closest = closestSegmentPoint(
+            center,
+            transform(otherToWorld, capsule.start()),
+            transform(otherToWorld, capsule.end()));
+
+    return overlapSpheres(
+            overlapping,
+            out,
+            center,
+            sphere.radius() * scale,
+            closest,
+            capsule.radius() * otherScale);
+}
+
+bool Collider::overlapSphereBox(
+        bool &overlapping,
+        Vector3f &out,
+        const Collider &other) const
+{
+    const auto &toWorld = worldMatrix();
+    const auto &otherToWorld = other.worldMatrix();
+
+    const auto &sphere = static_cast<const Sphere &>(*shape_);
+    const auto &box = static_cast<const Box &>(*other.shape_);
+
+    float scale;
+    OrientedBox world;
+    if(!uniformScale(scale, toWorld)
+        || !worldBox(world, box, otherToWorld))
+    {
+        return false;
+    }
+
+    Vector3f center = worldOrigin(toWorld);
+    float radius = sphere.radius() * scale;
+
+    /* Find the closest point in the box to the center of the sphere. */
+    Vector3f offset = center - world.center;
+    Vector3f closest = world.center;
+    float local[3];
+    bool inside = true;
+    for(int i = 0; i < 3; i ++)
+    {
+        local[i] = offset.dot(world.axes[i]);
+        float clamped =
+            min(max(local[i], -world.halfSizes[i]), world.halfSizes[i]);
+        if(clamped != local[i])
+            inside = false;
+        closest += world.axes[i] * clamped;
+    }
+
+    /* If the center is outside the box, push it away from the closest point. */
+    if(!inside)
+    {
+        Vector3f toBox = closest - center;
+        float distanceSquared = toBox.dot(toBox);
+        overlapping = distanceSquared < radius * radius;
+        if(overlapping)
+        {
+            float distance = sqrt(distanceSquared);
+            out = toBox * ((radius - distance) / distance);
+        }
+        return true;
+    }
+
+    /* Otherwise push it out through the nearest face. */
+    int nearest = 0;
+    float depth = numeric_limits<float>::infinity();
+    for(int i = 0; i < 3; i ++)
+    {
+        float faceDepth = world.halfSizes[i] - fabs(local[i]);
+        if(faceDepth < depth)
+        {
+            depth = faceDepth;
+            nearest = i;
+        }
+    }
+
+    Vector3f normal = local[nearest] > 0
+        ? world.axes[nearest]
+        : -world.axes[nearest];
+    overlapping = true;
+    out = -normal * (depth + radius);
+    return true;
+}
+
+bool Collider::overlapCapsuleSphere(
+        bool &overlapping,
+        Vector3f &out,
+        const Collider &other) const
+{
+    if(!other.overlapSphereCapsule(overlapping, out, *this))
+        return false;
+    out = -out;
+    return true;
+}
+
+bool Collider::overlapCapsuleCapsule(
+        bool &overlapping,
+        Vector3f &out,
+        const Collider &other) const
+{
+    const auto &toWorld = worldMatrix();
+    const auto &otherToWorld = other.worldMatrix();
+
+    const auto &capsule = static_cast<const Capsule &>(*shape_);
+    const auto &otherCapsule = static_cast<const Capsule &>(*other.shape_);
+
+    float scale, otherScale;
+    if(!uniformScale(scale, toWorld)
+        || !uniformScale(otherScale, otherToWorld))
+    {
+        return false;
+    }
+
+    /*
+     * The capsules overlap like spheres at the closest points of their
+     * segments. If the segments cross, GJK is needed to find the depth.
+     */
+    Vector3f closest, otherClosest;
+    closestSegmentPoints(
+            closest,
+            otherClosest,
+            transform(toWorld, capsule.start()),
+            transform(toWorld, capsule.end()),
+            transform(otherToWorld, otherCapsule.start()),
+            transform(otherToWorld, otherCapsule.end()));
+
+    return overlapSpheres(
+            overlapping,
+            out,
+            closest,
+            capsule.radius() * scale,
+            otherClosest,
+            otherCapsule.radius() * otherScale);
+}
+
+bool Collider::overlapBoxSphere(
+        bool &overlapping,
+        Vector3f &out,
+        const Collider &other) const
+{
+    if(!other.overlapSphereBox(overlapping, out, *this))
+        return false;
+    out = -out;
+    return true;
+}
+
+bool Collider::overlapBoxBox(
+        bool &overlapping,
+        Vector3f &out,
+        const Collider &other) const
+{
+    const auto &toWorld = worldMatrix();
+    const auto &otherToWorld = other.worldMatrix();
+
+    OrientedBox a, b;
+    if(!worldBox(a, static_cast<const Box &>(*shape_), toWorld)
+        || !worldBox(b, static_cast<const Box &>(*other.shape_), otherToWorld))
+    {
+        return false;
+    }
+
+    /*
+     * Use the separating axis test. The boxes overlap least along one of their
+     * face normals or the cross product of one edge from each.
+     */
+    float bestOverlap = numeric_limits<float>::infinity();
+    Vector3f bestAxis;
+    overlapping = false;
+    for(int i = 0; i < 3; i ++)
+    {
+        if(!testBoxAxis(bestOverlap, bestAxis, a.axes[i], a, b)
+            || !testBoxAxis(bestOverlap, bestAxis, b.axes[i], a, b))
+        {
+            return true;
+        }
+    }
+    for(int i = 0; i < 3; i ++)
+    {
+        for(int j = 0; j < 3; j ++)
+        {
+            Vector3f axis = a.axes[i].cross(b.axes[j]);
+            if(!testBoxAxis(bestOverlap, bestAxis, axis, a, b))
+                return true;
+        }
+    }
+
+    overlapping = true;
+    out = bestAxis * bestOverlap;
+    return true;
+}
+
+/**
+ * \brief A vertex of the simplex used to cast rays
+ */
+class CastVertex
+{
+public:
+    /* The point on the shape being cast against. */
+    Vector3f point;
+
+    /* The matching point on the collider. */
+    Vector3f witness;
+};
+
+/**
+ * \brief
+ *     Finds the weights of the given points for the point closest to the origin
+ *     on the plane, line or point passing through them
+ *
+ * \details
+ *     Returns false if the points are degenerate, for example if three points
+ *     lie on a line.
+ */
+static bool affineWeights(
+        float *weights,
+        const Vector3f *points,
+        const int *indices,
+        int count)
+{
+    if(count == 1)
+    {
+        weights[0] = 1;
+        return true;
+    }
+
+    /*
+     * The closest point p = q0 + sum(w[k] * e[k]) is found by solving
+     * e[j] . p = 0 for each edge e[j] = q[j] - q0.
+     */
+    const Vector3f &q0 = points[indices[0]];
+    Vector3f e[3];
+    float b[3];
+    for(int j = 1; j < count; j ++)
+    {
+        e[j - 1] = points[indices[j]] - q0;
+        b[j - 1] = -e[j - 1].dot(q0);
+    }
+
+    if(count == 2)
+    {
+        float g = e[0].dot(e[0]);
+        if(g <= 0)
+            return false;
+        weights[1] = b[0] / g;
+    }
+    else if(count == 3)
+    {
+        float g00 = e[0].dot(e[0]);
+        float g01 = e[0].dot(e[1]);
+        float g11 = e[1].dot(e[1]);
+        float det = g00 * g11 - g01 * g01;
+        if(det <= 1e-6f * g00 * g11)
+            return false;
+        weights[1] = (b[0] * g11 - b[1] * g01) / det;
+        weights[2] = (g00 * b[1] - g01 * b[0]) / det;
+    }
+    else
+    {
+        /* Solve the 3x3 system using Cramer's rule. */
+        Vector3f c[3];
+        for(int k = 0; k < 3; k ++)
+            c[k] = Vector3f { e[0].dot(e[k]), e[1].dot(e[k]), e[2].dot(e[k]) };
+        Vector3f rhs { b[0], b[1], b[2] };
+
+        float det = c[0].dot(c[1].cross(c[2]));
+        float scale = c[0][0] * c[1][1] * c[2][2];
+        if(det <= 1e-6f * scale)
+            return false;
+        weights[1] = rhs.dot(c[1].cross(c[2])) / det;
+        weights[2] = c[0].dot(rhs.cross(c[2])) / det;
+        weights[3] = c[0].dot(c[1].cross(rhs)) / det;
+    }
+
+    weights[0] = 1;
+    for(int j = 1; j < count; j ++)
+        weights[0] -= weights[j];
+    return true;
+}
+
+/**
+ * \brief Finds the point closest to the origin on the convex hull of the points
+ *
+ * \details
+ *     Only the points needed to describe the closest point are kept, and they
+ *     are moved to the front of the array along with their weights. The number
+ *     of points kept is returned.
+ */
+static int closestPoint(
+        Vector3f &closest,
+        float *weights,
+        CastVertex *vertices,
+        const Vector3f *points,
+        int count)
+{
+    /*
+     * Every face, edge and vertex of a simplex with at most four points is
+     * checked. The closest point is the nearest one that lies inside the part
+     * of the simplex it was found on.
+     */
+    float bestDistance = numeric_limits<float>::infinity();
+    int bestIndices[4];
+    float bestWeights[4];
+    int bestCount = 0;
+
+    for(int mask = 1; mask < (1 << count); mask ++)
+    {
+        int indices[4];
+        int subsetCount = 0;
+        for(int i = 0; i < count; i ++)
+        {
+            if(mask & (1 << i))
+                indices[subsetCount ++] = i;
+        }
+
+        float subsetWeights[4];
+        if(!affineWeights(subsetWeights, points, indices, subsetCount))
+            continue;
+
+        bool inside = true;
+        Vector3f point = Vector3f::zero;
+        for(int i = 0; i < subsetCount; i ++)
+        {
+            if(subsetWeights[i] <= 0)
+                inside = false;
+            point += points[indices[i]] * subsetWeights[i];
+        }
+
+        float distance = point.dot(point);
+        if(inside && distance < bestDistance)
+        {
+            bestDistance = distance;
+            bestCount = subsetCount;
+            closest = point;
+            for(int i = 0; i < subsetCount; i ++)
             {
-                triangles.push(triangle);
+                bestIndices[i] = indices[i];
+                bestWeights[i] = subsetWeights[i];
             }
+        }
+    }
+
+    /* Indices are increasing, so the vertices can be moved in place. */
+    for(int i = 0; i < bestCount; i ++)
+    {
+        vertices[i] = vertices[bestIndices[i]];
+        weights[i] = bestWeights[i];
+    }
+    return bestCount;
+}
+
+/**
+ * \brief Cast a ray against a convex shape given by its support function
+ *
+ * \details
+ *     This is the GJK raycast by Gino van den Bergen. The ray is moved forward
+ *     each time a plane separating it from the shape is found, until it is
+ *     within the tolerance of the shape. Returns false if the ray misses.
+ */
+template<typename Support>
+static bool castRay(
+        RaycastHit &hit,
+        const Support &support,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance,
+        float tolerance)
+{
+    const int maxIterations = 64;
+
+    CastVertex vertices[4];
+    Vector3f points[4];
+    float weights[4];
+    int count = 0;
 
-            /* Create new faces from the non-shared edges. */
-            for(auto &[edge, count] : edgeCounts)
+    float distance = 0;
+    Vector3f x = origin;
+    Vector3f normal = Vector3f::zero;
+
+    /* Start from any point on the shape. */
+    CastVertex first = support(-direction);
+    Vector3f v = x - first.point;
+
+    for(int i = 0; i < maxIterations && v.dot(v) > tolerance * tolerance; i ++)
+    {
+        CastVertex vertex = support(v);
+        Vector3f w = x - vertex.point;
+
+        /* Move the ray up to the separating plane if there is one. */
+        float vw = v.dot(w);
+        if(vw > 0)
+        {
+            float vr = v.dot(direction);
+            if(vr >= 0)
+                return false;
+
+            distance -= vw / vr;
+            if(distance > maxDistance)
+                return false;
+
+            x = origin + direction * distance;
+            normal = v;
+        }
+
+        /* The simplex can only be full if the ray is inside it. */
+        if(count == 4)
+            break;
+        vertices[count ++] = vertex;
+
+        for(int j = 0; j < count; j ++)
+            points[j] = x - vertices[j].point;
+        count = closestPoint(v, weights, vertices, points, count);
+        if(count == 0)
+            break;
+    }
+
+    hit.distance = distance;
+    if(normal.dot(normal) == 0)
+        hit.normal = -direction;
+    else
+        hit.normal = normal.normalized();
+
+    if(count == 0)
+    {
+        hit.point = first.witness;
+    }
+    else
+    {
+        hit.point = Vector3f::zero;
+        for(int j = 0; j < count; j ++)
+            hit.point += vertices[j].witness * weights[j];
+    }
+    return true;
+}
+
+Vector3f Collider::support(const Vector3f &d) const
+{
+    return transform(
+            worldMatrix(),
+            shape()->support(transformDirection(worldMatrixInverse(), d)));
+}
+
+bool Collider::raycast(
+        RaycastHit &hit,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance,
+        const float tolerance) const
+{
+    if(shape_->type() == Shape::MESH)
+        return raycastMesh(hit, origin, direction, maxDistance);
+
+    auto colliderSupport = [this](const Vector3f &d)
+    {
+        CastVertex vertex;
+        vertex.point = support(d);
+        vertex.witness = vertex.point;
+        return vertex;
+    };
+
+    return castRay(
+            hit,
+            colliderSupport,
+            origin,
+            direction,
+            maxDistance,
+            tolerance);
+}
+
+bool Collider::sweep(
+        RaycastHit &hit,
+        const Shape &shape,
+        const Matrix4f &shapeToWorld,
+        const Vector3f &direction,
+        float maxDistance,
+        const float tolerance) const
+{
+    if(shape_->type() == Shape::MESH)
+    {
+        return sweepMesh(
+                hit,
+                shape,
+                shapeToWorld,
+                direction,
+                maxDistance,
+                tolerance);
+    }
+
+    Matrix4f worldToShape = shapeToWorld.inverse();
+
+    /*
+     * The moving shape hits the collider where a ray from the origin hits the
+     * Minkowski difference of the collider and the shape.
+     */
+    auto differenceSupport = [&](const Vector3f &d)
+    {
+        CastVertex vertex;
+        vertex.witness = support(d);
+        vertex.point = vertex.witness
+            - transform(
+                    shapeToWorld,
+                    shape.support(transformDirection(worldToShape, -d)));
+        return vertex;
+    };
+
+    return castRay(
+            hit,
+            differenceSupport,
+            Vector3f::zero,
+            direction,
+            maxDistance,
+            tolerance);
+}
+
+bool Collider::raycastMesh(
+        RaycastHit &hit,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    const auto &worldToMesh = worldMatrixInverse();
+    const auto &mesh = static_cast<const TriangleMesh &>(*shape_);
+
+    /*
+     * The ray is moved into mesh space without normalizing its direction, so
+     * that distances along it are the same in both spaces.
+     */
+    float distance;
+    uint32_t index;
+    if(!mesh.raycast(
+                distance,
+                index,
+                transform(worldToMesh, origin),
+                transformDirection(worldToMesh, direction),
+                maxDistance))
+    {
+        return false;
+    }
+
+    /* Normals are transformed by the transpose of the inverse. */
+    auto corners = mesh.triangle(index);
+    Vector3f localNormal =
+        (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+    Vector3f normal = Vector3f::zero;
+    for(int i = 0; i < 3; i ++)
+    {
+        for(int j = 0; j < 3; j ++)
+            normal[i] += worldToMesh[j][i] * localNormal[j];
+    }
+    normal.normalize();
+
+    /* The triangles are two sided, so face the normal back along the ray. */
+    if(normal.dot(direction) > 0)
+        normal = -normal;
+
+    hit.distance = distance;
+    hit.normal = normal;
+    hit.point = origin + direction * distance;
+    return true;
+}
+
+bool Collider::sweepMesh(
+        RaycastHit &hit,
+        const Shape &shape,
+        const Matrix4f &shapeToWorld,
+        const Vector3f &direction,
+        float maxDistance,
+        const float tolerance) const
+{
+    const auto &meshToWorld = worldMatrix();
+    const auto &worldToMesh = worldMatrixInverse();
+    const auto &mesh = static_cast<const TriangleMesh &>(*shape_);
+    Matrix4f worldToShape = shapeToWorld.inverse();
+
+    /* Find the triangles near the path of the shape, or all of them. */
+    vector<uint32_t> &candidates = meshTriangles_;
+    candidates.clear();
+    if(isinf(maxDistance))
+    {
+        for(uint32_t i = 0; i < mesh.triangleCount(); i ++)
+            candidates.push_back(i);
+    }
+    else
+    {
+        Vector3f offset = direction * maxDistance;
+        Box box;
+        box.add(shape, worldToMesh * shapeToWorld, worldToShape * meshToWorld);
+        box.add(
+                shape,
+                worldToMesh * getTranslateMatrix(offset) * shapeToWorld,
+                worldToShape * getTranslateMatrix(-offset) * meshToWorld);
+        mesh.listOverlappingTriangles(box, candidates);
+    }
+
+    /* Cast against each triangle and keep the nearest hit. */
+    bool hasHit = false;
+    for(uint32_t index : candidates)
+    {
+        MeshTriangle triangle(mesh.triangle(index));
+        auto differenceSupport = [&](const Vector3f &d)
+        {
+            CastVertex vertex;
+            vertex.witness = transform(
+                    meshToWorld,
+                    triangle.support(transformDirection(worldToMesh, d)));
+            vertex.point = vertex.witness
+                - transform(
+                        shapeToWorld,
+                        shape.support(transformDirection(worldToShape, -d)));
+            return vertex;
+        };
+
+        RaycastHit triangleHit;
+        float distance = hasHit ? hit.distance : maxDistance;
+        if(castRay(
+                    triangleHit,
+                    differenceSupport,
+                    Vector3f::zero,
+                    direction,
+                    distance,
+                    tolerance))
+        {
+            if(!hasHit || triangleHit.distance < hit.distance)
             {
-                if(count == 1)
-                {
-                    triangles.emplace(
-                            edge.first,
-                            edge.second,
-                            vertices.size() - 1,
-                            vertices);
-                }
+                hit.distance = triangleHit.distance;
+                hit.normal = triangleHit.normal;
+                hit.point = triangleHit.point;
             }
+            hasHit = true;
+        }
+    }
+    return hasHit;
+}
+
+bool Collider::getDistance(
+        DistanceResult &result,
+        const shared_ptr<Collider> &other,
+        float maxDistance,
+        const float tolerance) const
+{
+    /* Meshes are measured one triangle at a time, and never to each other. */
+    if(other->shape_->type() == Shape::MESH)
+    {
+        if(shape_->type() == Shape::MESH)
+            return false;
+        return getMeshDistance(result, *other, maxDistance, tolerance);
+    }
+    if(shape_->type() == Shape::MESH)
+    {
+        bool apart = other->getMeshDistance(
+                result,
+                *this,
+                maxDistance,
+                tolerance);
+        swap(result.points[0], result.points[1]);
+        result.normal = -result.normal;
+        for(int i = 0; i < result.simplexSize; i ++)
+            result.simplex[i] = -result.simplex[i];
+        return apart;
+    }
+
+    return getShapeDistance(
+            result,
+            *other->shape_,
+            other->worldMatrix(),
+            other->worldMatrixInverse(),
+            tolerance);
+}
+
+bool Collider::getShapeDistance(
+        DistanceResult &result,
+        const Shape &otherShape,
+        const Matrix4f &otherToWorld,
+        const Matrix4f &worldToOther,
+        const float tolerance) const
+{
+    const int maxIterations = 64;
+    const auto &thisToWorld = worldMatrix();
+    const auto &worldToThis = worldMatrixInverse();
+
+    /*
+     * Each vertex is a point on the Minkowski difference, with the point on
+     * this collider that made it as the witness.
+     */
+    auto differenceSupport = [&](const Vector3f &d)
+    {
+        CastVertex vertex;
+        vertex.witness = transform(
+                thisToWorld,
+                shape()->support(transformDirection(worldToThis, d)));
+        vertex.point = vertex.witness
+            - transform(
+                    otherToWorld,
+                    otherShape.support(transformDirection(worldToOther, -d)));
+        return vertex;
+    };
+
+    CastVertex vertices[4];
+    Vector3f points[4];
+    float weights[4] = { 1 };
+    int count = 1;
+
+    vertices[0] = differenceSupport(-Vector3f::right);
+    Vector3f v = vertices[0].point;
+    bool apart = true;
+
+    for(int i = 0; i < maxIterations; i ++)
+    {
+        /*
+         * Stop once the nearest point found is within the tolerance of the
+         * furthest plane separating the difference from the origin.
+         */
+        float vv = v.dot(v);
+        if(vv <= tolerance * tolerance)
+        {
+            apart = false;
+            break;
+        }
+
+        CastVertex vertex = differenceSupport(-v);
+        if(vv - v.dot(vertex.point) <= tolerance * sqrt(vv))
+            break;
+
+        /* A point already in the simplex means no progress can be made. */
+        bool repeated = false;
+        for(int j = 0; j < count; j ++)
+        {
+            if(vertices[j].point == vertex.point)
+                repeated = true;
+        }
+        if(repeated)
+            break;
+
+        CastVertex previous[4];
+        float previousWeights[4];
+        int previousCount = count;
+        copy(vertices, vertices + count, previous);
+        copy(weights, weights + count, previousWeights);
+
+        vertices[count ++] = vertex;
+        for(int j = 0; j < count; j ++)
+            points[j] = vertices[j].point;
+
+        /*
+         * The origin is only inside the simplex if all four points are
+         * needed. If no point is found the simplex is degenerate, so the last
+         * one is kept.
+         */
+        Vector3f closest;
+        count = closestPoint(closest, weights, vertices, points, count);
+        if(count == 4)
+        {
+            apart = false;
+            break;
         }
+        if(count == 0)
+        {
+            count = previousCount;
+            copy(previous, previous + count, vertices);
+            copy(previousWeights, previousWeights + count, weights);
+            break;
+        }
+        v = closest;
+    }
+
+    result.simplexSize = count;
+    for(int i = 0; i < count; i ++)
+        result.simplex[i] = vertices[i].point;
+
+    if(!apart)
+    {
+        result.distance = 0;
+        result.normal = Vector3f::zero;
+        return false;
     }
+
+    /* The closest point on the difference is the gap between the shapes. */
+    result.points[0] = Vector3f::zero;
+    for(int i = 0; i < count; i ++)
+        result.points[0] += vertices[i].witness * weights[i];
+    result.points[1] = result.points[0] - v;
+    result.distance = v.magnitude();
+    result.normal = -v * (1 / result.distance);
+    return true;
+}
+
+bool Collider::getMeshDistance(
+        DistanceResult &result,
+        const Collider &mesh,
+        float maxDistance,
+        const float tolerance) const
+{
+    const auto &thisToWorld = worldMatrix();
+    const auto &worldToThis = worldMatrixInverse();
+    const auto &meshToWorld = mesh.worldMatrix();
+    const auto &worldToMesh = mesh.worldMatrixInverse();
+    const auto &triangles = static_cast<const TriangleMesh &>(*mesh.shape_);
+
+    /*
+     * Find the triangles near the bounds of this shape, grown by the maximum
+     * distance in world space and then moved into mesh space, or all of them.
+     */
+    vector<uint32_t> &candidates = meshTriangles_;
+    candidates.clear();
+    if(isinf(maxDistance))
+    {
+        for(uint32_t i = 0; i < triangles.triangleCount(); i ++)
+            candidates.push_back(i);
+    }
+    else
+    {
+        Box world;
+        world.add(*shape_, thisToWorld, worldToThis);
+        Vector3f margin = Vector3f { 1, 1, 1 } * maxDistance;
+        world.add(world.min() - margin);
+        world.add(world.max() + margin);
+
+        Box box;
+        for(int corner = 0; corner < 8; corner ++)
+        {
+            Vector3f point;
+            for(int i = 0; i < 3; i ++)
+                point[i] = corner & (1 << i) ? world.max()[i] : world.min()[i];
+            box.add(transform(worldToMesh, point));
+        }
+        triangles.listOverlappingTriangles(box, candidates);
+    }
+
+    /* Keep the nearest triangle, stopping if any of them overlap. */
+    bool found = false;
+    for(uint32_t index : candidates)
+    {
+        MeshTriangle triangle(triangles.triangle(index));
+        DistanceResult triangleResult;
+        bool apart = getShapeDistance(
+                triangleResult,
+                triangle,
+                meshToWorld,
+                worldToMesh,
+                tolerance);
+        if(!apart)
+        {
+            result = triangleResult;
+            return false;
+        }
+
+        if(!found || triangleResult.distance < result.distance)
+            result = triangleResult;
+        found = true;
+    }
+
+    if(!found)
+    {
+        result.distance = numeric_limits<float>::infinity();
+        result.normal = Vector3f::zero;
+        result.simplexSize = 0;
+    }
+    return true;
 }
 
 void Collider::onSceneChanged(shared_ptr<Scene> newScene)
@@ -705,6 +2082,7 @@ void Collider::onAncestorAdded(std::shared_ptr<Node> ancestor)
     {
         assert(isStatic_);
         isStatic_ = false;
+        onStaticChanged();
     }
 }
 
@@ -713,6 +2091,22 @@ void Collider::onAncestorRemoved(std::shared_ptr<Node> ancestor)
     if(ancestor->as<Rigidbody>())
     {
         isStatic_ = true;
+        onStaticChanged();
+    }
+}
+
+void Collider::onStaticChanged()
+{
+    /*
+     * Re-add the collider to the scene, so its pruner can treat it as static
+     * or not.
+     */
+    auto scene = getScene().lock();
+    if(scene)
+    {
+        auto collider = static_pointer_cast<Collider>(shared_from_this());
+        scene->unregisterNode(collider);
+        scene->registerNode(collider);
     }
 }
 
@@ -721,6 +2115,31 @@ bool &Collider::isTrigger()
     return isTrigger_;
 }
 
+const bool &Collider::isTrigger() const
+{
+    return isTrigger_;
+}
+
+float &Collider::friction()
+{
+    return friction_;
+}
+
+const float &Collider::friction() const
+{
+    return friction_;
+}
+
+float &Collider::restitution()
+{
+    return restitution_;
+}
+
+const float &Collider::restitution() const
+{
+    return restitution_;
+}
+
 const bool &Collider::isStatic() const
 {
     return isStatic_;
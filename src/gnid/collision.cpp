@@ -28,6 +28,7 @@ void Collision::swapColliders()
 {
     swap(colliders_[0], colliders_[1]);
     overlap_ = -overlap_;
+    manifold_.swapColliders();
 }
 
 Collision Collision::swapped() const
@@ -0,0 +1,192 @@
+#include "gnid/collisionpruner.hpp"
+
+#include <algorithm>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+
+using namespace std;
+using namespace tmat;
+using namespace gnid;
+
+bool CollisionPruner::raycast(
+        RaycastHit &hit,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    Vector3f unitDirection = direction.normalized();
+
+    vector<shared_ptr<Collider>> colliders;
+    listAllNodes(colliders);
+
+    bool found = false;
+    for(auto &collider : colliders)
+    {
+        float distance;
+        const Box &box = collider->box();
+        if(box.count() == 0
+            || !box.raycast(distance, origin, unitDirection, maxDistance))
+        {
+            continue;
+        }
+
+        if(collider->raycast(hit, origin, unitDirection, maxDistance))
+        {
+            hit.collider = collider;
+            maxDistance = hit.distance;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool CollisionPruner::sweep(
+        RaycastHit &hit,
+        const Shape &shape,
+        const Matrix4f &from,
+        const Matrix4f &to) const
+{
+    Vector3f direction;
+    float maxDistance;
+    sweepPath(direction, maxDistance, from, to);
+
+    Box shapeBox;
+    shapeBox.add(shape, from, from.inverse());
+
+    vector<shared_ptr<Collider>> colliders;
+    listAllNodes(colliders);
+
+    bool found = false;
+    for(auto &collider : colliders)
+    {
+        const Box &box = collider->box();
+        if(box.count() == 0)
+            continue;
+
+        /*
+         * The shape's box hits the collider's box where the origin hits the
+         * collider's box grown by the shape's box.
+         */
+        float distance;
+        Box grown;
+        grown.add(box.min() - shapeBox.max());
+        grown.add(box.max() - shapeBox.min());
+        if(!grown.raycast(distance, Vector3f::zero, direction, maxDistance))
+            continue;
+
+        if(collider->sweep(hit, shape, from, direction, maxDistance))
+        {
+            hit.collider = collider;
+            maxDistance = hit.distance;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void CollisionPruner::sweepPath(
+        Vector3f &direction,
+        float &distance,
+        const Matrix4f &from,
+        const Matrix4f &to)
+{
+    Vector3f translation =
+        transform(to, Vector3f::zero) - transform(from, Vector3f::zero);
+    distance = translation.magnitude();
+
+    /* A sweep that does not move only checks for overlaps. */
+    if(distance > 0)
+        direction = translation * (1.0f / distance);
+    else
+        direction = Vector3f::right;
+}
+
+void CollisionPruner::queryBox(
+        vector<shared_ptr<Collider>> &list,
+        const Box &box,
+        const QueryFilter &filter) const
+{
+    vector<shared_ptr<Collider>> colliders;
+    listAllNodes(colliders);
+
+    for(auto &collider : colliders)
+    {
+        const Box &colliderBox = collider->box();
+        if(colliderBox.count() > 0
+            && colliderBox.overlaps(box)
+            && filter.accepts(*collider))
+        {
+            list.push_back(collider);
+        }
+    }
+}
+
+void CollisionPruner::querySphere(
+        vector<shared_ptr<Collider>> &list,
+        const Vector3f &center,
+        float radius,
+        const QueryFilter &filter) const
+{
+    vector<shared_ptr<Collider>> colliders;
+    listAllNodes(colliders);
+
+    for(auto &collider : colliders)
+    {
+        const Box &colliderBox = collider->box();
+        if(colliderBox.count() > 0
+            && colliderBox.distance(center) <= radius
+            && filter.accepts(*collider))
+        {
+            list.push_back(collider);
+        }
+    }
+}
+
+void CollisionPruner::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        const Vector3f &point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
+{
+    list.clear();
+
+    vector<shared_ptr<Collider>> colliders;
+    listAllNodes(colliders);
+
+    for(auto &collider : colliders)
+    {
+        const Box &colliderBox = collider->box();
+        if(colliderBox.count() == 0 || !filter.accepts(*collider))
+            continue;
+
+        float distance = colliderBox.distance(point);
+        if(distance <= maxDistance)
+            insertNearest(list, count, distance, collider);
+    }
+}
+
+void CollisionPruner::insertNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        size_t count,
+        float distance,
+        const shared_ptr<Collider> &collider)
+{
+    if(list.size() >= count)
+    {
+        if(count == 0 || distance >= list.back().first)
+            return;
+        list.pop_back();
+    }
+
+    auto it = upper_bound(
+            begin(list),
+            end(list),
+            distance,
+            [](float distance, const pair<float, shared_ptr<Collider>> &item)
+            {
+                return distance < item.first;
+            });
+    list.emplace(it, distance, collider);
+}
@@ -0,0 +1,306 @@
+#include "gnid/contactmanifold.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "gnid/collider.hpp"
+#include "gnid/shape.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace gnid;
+using namespace std;
+using namespace tmat;
+
+/*
+ * How far the normal can turn, as the cosine of the angle, before the points
+ * found along the old normal are thrown away.
+ */
+static const float NORMAL_TOLERANCE = 0.9f;
+
+/*
+ * How far the normal is tilted to find the other corners of a flat face in
+ * contact.
+ */
+static const float TILT = 0.05f;
+
+/**
+ * \brief Returns an identifier for a corner of one of the colliders
+ *
+ * \details
+ *     The corners of boxes and hulls are found at exactly the same point in
+ *     the space of the shape every time, so the bits of the point identify
+ *     it. The lowest bit is the index of the collider.
+ */
+static uint64_t featureOf(const Vector3f &localPoint, int collider)
+{
+    uint64_t feature = 0xcbf29ce484222325;
+    for(int i = 0; i < 3; i ++)
+    {
+        uint32_t bits;
+        memcpy(&bits, &localPoint[i], sizeof(bits));
+        feature = (feature ^ bits) * 0x100000001b3;
+    }
+    return (feature << 1) | collider;
+}
+
+/**
+ * \brief Returns the point on the shape furthest along d in its own space
+ */
+static Vector3f localSupport(const Collider &collider, const Vector3f &d)
+{
+    return collider.shape()->support(
+            transformDirection(collider.worldMatrixInverse(), d));
+}
+
+/**
+ * \brief Returns the area of the largest quadrilateral through the points
+ */
+static float area(
+        const Vector3f &a,
+        const Vector3f &b,
+        const Vector3f &c,
+        const Vector3f &d)
+{
+    /* The area is half the cross product of the diagonals, for some order. */
+    float first = (a - b).cross(c - d).magnitude();
+    float second = (a - c).cross(b - d).magnitude();
+    float third = (a - d).cross(b - c).magnitude();
+    return fmax(first, fmax(second, third));
+}
+
+void ContactManifold::update(
+        const Collider &a,
+        const Collider &b,
+        const Vector3f &overlap)
+{
+    refresh(a, b);
+
+    float depth = overlap.magnitude();
+    if(depth == 0)
+        return;
+
+    Vector3f normal = overlap * (1 / depth);
+    if(size_ > 0 && normal.dot(normal_) < NORMAL_TOLERANCE)
+        clear();
+    normal_ = normal;
+
+    /*
+     * Tilting the normal toward each diagonal of the plane finds every corner
+     * of a face lying flat against the other collider, rather than only the
+     * single deepest point. A sphere only ever touches at one point, so it
+     * is only checked along the normal.
+     */
+    Vector3f tangent = normal.cross(
+            fabs(normal[0]) < 0.57f ? Vector3f::right : Vector3f::up);
+    tangent.normalize();
+    Vector3f bitangent = normal.cross(tangent);
+
+    Vector3f tangents[4] = { tangent, -tangent, bitangent, -bitangent };
+    Vector3f directions[5] = {
+        normal + (tangent + bitangent) * TILT,
+        normal + (tangent - bitangent) * TILT,
+        normal - (tangent + bitangent) * TILT,
+        normal - (tangent - bitangent) * TILT,
+        normal
+    };
+
+    /*
+     * Points are found on each collider in turn. The other collider is only
+     * known by its extent along the tangents, so a point has to be within it.
+     * A mesh's support points are its furthest vertices rather than those of
+     * the triangles it is touching, so no points are found on a mesh.
+     */
+    const Collider *colliders[2] = { &a, &b };
+    for(int side = 0; side < 2; side ++)
+    {
+        const Collider &collider = *colliders[side];
+        const Collider &other = *colliders[1 - side];
+        if(collider.shape()->type() == Shape::MESH)
+            continue;
+
+        /* The normal points away from the first collider. */
+        float sign = side == 0 ? 1 : -1;
+        float deepest = sign * collider.support(normal * sign).dot(normal);
+
+        /*
+         * A mesh finds its support points by going through all of its
+         * vertices, and a level mesh reaches far past any collider touching
+         * it anyway, so points are not clipped against a mesh.
+         */
+        float extents[4];
+        bool otherIsMesh = other.shape()->type() == Shape::MESH;
+        for(int i = 0; i < 4; i ++)
+        {
+            extents[i] = otherIsMesh
+                ? numeric_limits<float>::infinity()
+                : other.support(tangents[i]).dot(tangents[i]);
+        }
+
+        /*
+         * The corners come first, so that a point in the middle of a face
+         * is the one left out when there are too many.
+         */
+        int first = collider.shape()->type() == Shape::SPHERE ? 4 : 0;
+        for(int i = first; i < 5; i ++)
+        {
+            const Vector3f &direction = directions[i];
+            Vector3f localPoint = localSupport(collider, direction * sign);
+            Vector3f point = transform(collider.worldMatrix(), localPoint);
+
+            ContactPoint contact;
+            contact.depth = depth - (deepest - sign * point.dot(normal));
+            if(contact.depth < -BREAKING_DISTANCE)
+                continue;
+
+            bool inside = true;
+            for(int j = 0; j < 4; j ++)
+            {
+                if(point.dot(tangents[j]) > extents[j] + BREAKING_DISTANCE)
+                    inside = false;
+            }
+            if(!inside)
+                continue;
+
+            contact.points[side] = point;
+            contact.points[1 - side] = point - normal * (sign * contact.depth);
+            contact.localPoints[side] = localPoint;
+            contact.localPoints[1 - side] = transform(
+                    other.worldMatrixInverse(),
+                    contact.points[1 - side]);
+            contact.feature = featureOf(localPoint, side);
+            contact.lifetime = 0;
+            contact.normalImpulse = 0;
+            contact.frictionImpulse = Vector3f::zero;
+            add(contact);
+        }
+    }
+}
+
+void ContactManifold::refresh(const Collider &a, const Collider &b)
+{
+    for(size_t i = size_; i -- > 0; )
+    {
+        ContactPoint &point = points_[i];
+        point.points[0] = transform(a.worldMatrix(), point.localPoints[0]);
+        point.points[1] = transform(b.worldMatrix(), point.localPoints[1]);
+
+        Vector3f offset = point.points[0] - point.points[1];
+        point.depth = offset.dot(normal_);
+        Vector3f drift = offset - normal_ * point.depth;
+
+        if(point.depth < -BREAKING_DISTANCE
+                || drift.dot(drift) > BREAKING_DISTANCE * BREAKING_DISTANCE)
+        {
+            remove(i);
+        }
+        else
+        {
+            point.lifetime ++;
+        }
+    }
+}
+
+void ContactManifold::swapColliders()
+{
+    for(size_t i = 0; i < size_; i ++)
+    {
+        swap(points_[i].localPoints[0], points_[i].localPoints[1]);
+        swap(points_[i].points[0], points_[i].points[1]);
+        points_[i].feature ^= 1;
+        points_[i].frictionImpulse = -points_[i].frictionImpulse;
+    }
+    normal_ = -normal_;
+}
+
+void ContactManifold::add(const ContactPoint &point)
+{
+    /* Replace the point made by the same corner, or else the nearest one. */
+    size_t match = size_;
+    float nearest = BREAKING_DISTANCE * BREAKING_DISTANCE;
+    for(size_t i = 0; i < size_; i ++)
+    {
+        if(points_[i].feature == point.feature)
+        {
+            match = i;
+            break;
+        }
+
+        Vector3f offset = points_[i].localPoints[0] - point.localPoints[0];
+        if(offset.dot(offset) < nearest)
+        {
+            nearest = offset.dot(offset);
+            match = i;
+        }
+    }
+
+    if(match < size_)
+    {
+        ContactPoint &matched = points_[match];
+        int lifetime = matched.lifetime;
+        float normalImpulse = matched.normalImpulse;
+        Vector3f frictionImpulse = matched.frictionImpulse;
+        matched = point;
+        matched.lifetime = lifetime;
+        matched.normalImpulse = normalImpulse;
+        matched.frictionImpulse = frictionImpulse;
+        return;
+    }
+
+    if(size_ < MAX_POINTS)
+    {
+        points_[size_ ++] = point;
+        return;
+    }
+
+    /*
+     * Out of the four points and the new one, keep the deepest and leave out
+     * whichever other point makes the rest cover the largest area.
+     */
+    ContactPoint candidates[MAX_POINTS + 1];
+    for(size_t i = 0; i < MAX_POINTS; i ++)
+        candidates[i] = points_[i];
+    candidates[MAX_POINTS] = point;
+
+    size_t deepest = 0;
+    for(size_t i = 1; i <= MAX_POINTS; i ++)
+    {
+        if(candidates[i].depth > candidates[deepest].depth)
+            deepest = i;
+    }
+
+    size_t removed = MAX_POINTS;
+    float largest = -1;
+    for(size_t i = 0; i <= MAX_POINTS; i ++)
+    {
+        if(i == deepest)
+            continue;
+
+        const Vector3f *rest[MAX_POINTS];
+        size_t count = 0;
+        for(size_t j = 0; j <= MAX_POINTS; j ++)
+        {
+            if(j != i)
+                rest[count ++] = &candidates[j].points[0];
+        }
+
+        float restArea = area(*rest[0], *rest[1], *rest[2], *rest[3]);
+        if(restArea > largest)
+        {
+            largest = restArea;
+            removed = i;
+        }
+    }
+
+    size_t count = 0;
+    for(size_t i = 0; i <= MAX_POINTS; i ++)
+    {
+        if(i != removed)
+            points_[count ++] = candidates[i];
+    }
+}
+
+void ContactManifold::remove(size_t i)
+{
+    points_[i] = points_[-- size_];
+}
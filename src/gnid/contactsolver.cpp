@@ -0,0 +1,242 @@
+#include "gnid/contactsolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gnid/collider.hpp"
+#include "gnid/rigidbody.hpp"
+
+using namespace gnid;
+using namespace std;
+using namespace tmat;
+
+/* The index of the body shared by everything that can't move. */
+static const size_t FIXED_BODY = 0;
+
+size_t ContactSolver::bodyOf(const shared_ptr<Collider> &collider)
+{
+    auto rb = collider->findAncestorByType<Rigidbody>();
+    if(!rb || !rb->isActive() || rb->sleeping())
+        return FIXED_BODY;
+
+    auto item = bodyIndices_.try_emplace(rb.get(), bodies_.size());
+    if(item.second)
+    {
+        bodies_.push_back(rb);
+        inverseMasses_.push_back(rb->inverseMass());
+        velocities_.push_back(rb->velocity());
+        positionVelocities_.push_back(Vector3f::zero);
+    }
+    return item.first->second;
+}
+
+void ContactSolver::applyImpulse(
+        const Constraint &constraint,
+        const Vector3f &impulse,
+        vector<Vector3f> &velocities)
+{
+    size_t a = constraint.bodies[0];
+    size_t b = constraint.bodies[1];
+    velocities[a] -= impulse * inverseMasses_[a];
+    velocities[b] += impulse * inverseMasses_[b];
+}
+
+void ContactSolver::solve(
+        const vector<const Collision *> &collisions,
+        float dt,
+        unordered_set<shared_ptr<Rigidbody>> &movedBodies)
+{
+    /* The biases divide by the time step. */
+    if(dt <= 0)
+        return;
+
+    constraints_.clear();
+    extraPoints_.clear();
+    bodies_.assign(1, nullptr);
+    inverseMasses_.assign(1, 0);
+    velocities_.assign(1, Vector3f::zero);
+    positionVelocities_.assign(1, Vector3f::zero);
+    bodyIndices_.clear();
+
+    /* The extra points are pointed to, so they must not move. */
+    extraPoints_.reserve(collisions.size());
+
+    for(auto collision : collisions)
+    {
+        const auto &colliders = collision->colliders();
+        if(colliders[0]->isTrigger() || colliders[1]->isTrigger())
+            continue;
+
+        /*
+         * Nothing can push apart bodies that both have an infinite mass,
+         * such as a body without a mass resting on a static collider.
+         */
+        size_t a = bodyOf(colliders[0]);
+        size_t b = bodyOf(colliders[1]);
+        if(a == b || inverseMasses_[a] + inverseMasses_[b] == 0)
+            continue;
+
+        float friction = sqrt(
+                colliders[0]->friction() * colliders[1]->friction());
+        float restitution = max(
+                colliders[0]->restitution(),
+                colliders[1]->restitution());
+
+        /*
+         * A collision without any points, for example between two meshes,
+         * still keeps the colliders apart through its overlap.
+         */
+        ContactManifold &manifold = collision->manifold_;
+        Vector3f normal = manifold.normal();
+        size_t pointCount = manifold.size();
+        ContactPoint *points = pointCount > 0 ? &manifold[0] : nullptr;
+        if(pointCount == 0)
+        {
+            float depth = collision->overlap().magnitude();
+            if(depth == 0)
+                continue;
+
+            ContactPoint point;
+            point.depth = depth;
+            point.feature = 0;
+            point.lifetime = 0;
+            point.normalImpulse = 0;
+            point.frictionImpulse = Vector3f::zero;
+            extraPoints_.push_back(point);
+
+            normal = collision->overlap() * (1 / depth);
+            points = &extraPoints_.back();
+            pointCount = 1;
+        }
+
+        for(size_t i = 0; i < pointCount; i ++)
+        {
+            Constraint constraint;
+            constraint.bodies[0] = a;
+            constraint.bodies[1] = b;
+            constraint.point = &points[i];
+            constraint.normal = normal;
+            constraint.friction = friction;
+            constraint.mass = 1 / (inverseMasses_[a] + inverseMasses_[b]);
+            constraint.positionImpulse = 0;
+
+            /*
+             * Bodies hitting each other fast enough bounce back. Points that
+             * are apart let the bodies close the gap in this update.
+             */
+            float depth = points[i].depth;
+            float normalVelocity =
+                (velocities_[b] - velocities_[a]).dot(normal);
+            float bias = 0;
+            if(normalVelocity < -restitutionThreshold_)
+                bias = -restitution * normalVelocity;
+
+            float correction = max(depth - allowedPenetration_, 0.0f)
+                * correctionFactor_ / dt;
+            if(depth < 0)
+                bias = depth / dt;
+            else if(!splitImpulse_)
+                bias += correction;
+
+            constraint.velocityBias = bias;
+            constraint.positionBias = correction;
+            constraints_.push_back(constraint);
+        }
+    }
+
+    if(constraints_.empty())
+        return;
+
+    /* Start from the impulses of the last update. */
+    for(auto &constraint : constraints_)
+    {
+        const ContactPoint &point = *constraint.point;
+        applyImpulse(
+                constraint,
+                constraint.normal * point.normalImpulse
+                    + point.frictionImpulse,
+                velocities_);
+    }
+
+    for(int iteration = 0; iteration < velocityIterations_; iteration ++)
+    {
+        for(auto &constraint : constraints_)
+        {
+            ContactPoint &point = *constraint.point;
+            const Vector3f &normal = constraint.normal;
+
+            /*
+             * Friction stops the sliding between the bodies, up to the
+             * friction coefficient times the impulse along the normal.
+             */
+            Vector3f relative = velocities_[constraint.bodies[1]]
+                - velocities_[constraint.bodies[0]];
+            Vector3f sliding = relative - normal * relative.dot(normal);
+            Vector3f frictionImpulse =
+                point.frictionImpulse - sliding * constraint.mass;
+            float limit = constraint.friction * point.normalImpulse;
+            float magnitude = frictionImpulse.magnitude();
+            if(magnitude > limit)
+                frictionImpulse *= limit / magnitude;
+            applyImpulse(
+                    constraint,
+                    frictionImpulse - point.frictionImpulse,
+                    velocities_);
+            point.frictionImpulse = frictionImpulse;
+
+            /* The bodies may only be pushed apart, never pulled together. */
+            relative = velocities_[constraint.bodies[1]]
+                - velocities_[constraint.bodies[0]];
+            float normalImpulse = max(
+                    point.normalImpulse
+                        - (relative.dot(normal) - constraint.velocityBias)
+                        * constraint.mass,
+                    0.0f);
+            applyImpulse(
+                    constraint,
+                    normal * (normalImpulse - point.normalImpulse),
+                    velocities_);
+            point.normalImpulse = normalImpulse;
+        }
+    }
+
+    /*
+     * Split impulses move the bodies apart with velocities of their own, which
+     * are thrown away afterwards.
+     */
+    if(splitImpulse_)
+    {
+        for(int iteration = 0; iteration < positionIterations_; iteration ++)
+        {
+            for(auto &constraint : constraints_)
+            {
+                const Vector3f &normal = constraint.normal;
+                Vector3f relative =
+                    positionVelocities_[constraint.bodies[1]]
+                    - positionVelocities_[constraint.bodies[0]];
+                float impulse = max(
+                        constraint.positionImpulse
+                            - (relative.dot(normal) - constraint.positionBias)
+                            * constraint.mass,
+                        0.0f);
+                applyImpulse(
+                        constraint,
+                        normal * (impulse - constraint.positionImpulse),
+                        positionVelocities_);
+                constraint.positionImpulse = impulse;
+            }
+        }
+    }
+
+    for(size_t i = 1; i < bodies_.size(); i ++)
+    {
+        bodies_[i]->velocityRef() = velocities_[i];
+        if(!(positionVelocities_[i] == Vector3f::zero))
+        {
+            bodies_[i]->transformWorld(
+                    getTranslateMatrix(positionVelocities_[i] * dt));
+            movedBodies.insert(bodies_[i]);
+        }
+    }
+    bodies_.clear();
+}
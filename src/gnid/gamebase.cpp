@@ -80,8 +80,11 @@ void GameBase::tick()
 
     if(currentScene())
     {
-        currentScene()->update(dt);
-        currentScene()->render();
+        float step = steps_.step() > 0 ? steps_.step() : dt;
+        int count = steps_.advance(dt);
+        for(int i = 0; i < count; i ++)
+            currentScene()->update(step);
+        currentScene()->render(steps_.alpha());
     }
 
     glfwSwapBuffers(window_);
@@ -98,6 +101,21 @@ GameBase::~GameBase()
     glfwDestroyWindow(window_);
 }
 
+float &GameBase::fixedTimestep()
+{
+    return steps_.step();
+}
+
+int &GameBase::maxSubsteps()
+{
+    return steps_.maxSubsteps();
+}
+
+float GameBase::interpolationAlpha() const
+{
+    return steps_.alpha();
+}
+
 const string &GameBase::title()
 {
     return title_;
@@ -0,0 +1,450 @@
+#include "gnid/hashgrid.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "gnid/collider.hpp"
+
+using namespace std;
+using namespace tmat;
+using namespace gnid;
+
+/*
+ * Cell coordinates are clamped to this range so that they fit in 21 bits each
+ * of the cell keys.
+ */
+static const int MAX_CELL_COORD = (1 << 20) - 1;
+
+/**
+ * \brief Returns the squared distance between the bounds and the query bounds
+ */
+template<typename T>
+static float distanceSquared(const T &bounds, const float *min, const float *max)
+{
+    float distance = 0;
+    for(int i = 0; i < 3; i ++)
+    {
+        float gap = 0;
+        if(bounds.max[i] < min[i])
+            gap = min[i] - bounds.max[i];
+        else if(bounds.min[i] > max[i])
+            gap = bounds.min[i] - max[i];
+        distance += gap * gap;
+    }
+    return distance;
+}
+
+HashGridPruner::HashGridPruner(float cellSize, unsigned int maxCellsPerCollider)
+    : cellSize_(cellSize),
+      maxCellsPerCollider_(maxCellsPerCollider)
+{
+    assert(cellSize_ > 0);
+}
+
+uint64_t HashGridPruner::cellKey(int x, int y, int z)
+{
+    const uint64_t mask = (1 << 21) - 1;
+    return ((static_cast<uint64_t>(x) & mask) << 42)
+        | ((static_cast<uint64_t>(y) & mask) << 21)
+        | (static_cast<uint64_t>(z) & mask);
+}
+
+int HashGridPruner::cellCoord(float value) const
+{
+    float coord = floor(value / cellSize_);
+    if(!(coord > -MAX_CELL_COORD))
+        return -MAX_CELL_COORD;
+    if(coord > MAX_CELL_COORD)
+        return MAX_CELL_COORD;
+    return static_cast<int>(coord);
+}
+
+bool HashGridPruner::overlaps(const Proxy &first, const Proxy &second) const
+{
+    /* Static colliders never need to be checked against each other. */
+    if(first.isStatic && second.isStatic)
+        return false;
+
+    for(int i = 0; i < 3; i ++)
+    {
+        if(first.max[i] < second.min[i] || first.min[i] > second.max[i])
+            return false;
+    }
+    return true;
+}
+
+void HashGridPruner::listAllNodes(vector<shared_ptr<Collider>> &list) const
+{
+    for(auto &proxy : proxies_)
+    {
+        if(proxy.inUse)
+            list.push_back(proxy.collider);
+    }
+}
+
+void HashGridPruner::add(shared_ptr<Collider> collider)
+{
+    assert(proxyIndices_.find(collider.get()) == end(proxyIndices_));
+
+    uint32_t index;
+    if(freeProxies_.empty())
+    {
+        index = proxies_.size();
+        proxies_.emplace_back();
+    }
+    else
+    {
+        index = freeProxies_.back();
+        freeProxies_.pop_back();
+    }
+
+    Proxy &proxy = proxies_[index];
+    proxy.collider = collider;
+    proxy.isStatic = collider->isStatic();
+    proxy.inUse = true;
+    proxy.binned = false;
+    proxy.isLarge = false;
+    proxy.dirty = true;
+    proxyIndices_[collider.get()] = index;
+}
+
+void HashGridPruner::remove(shared_ptr<Collider> collider)
+{
+    auto it = proxyIndices_.find(collider.get());
+    if(it == end(proxyIndices_))
+        return;
+
+    uint32_t index = it->second;
+    proxyIndices_.erase(it);
+
+    unbin(index);
+    proxies_[index].inUse = false;
+    proxies_[index].collider = nullptr;
+    freeProxies_.push_back(index);
+}
+
+void HashGridPruner::bin(uint32_t index)
+{
+    Proxy &proxy = proxies_[index];
+    assert(!proxy.binned);
+
+    uint64_t cellCount = 1;
+    for(int i = 0; i < 3; i ++)
+    {
+        proxy.cellMin[i] = cellCoord(proxy.min[i]);
+        proxy.cellMax[i] = cellCoord(proxy.max[i]);
+        cellCount *= proxy.cellMax[i] - proxy.cellMin[i] + 1;
+    }
+
+    proxy.binned = true;
+    proxy.isLarge = cellCount > maxCellsPerCollider_;
+
+    if(proxy.isLarge)
+    {
+        largeProxies_.push_back(index);
+        return;
+    }
+
+    for(int x = proxy.cellMin[0]; x <= proxy.cellMax[0]; x ++)
+    {
+        for(int y = proxy.cellMin[1]; y <= proxy.cellMax[1]; y ++)
+        {
+            for(int z = proxy.cellMin[2]; z <= proxy.cellMax[2]; z ++)
+            {
+                uint64_t key = cellKey(x, y, z);
+                auto [it, inserted] = cellIndices_.emplace(key, cells_.size());
+                if(inserted)
+                {
+                    cells_.emplace_back();
+                    Cell &cell = cells_.back();
+                    cell.key = key;
+                    cell.coord[0] = x;
+                    cell.coord[1] = y;
+                    cell.coord[2] = z;
+                }
+                cells_[it->second].proxies.push_back(index);
+            }
+        }
+    }
+}
+
+void HashGridPruner::unbin(uint32_t index)
+{
+    Proxy &proxy = proxies_[index];
+    if(!proxy.binned)
+        return;
+    proxy.binned = false;
+
+    if(proxy.isLarge)
+    {
+        auto it = find(begin(largeProxies_), end(largeProxies_), index);
+        assert(it != end(largeProxies_));
+        *it = largeProxies_.back();
+        largeProxies_.pop_back();
+        return;
+    }
+
+    for(int x = proxy.cellMin[0]; x <= proxy.cellMax[0]; x ++)
+    {
+        for(int y = proxy.cellMin[1]; y <= proxy.cellMax[1]; y ++)
+        {
+            for(int z = proxy.cellMin[2]; z <= proxy.cellMax[2]; z ++)
+            {
+                auto cellIndex = cellIndices_.find(cellKey(x, y, z));
+                assert(cellIndex != end(cellIndices_));
+
+                auto &proxies = cells_[cellIndex->second].proxies;
+                auto it = find(begin(proxies), end(proxies), index);
+                assert(it != end(proxies));
+                *it = proxies.back();
+                proxies.pop_back();
+
+                /* Move the last cell into the empty one's place. */
+                if(proxies.empty())
+                {
+                    uint32_t emptyIndex = cellIndex->second;
+                    cellIndices_.erase(cellIndex);
+                    if(emptyIndex != cells_.size() - 1)
+                    {
+                        cells_[emptyIndex] = move(cells_.back());
+                        cellIndices_[cells_[emptyIndex].key] = emptyIndex;
+                    }
+                    cells_.pop_back();
+                }
+            }
+        }
+    }
+}
+
+void HashGridPruner::update()
+{
+    for(uint32_t i = 0; i < proxies_.size(); i ++)
+    {
+        Proxy &proxy = proxies_[i];
+        if(!proxy.inUse)
+            continue;
+
+        proxy.isStatic = proxy.collider->isStatic();
+
+        if(!proxy.dirty && !proxy.collider->moved())
+            continue;
+
+        /* Wait until the collider has a bounding box. */
+        const Box &box = proxy.collider->box();
+        if(box.count() == 0)
+            continue;
+        proxy.dirty = false;
+
+        for(int j = 0; j < 3; j ++)
+        {
+            proxy.min[j] = box.min()[j];
+            proxy.max[j] = box.max()[j];
+        }
+
+        /* Only touch the cells if the collider moved to different ones. */
+        if(proxy.binned)
+        {
+            bool sameCells = true;
+            for(int j = 0; j < 3; j ++)
+            {
+                if(cellCoord(proxy.min[j]) != proxy.cellMin[j]
+                    || cellCoord(proxy.max[j]) != proxy.cellMax[j])
+                {
+                    sameCells = false;
+                    break;
+                }
+            }
+
+            if(sameCells)
+                continue;
+        }
+
+        unbin(i);
+        bin(i);
+    }
+}
+
+void HashGridPruner::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list) const
+{
+    for(auto &cell : cells_)
+    {
+        const auto &indices = cell.proxies;
+        for(size_t i = 0; i < indices.size(); i ++)
+        {
+            const Proxy &first = proxies_[indices[i]];
+            for(size_t j = i + 1; j < indices.size(); j ++)
+            {
+                const Proxy &second = proxies_[indices[j]];
+                if(!overlaps(first, second))
+                    continue;
+
+                /*
+                 * Two colliders can share many cells. Only list the pair from
+                 * the lowest cell they share so that it is listed once.
+                 */
+                bool lowest = true;
+                for(int k = 0; k < 3; k ++)
+                {
+                    if(max(first.cellMin[k], second.cellMin[k]) != cell.coord[k])
+                    {
+                        lowest = false;
+                        break;
+                    }
+                }
+
+                if(lowest)
+                    list.emplace_back(first.collider, second.collider);
+            }
+        }
+    }
+
+    /* Check the large colliders against everything else. */
+    for(auto index : largeProxies_)
+    {
+        const Proxy &first = proxies_[index];
+        for(uint32_t j = 0; j < proxies_.size(); j ++)
+        {
+            const Proxy &second = proxies_[j];
+            if(j == index || !second.inUse || !second.binned)
+                continue;
+
+            /* Pairs of large colliders are only listed by the first one. */
+            if(second.isLarge && j < index)
+                continue;
+
+            if(overlaps(first, second))
+                list.emplace_back(first.collider, second.collider);
+        }
+    }
+}
+
+void HashGridPruner::queryBox(
+        vector<shared_ptr<Collider>> &list,
+        const Box &box,
+        const QueryFilter &filter) const
+{
+    if(box.count() == 0)
+        return;
+
+    float min[3] = { box.min()[0], box.min()[1], box.min()[2] };
+    float max[3] = { box.max()[0], box.max()[1], box.max()[2] };
+    query(list, min, max, 0, filter);
+}
+
+void HashGridPruner::querySphere(
+        vector<shared_ptr<Collider>> &list,
+        const Vector3f &center,
+        float radius,
+        const QueryFilter &filter) const
+{
+    /* A sphere is a box of size zero grown by the radius. */
+    float point[3] = { center[0], center[1], center[2] };
+    query(list, point, point, radius * radius, filter);
+}
+
+void HashGridPruner::query(
+        vector<shared_ptr<Collider>> &list,
+        const float *min,
+        const float *max,
+        float radiusSquared,
+        const QueryFilter &filter) const
+{
+    float radius = sqrt(radiusSquared);
+    int cellMin[3];
+    int cellMax[3];
+    uint64_t cellCount = 1;
+    for(int i = 0; i < 3; i ++)
+    {
+        cellMin[i] = cellCoord(min[i] - radius);
+        cellMax[i] = cellCoord(max[i] + radius);
+        cellCount *= cellMax[i] - cellMin[i] + 1;
+    }
+
+    /* Visiting more cells than there are colliders would be slower. */
+    if(cellCount > proxies_.size())
+    {
+        for(auto &proxy : proxies_)
+        {
+            if(proxy.inUse
+                && proxy.binned
+                && distanceSquared(proxy, min, max) <= radiusSquared
+                && filter.accepts(*proxy.collider))
+            {
+                list.push_back(proxy.collider);
+            }
+        }
+        return;
+    }
+
+    for(int x = cellMin[0]; x <= cellMax[0]; x ++)
+    {
+        for(int y = cellMin[1]; y <= cellMax[1]; y ++)
+        {
+            for(int z = cellMin[2]; z <= cellMax[2]; z ++)
+            {
+                auto it = cellIndices_.find(cellKey(x, y, z));
+                if(it == end(cellIndices_))
+                    continue;
+
+                int coord[3] = { x, y, z };
+                for(auto index : cells_[it->second].proxies)
+                {
+                    /*
+                     * Only list a collider from the lowest cell it shares with
+                     * the query so that it is listed once.
+                     */
+                    const Proxy &proxy = proxies_[index];
+                    bool lowest = true;
+                    for(int k = 0; k < 3; k ++)
+                    {
+                        if(std::max(proxy.cellMin[k], cellMin[k]) != coord[k])
+                        {
+                            lowest = false;
+                            break;
+                        }
+                    }
+
+                    if(lowest
+                        && distanceSquared(proxy, min, max) <= radiusSquared
+                        && filter.accepts(*proxy.collider))
+                    {
+                        list.push_back(proxy.collider);
+                    }
+                }
+            }
+        }
+    }
+
+    for(auto index : largeProxies_)
+    {
+        const Proxy &proxy = proxies_[index];
+        if(distanceSquared(proxy, min, max) <= radiusSquared
+            && filter.accepts(*proxy.collider))
+        {
+            list.push_back(proxy.collider);
+        }
+    }
+}
+
+void HashGridPruner::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        const Vector3f &point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
+{
+    list.clear();
+
+    float p[3] = { point[0], point[1], point[2] };
+    for(auto &proxy : proxies_)
+    {
+        if(!proxy.inUse || !proxy.binned || !filter.accepts(*proxy.collider))
+            continue;
+
+        float distance = sqrt(distanceSquared(proxy, p, p));
+        if(distance <= maxDistance)
+            insertNearest(list, count, distance, proxy.collider);
+    }
+}
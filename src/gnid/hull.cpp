@@ -4,18 +4,106 @@
 #include <vector>
 
 #include "gnid/matrix/matrix.hpp"
+#include "gnid/quickhull.hpp"
 
 using namespace gnid;
 using namespace std;
 using namespace tmat;
 
-Hull::Hull(const vector<Vector3f> &points)
-    : points_(points)
+Hull::Hull(const vector<Vector3f> &points, bool findEdges)
 {
+    for(auto &start : starts_)
+        start = 0;
+
+    QuickHull hull(points);
+    if(!hull.isValid())
+    {
+        points_ = points;
+        return;
+    }
+
+    /* Keep only the corners, and find where each one ends up. */
+    vector<uint32_t> corners(points.size(), 0);
+    points_.reserve(hull.vertices().size());
+    for(uint32_t vertex : hull.vertices())
+    {
+        corners[vertex] = points_.size();
+        points_.push_back(points[vertex]);
+    }
+
+    if(!findEdges || points_.size() < MIN_CLIMBING_VERTICES)
+        return;
+
+    /* Every edge is shared by two triangles, once going each way. */
+    neighborOffsets_.assign(points_.size() + 1, 0);
+    for(auto &face : hull.faces())
+    {
+        for(int i = 0; i < 3; i ++)
+            neighborOffsets_[corners[face[i]] + 1] ++;
+    }
+    for(size_t i = 0; i < points_.size(); i ++)
+        neighborOffsets_[i + 1] += neighborOffsets_[i];
+
+    vector<uint32_t> counts(points_.size(), 0);
+    neighbors_.resize(neighborOffsets_.back());
+    for(auto &face : hull.faces())
+    {
+        for(int i = 0; i < 3; i ++)
+        {
+            uint32_t from = corners[face[i]];
+            neighbors_[neighborOffsets_[from] + counts[from] ++] =
+                corners[face[(i + 1) % 3]];
+        }
+    }
+}
+
+/**
+ * \brief Returns the dot product of two vectors in double precision
+ */
+static double preciseDot(const Vector3f &a, const Vector3f &b)
+{
+    return static_cast<double>(a[0]) * b[0]
+        + static_cast<double>(a[1]) * b[1]
+        + static_cast<double>(a[2]) * b[2];
 }
 
 Vector3f Hull::support(const tmat::Vector3f &d) const
 {
+    if(climbs())
+    {
+        /*
+         * Move to the neighbor furthest along d until none are further. On a
+         * convex hull, the corner this stops at is the furthest of them all.
+         * The dot products are found in double precision so that rounding
+         * can't make a neighbor look no further when it is.
+         */
+        int octant = (d[0] > 0) | (d[1] > 0) << 1 | (d[2] > 0) << 2;
+        uint32_t current = starts_[octant].load(memory_order_relaxed);
+        double currentMax = preciseDot(d, points_[current]);
+        while(true)
+        {
+            uint32_t next = current;
+            for(uint32_t i = neighborOffsets_[current];
+                    i < neighborOffsets_[current + 1];
+                    i ++)
+            {
+                double dot = preciseDot(d, points_[neighbors_[i]]);
+                if(dot > currentMax)
+                {
+                    currentMax = dot;
+                    next = neighbors_[i];
+                }
+            }
+
+            if(next == current)
+                break;
+            current = next;
+        }
+
+        starts_[octant].store(current, memory_order_relaxed);
+        return points_[current];
+    }
+
     float currentMax = -std::numeric_limits<float>::infinity();
     Vector3f currentPoint;
 
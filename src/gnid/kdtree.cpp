@@ -1,457 +1,1346 @@
 #include "gnid/kdtree.hpp"
 
-#include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
+
+#include "gnid/threadpool.hpp"
 
 using namespace std;
 using namespace tmat;
 using namespace gnid;
 
-KdTree::KdTree() : maxNodesPerLeaf_(1), maxShift_(0.5f)
+/**
+ * \brief Clear the bounds so that growing them takes the other bounds
+ */
+static void empty(float *min, float *max)
+{
+    for(int i = 0; i < 3; i ++)
+    {
+        min[i] = numeric_limits<float>::infinity();
+        max[i] = -numeric_limits<float>::infinity();
+    }
+}
+
+/**
+ * \brief Grow the first bounds to contain the second
+ */
+static void grow(float *min, float *max, const float *otherMin, const float *otherMax)
 {
+    for(int i = 0; i < 3; i ++)
+    {
+        if(otherMin[i] < min[i])
+            min[i] = otherMin[i];
+        if(otherMax[i] > max[i])
+            max[i] = otherMax[i];
+    }
 }
 
-KdTree::KdTree(const KdTree &other)
-    : maxNodesPerLeaf_(other.maxNodesPerLeaf_),
-      axisIndex(other.axisIndex),
-      median(other.median),
-      maxShift_(other.maxShift_),
-      totalNodes(other.totalNodes),
-      nodes(other.nodes)
+/*
+ * The number of subproblems the parallel traversal tries to split the work
+ * into. This does not depend on the number of threads, so that the pairs are
+ * always listed in the same order.
+ */
+static const size_t PARALLEL_TASK_COUNT = 256;
+
+template<typename T, typename U>
+static bool overlaps(const T &a, const U &b)
 {
-    if(other.left)
-        left = unique_ptr<KdTree>(new KdTree(*other.left));
-    if(other.right)
-        right = unique_ptr<KdTree>(new KdTree(*other.right));
+    for(int i = 0; i < 3; i ++)
+    {
+        if(a.max[i] < b.min[i] || a.min[i] > b.max[i])
+            return false;
+    }
+    return true;
 }
 
-KdTree::KdTree(KdTree &&other)
-    : maxNodesPerLeaf_(other.maxNodesPerLeaf_),
-      axisIndex(other.axisIndex),
-      median(other.median),
-      totalNodes(other.totalNodes)
+/**
+ * \brief
+ *     Find where a ray from the origin enters the given bounds grown by a box
+ *     moving along the ray
+ *
+ * \details
+ *     Returns false if the box does not reach the bounds within maxDistance.
+ */
+template<typename T>
+static bool enters(
+        float &distance,
+        const T &bounds,
+        const float *boxMin,
+        const float *boxMax,
+        const Vector3f &direction,
+        float maxDistance)
 {
-    swap(nodes, other.nodes);
-    swap(left, other.left);
-    swap(right, other.right);
+    float enter = 0;
+    float exit = maxDistance;
+    for(int i = 0; i < 3; i ++)
+    {
+        float min = bounds.min[i] - boxMax[i];
+        float max = bounds.max[i] - boxMin[i];
+
+        if(direction[i] == 0)
+        {
+            if(min > 0 || max < 0)
+                return false;
+            continue;
+        }
+
+        float near = min / direction[i];
+        float far = max / direction[i];
+        if(near > far)
+            swap(near, far);
+
+        if(near > enter)
+            enter = near;
+        if(far < exit)
+            exit = far;
+        if(enter > exit)
+            return false;
+    }
+
+    distance = enter;
+    return true;
+}
+
+/**
+ * \brief Returns the squared distance between the bounds and the query bounds
+ */
+template<typename T>
+static float distanceSquared(const T &bounds, const float *min, const float *max)
+{
+    float distance = 0;
+    for(int i = 0; i < 3; i ++)
+    {
+        float gap = 0;
+        if(bounds.max[i] < min[i])
+            gap = min[i] - bounds.max[i];
+        else if(bounds.min[i] > max[i])
+            gap = bounds.min[i] - max[i];
+        distance += gap * gap;
+    }
+    return distance;
+}
+
+KdTree::KdTree(unsigned int maxNodesPerLeaf)
+    : maxNodesPerLeaf_(maxNodesPerLeaf),
+      maxShift_(0.5f)
+{
+    assert(maxNodesPerLeaf_ > 0);
+    clear();
 }
 
 void KdTree::print(int indent)
 {
+    print(ROOT, indent);
+}
+
+void KdTree::print(uint32_t index, int indent) const
+{
+    const Node &node = nodes_[index];
     for(int i = 0; i < indent; i ++)
     {
         cout << " ";
     }
-    cout << box().min() << " " << box().max() << endl;
-    if(left)
+    cout << Vector3f { node.min[0], node.min[1], node.min[2] } << " "
+         << Vector3f { node.max[0], node.max[1], node.max[2] } << endl;
+    if(!node.isLeaf())
+    {
+        print(node.left, indent + 1);
+        print(node.right, indent + 1);
+    }
+}
+
+void KdTree::copyBounds(uint32_t slot)
+{
+    Slot &s = slots_[slot];
+    const Box &box = colliders_[slot]->box();
+    if(box.count() == 0)
+    {
+        empty(s.min, s.max);
+        return;
+    }
+
+    for(int i = 0; i < 3; i ++)
+    {
+        s.min[i] = box.min()[i];
+        s.max[i] = box.max()[i];
+    }
+}
+
+void KdTree::updateBox()
+{
+    const Node &root = nodes_[ROOT];
+    box_.clear();
+    if(root.min[0] <= root.max[0])
     {
-        assert(right);
-        left->print(indent + 1);
-        right->print(indent + 1);
+        box_.add(Vector3f { root.min[0], root.min[1], root.min[2] });
+        box_.add(Vector3f { root.max[0], root.max[1], root.max[2] });
     }
 }
 
 bool KdTree::update()
 {
-    /* If we are at an inner node. */
-    if(nodes.size() == 0)
+    bool updated = update(ROOT);
+
+    /* Pack the tree if more than half of it is unused. */
+    if(garbageNodes_ > nodes_.size() - garbageNodes_
+        || garbageItems_ > items_.size() - garbageItems_)
     {
-        assert(left && right);
+        compact();
+    }
 
-        bool updated = false;
+    updateBox();
+    return updated;
+}
+
+bool KdTree::update(uint32_t index)
+{
+    /*
+     * Regenerating the tree can add nodes, so references to nodes are not
+     * kept across calls.
+     */
+    Node &node = nodes_[index];
 
+    /* If we are at an inner node. */
+    if(!node.isLeaf())
+    {
         /* Regenerate if the maximum allowed shift is met. */
-        if(abs(box_.center()[axisIndex] - median) > maxShift_)
+        float center = (node.min[node.axisIndex] + node.max[node.axisIndex])
+            * 0.5f;
+        if(abs(center - node.median) > maxShift_)
         {
-            regenerate();
-            updated = true;
+            regenerate(index);
+            return true;
         }
-        else
-        {
-            /* Update the box from the sub nodes. */
-            bool updatedLeft = left->update();
-            bool updatedRight = right->update();
 
-            hasNonStaticNodes_ =
-                    left->hasNonStaticNodes_
-                    || right->hasNonStaticNodes_;
+        /* Update the box from the sub nodes. */
+        uint32_t left = node.left, right = node.right;
+        bool updatedLeft = update(left);
+        bool updatedRight = update(right);
 
-            if(updatedLeft || updatedRight)
-            {
-                box_.clear();
-                box_.add(left->box());
-                box_.add(right->box());
-                updated = true;
-            }
+        if(updatedLeft || updatedRight)
+        {
+            refit(index);
+            return true;
         }
 
-        return updated;
+        nodes_[index].hasNonStaticNodes =
+            nodes_[left].hasNonStaticNodes
+            || nodes_[right].hasNonStaticNodes;
+        return false;
     }
     /* If we are at a leaf node. */
     else
     {
         /* If we have too many nodes, generate the tree. */
-        if(static_cast<unsigned int>(nodes.size()) > maxNodesPerLeaf_)
+        if(node.count > maxNodesPerLeaf_)
         {
-            generate();
+            regenerate(index);
             return true;
         }
+
         /* Otherwise update the box from the nodes. */
-        else
+        bool updated = node.dirty;
+        node.dirty = false;
+        node.hasNonStaticNodes = false;
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
         {
-            bool updated = false;
-            for(auto node : nodes)
-            {
-                if(node->moved())
-                    updated = true;
-                if(!node->isStatic())
-                    hasNonStaticNodes_ = true;
-            }
+            uint32_t slot = items_[i];
+            const auto &collider = colliders_[slot];
 
-            if(updated)
+            slots_[slot].isStatic = collider->isStatic();
+            if(!slots_[slot].isStatic)
+                node.hasNonStaticNodes = true;
+
+            if(updated || collider->moved())
             {
-                box_.clear();
-                for(auto node : nodes)
-                {
-                    box_.add(node->box());
-                }
+                copyBounds(slot);
+                updated = true;
             }
-            return updated;
         }
+
+        if(updated)
+        {
+            refit(index);
+        }
+        return updated;
     }
 }
 
 void KdTree::add(std::shared_ptr<Collider> collider)
 {
-    /* Add to the total node count. */
-    totalNodes += 1;
+    assert(slotIndices_.find(collider.get()) == end(slotIndices_));
+
+    uint32_t slot;
+    if(freeSlots_.empty())
+    {
+        slot = slots_.size();
+        slots_.emplace_back();
+        colliders_.emplace_back();
+    }
+    else
+    {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+
+    colliders_[slot] = collider;
+    slotIndices_[collider.get()] = slot;
+    copyBounds(slot);
+    slots_[slot].isStatic = collider->isStatic();
+
+    /* Find the leaf to add the collider to, adding to the node counts. */
+    uint32_t index = ROOT;
+    while(true)
+    {
+        Node &node = nodes_[index];
+        node.total += 1;
+
+        if(node.isLeaf())
+            break;
+
+        const Slot &s = slots_[slot];
+        float center = (s.min[node.axisIndex] + s.max[node.axisIndex]) * 0.5f;
+        if(center < node.median)
+            index = node.left;
+        else
+            index = node.right;
+    }
+
     /*
-     * If we are a leaf node, add to the list of nodes.
+     * The leaf's items must stay together, so move them to the end of the
+     * list unless they are already there.
      */
-    if(!left)
+    Node &leaf = nodes_[index];
+    if(leaf.first + leaf.count != items_.size())
     {
-        assert(!right);
+        uint32_t first = items_.size();
+        for(uint32_t i = 0; i < leaf.count; i ++)
+        {
+            uint32_t item = items_[leaf.first + i];
+            slots_[item].position = items_.size();
+            items_.push_back(item);
+        }
+        garbageItems_ += leaf.count;
+        leaf.first = first;
+    }
 
-        nodes.push_back(collider);
+    slots_[slot].leaf = index;
+    slots_[slot].position = items_.size();
+    items_.push_back(slot);
+    leaf.count += 1;
+
+    /* The bounds will be updated on the next update. */
+    leaf.dirty = true;
+}
+
+bool KdTree::remove(shared_ptr<Collider> collider)
+{
+    auto it = slotIndices_.find(collider.get());
+    if(it == end(slotIndices_))
+        return false;
+
+    uint32_t slot = it->second;
+    slotIndices_.erase(it);
+
+    /* Move the last item of the leaf into the removed one's place. */
+    uint32_t leafIndex = slots_[slot].leaf;
+    Node &leaf = nodes_[leafIndex];
+    uint32_t last = leaf.first + leaf.count - 1;
+    items_[slots_[slot].position] = items_[last];
+    slots_[items_[last]].position = slots_[slot].position;
+    leaf.count -= 1;
+
+    if(last == items_.size() - 1)
+        items_.pop_back();
+    else
+        garbageItems_ += 1;
+
+    for(uint32_t i = leafIndex; i != NONE; i = nodes_[i].parent)
+        nodes_[i].total -= 1;
+
+    colliders_[slot] = nullptr;
+    freeSlots_.push_back(slot);
+
+    /* Replace the parent with the sibling if the leaf is now empty. */
+    if(leaf.count == 0 && leaf.parent != NONE)
+        collapse(leaf.parent, leafIndex);
+    else
+        refitAncestors(leafIndex);
+
+    updateBox();
+    return true;
+}
+
+void KdTree::collapse(uint32_t index, uint32_t emptyChild)
+{
+    Node &node = nodes_[index];
+    assert(!node.isLeaf());
+
+    uint32_t sibling = node.left == emptyChild ? node.right : node.left;
+    uint32_t parent = node.parent;
+
+    /* Take over the sibling's contents. */
+    node = nodes_[sibling];
+    node.parent = parent;
+
+    if(node.isLeaf())
+    {
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
+            slots_[items_[i]].leaf = index;
     }
-    /* Otherwise determine where to place the node. */
     else
     {
-        assert(left && right);
+        nodes_[node.left].parent = index;
+        nodes_[node.right].parent = index;
+    }
 
-        if(collider->box().center()[axisIndex] < median)
-            left->add(collider);
-        else
-            right->add(collider);
+    garbageNodes_ += 2;
+
+    if(parent != NONE)
+        refitAncestors(parent);
+}
+
+void KdTree::refit(uint32_t index)
+{
+    Node &node = nodes_[index];
+    empty(node.min, node.max);
+
+    if(node.isLeaf())
+    {
+        node.hasNonStaticNodes = false;
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
+        {
+            const Slot &slot = slots_[items_[i]];
+            grow(node.min, node.max, slot.min, slot.max);
+            if(!slot.isStatic)
+                node.hasNonStaticNodes = true;
+        }
     }
+    else
+    {
+        const Node &left = nodes_[node.left];
+        const Node &right = nodes_[node.right];
+        grow(node.min, node.max, left.min, left.max);
+        grow(node.min, node.max, right.min, right.max);
+        node.hasNonStaticNodes =
+            left.hasNonStaticNodes || right.hasNonStaticNodes;
+    }
+}
+
+void KdTree::refitAncestors(uint32_t index)
+{
+    for(uint32_t i = index; i != NONE; i = nodes_[i].parent)
+        refit(i);
 }
 
 void KdTree::clear()
 {
-    axisIndex = 0;
-    median = 0;
-    totalNodes = 0;
-    nodes.clear();
-    left = nullptr;
-    right = nullptr;
+    nodes_.clear();
+    items_.clear();
+    colliders_.clear();
+    slots_.clear();
+    freeSlots_.clear();
+    slotIndices_.clear();
+    scratch_.clear();
+    garbageNodes_ = 0;
+    garbageItems_ = 0;
+
+    /* The root is always the first node, even if the tree is empty. */
+    nodes_.emplace_back();
+    nodes_[ROOT].parent = NONE;
+    generate(ROOT, 0, 0);
     box_.clear();
 }
 
 void KdTree::listOverlappingNodes(
         vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list) const
 {
-    clearVisited();
-    listOverlappingNodesRecursive(list);
+    listOverlappingNodes(list, *this, *this, ROOT, ROOT);
 }
 
-void KdTree::listOverlappingNodesRecursive(
-        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list) const
+void KdTree::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list,
+        const KdTree &other) const
 {
-    /* Do not continue if the node has already been visited. */
-    if(visited_)
-        return;
-    visited_ = true;
+    assert(&other != this);
+    listOverlappingNodes(list, *this, other, ROOT, ROOT);
+}
 
-    /* Do not continue if the node only contains static nodes. */
-    if(!hasNonStaticNodes_)
-        return;
+void KdTree::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list,
+        ThreadPool &threadPool) const
+{
+    listOverlappingNodes(list, *this, *this, threadPool);
+}
 
+void KdTree::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list,
+        const KdTree &other,
+        ThreadPool &threadPool) const
+{
+    assert(&other != this);
+    listOverlappingNodes(list, *this, other, threadPool);
+}
+
+void KdTree::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list,
+        const KdTree &firstTree,
+        const KdTree &secondTree,
+        uint32_t first,
+        uint32_t second)
+{
     /*
-     * If the node is an inner node, list the overlaps between its child nodes.
+     * Pairs of nodes to check, with the first node from the first tree and the
+     * second node from the second tree. A node paired with itself lists the
+     * overlaps within the node.
      */
-    if(nodes.size() == 0)
+    vector<pair<uint32_t, uint32_t>> stack;
+    stack.emplace_back(first, second);
+
+    while(!stack.empty())
     {
-        assert(left && right);
-        listOverlappingNodes(list, *left, *right);
+        auto [a, b] = stack.back();
+        stack.pop_back();
+        visitPair(list, firstTree, secondTree, a, b, stack);
     }
+}
+
+void KdTree::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list,
+        const KdTree &firstTree,
+        const KdTree &secondTree,
+        ThreadPool &threadPool)
+{
     /*
-     * If the node is a leaf node, find the overlaps between its colliders
+     * Split the traversal into subproblems by visiting the pairs of inner nodes
+     * level by level. Pairs of leaf nodes are kept as they are, so nothing is
+     * listed until the subproblems are run.
      */
-    else
+    vector<pair<uint32_t, uint32_t>> tasks, next;
+    tasks.emplace_back(ROOT, ROOT);
+
+    while(tasks.size() < PARALLEL_TASK_COUNT)
     {
-        assert(!left && !right);
-        if(maxNodesPerLeaf_ != 1)
+        bool split = false;
+        next.clear();
+        for(auto [a, b] : tasks)
         {
-            for(auto &n1 : nodes)
+            if(firstTree.nodes_[a].isLeaf() && secondTree.nodes_[b].isLeaf())
+                next.emplace_back(a, b);
+            else
             {
-                for(auto &n2 : nodes)
-                {
-                    if(n1 != n2)
-                    {
-                        if(n1->box().overlaps(n2->box()))
-                        {
-                            list.emplace_back(n1, n2);
-                        }
-                    }
-                }
+                visitPair(list, firstTree, secondTree, a, b, next);
+                split = true;
             }
         }
+
+        swap(tasks, next);
+        if(!split)
+            break;
+    }
+
+    /*
+     * Each subproblem lists its pairs separately. The lists are joined in the
+     * order of the subproblems, so the result does not depend on the number
+     * of threads or which thread ran each subproblem.
+     */
+    vector<vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>>> results(
+            tasks.size());
+    threadPool.parallelFor(tasks.size(), [&](size_t i)
+    {
+        listOverlappingNodes(
+                results[i],
+                firstTree,
+                secondTree,
+                tasks[i].first,
+                tasks[i].second);
+    });
+
+    for(auto &result : results)
+    {
+        list.insert(
+                end(list),
+                make_move_iterator(begin(result)),
+                make_move_iterator(end(result)));
     }
 }
 
-void KdTree::listOverlappingNodes(
+void KdTree::visitPair(
         vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list,
-        const KdTree &first,
-        const KdTree &second)
+        const KdTree &firstTree,
+        const KdTree &secondTree,
+        uint32_t a,
+        uint32_t b,
+        vector<pair<uint32_t, uint32_t>> &stack)
 {
-    /* If the nodes overlap. */
-    if(first.box_.overlaps(second.box_) && (first.hasNonStaticNodes_ || second.hasNonStaticNodes_))
+    const bool sameTree = &firstTree == &secondTree;
+
+    auto listPair = [&](uint32_t first, uint32_t second)
     {
-        /* If the nodes are both inner nodes, check their children. */
-        if(first.nodes.size() == 0 && second.nodes.size() == 0)
+        const Slot &a = firstTree.slots_[first];
+        const Slot &b = secondTree.slots_[second];
+        if((!a.isStatic || !b.isStatic) && overlaps(a, b))
         {
-            assert(first.left && second.right);
+            list.emplace_back(
+                    firstTree.colliders_[first],
+                    secondTree.colliders_[second]);
+        }
+    };
 
-            listOverlappingNodes(list, *first.left,  *second.right);
-            listOverlappingNodes(list, *first.right, *second.left);
+    const Node &first = firstTree.nodes_[a];
+    const Node &second = secondTree.nodes_[b];
+
+    if(sameTree && a == b)
+    {
+        /* Do not continue if the node only contains static nodes. */
+        if(!first.hasNonStaticNodes)
+            return;
 
-            listOverlappingNodes(list, *first.left,  *second.left);
-            listOverlappingNodes(list, *first.right, *second.right);
-        }
         /*
-         * If the first one is a leaf node but the second is an inner node,
-         * check the first node against the second node's children.
+         * If the node is an inner node, list the overlaps within and
+         * between its child nodes.
          */
-        else if(first.nodes.size() != 0 && second.nodes.size() == 0)
+        if(!first.isLeaf())
         {
-            assert(!first.left && !first.right);
-            assert(second.left && second.right);
-
-            listOverlappingNodes(list, first, *second.left);
-            listOverlappingNodes(list, first, *second.right);
+            stack.emplace_back(first.left, first.right);
+            stack.emplace_back(first.right, first.right);
+            stack.emplace_back(first.left, first.left);
         }
         /*
-         * If the second one is a leaf node but the first is an inner node,
-         * check the second node against the first node's children.
+         * If the node is a leaf node, find the overlaps between its
+         * colliders.
          */
-        else if(second.nodes.size() != 0 && first.nodes.size() == 0)
+        else
         {
-            assert(!second.left && !second.right);
-            assert(first.left && first.right);
+            uint32_t end = first.first + first.count;
+            for(uint32_t i = first.first; i < end; i ++)
+            {
+                for(uint32_t j = i + 1; j < end; j ++)
+                    listPair(firstTree.items_[i], firstTree.items_[j]);
+            }
+        }
+        return;
+    }
+
+    if(!(first.hasNonStaticNodes || second.hasNonStaticNodes)
+        || !overlaps(first, second))
+    {
+        return;
+    }
 
-            listOverlappingNodes(list, second, *first.left);
-            listOverlappingNodes(list, second, *first.right);
+    /* If the nodes are both inner nodes, check their children. */
+    if(!first.isLeaf() && !second.isLeaf())
+    {
+        stack.emplace_back(first.left, second.right);
+        stack.emplace_back(first.right, second.left);
+        stack.emplace_back(first.left, second.left);
+        stack.emplace_back(first.right, second.right);
+    }
+    /*
+     * If the first one is a leaf node but the second is an inner node,
+     * check the first node against the second node's children.
+     */
+    else if(!second.isLeaf())
+    {
+        stack.emplace_back(a, second.left);
+        stack.emplace_back(a, second.right);
+    }
+    /*
+     * If the second one is a leaf node but the first is an inner node,
+     * check the second node against the first node's children.
+     */
+    else if(!first.isLeaf())
+    {
+        stack.emplace_back(first.left, b);
+        stack.emplace_back(first.right, b);
+    }
+    /*
+     * Otherwise, they are both leaf nodes, check the colliders they
+     * contain.
+     */
+    else
+    {
+        for(uint32_t i = first.first; i < first.first + first.count; i ++)
+        {
+            for(uint32_t j = second.first;
+                    j < second.first + second.count;
+                    j ++)
+            {
+                listPair(firstTree.items_[i], secondTree.items_[j]);
+            }
         }
-        /*
-         * Otherwise, they are both leaf nodes, check the colliders they
-         * contain.
-         */
+    }
+}
+
+void KdTree::listAllNodes(vector<shared_ptr<Collider>> &list) const
+{
+    vector<uint32_t> stack;
+    stack.push_back(ROOT);
+
+    while(!stack.empty())
+    {
+        const Node &node = nodes_[stack.back()];
+        stack.pop_back();
+
+        /* If the node is a leaf node, add its nodes to the list. */
+        if(node.isLeaf())
+        {
+            for(uint32_t i = node.first; i < node.first + node.count; i ++)
+                list.push_back(colliders_[items_[i]]);
+        }
+        /* If the node is an inner node, visit the left node first. */
         else
         {
-            /* Both nodes should be leaf nodes. */
-            assert(first.nodes.size() != 0 && second.nodes.size() != 0);
-            assert(!first.left && !first.right && !second.left && !second.right);
+            stack.push_back(node.right);
+            stack.push_back(node.left);
+        }
+    }
+}
+
+bool KdTree::raycast(
+        RaycastHit &hit,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    /* A ray is a box of size zero. */
+    float point[3] = { origin[0], origin[1], origin[2] };
+
+    float entry;
+    if(!enters(entry, nodes_[ROOT], point, point, direction, maxDistance))
+        return false;
+
+    return cast(
+            hit,
+            ROOT,
+            point,
+            point,
+            direction,
+            maxDistance,
+            [&](RaycastHit &out, const Collider &collider, float distance)
+            {
+                return collider.raycast(out, origin, direction, distance);
+            });
+}
+
+bool KdTree::sweep(
+        RaycastHit &hit,
+        const Shape &shape,
+        const Matrix4f &shapeToWorld,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    Box box;
+    box.add(shape, shapeToWorld, shapeToWorld.inverse());
+
+    float boxMin[3] = { box.min()[0], box.min()[1], box.min()[2] };
+    float boxMax[3] = { box.max()[0], box.max()[1], box.max()[2] };
+
+    float entry;
+    if(!enters(entry, nodes_[ROOT], boxMin, boxMax, direction, maxDistance))
+        return false;
+
+    return cast(
+            hit,
+            ROOT,
+            boxMin,
+            boxMax,
+            direction,
+            maxDistance,
+            [&](RaycastHit &out, const Collider &collider, float distance)
+            {
+                return collider.sweep(
+                        out,
+                        shape,
+                        shapeToWorld,
+                        direction,
+                        distance);
+            });
+}
+
+template<typename Test>
+bool KdTree::cast(
+        RaycastHit &hit,
+        uint32_t index,
+        const float *boxMin,
+        const float *boxMax,
+        const Vector3f &direction,
+        float &maxDistance,
+        const Test &test) const
+{
+    const Node &node = nodes_[index];
+    float distance;
+
+    if(node.isLeaf())
+    {
+        bool found = false;
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
+        {
+            uint32_t slot = items_[i];
+            if(!enters(
+                        distance,
+                        slots_[slot],
+                        boxMin,
+                        boxMax,
+                        direction,
+                        maxDistance))
+            {
+                continue;
+            }
 
-            for(auto &n1 : first.nodes)
+            if(test(hit, *colliders_[slot], maxDistance))
             {
-                for(auto &n2 : second.nodes)
-                {
-                    if(n1->box().overlaps(n2->box()))
-                    {
-                        list.emplace_back(n1, n2);
-                    }
-                }
+                hit.collider = colliders_[slot];
+                maxDistance = hit.distance;
+                found = true;
             }
         }
+        return found;
     }
 
-    first.listOverlappingNodesRecursive(list);
-    second.listOverlappingNodesRecursive(list);
+    uint32_t children[2] = { node.left, node.right };
+    float entries[2];
+    bool hits[2];
+    for(int i = 0; i < 2; i ++)
+    {
+        hits[i] = enters(
+                entries[i],
+                nodes_[children[i]],
+                boxMin,
+                boxMax,
+                direction,
+                maxDistance);
+    }
+
+    /* Visit the nearer child first, so that its hits can skip the other. */
+    if(hits[0] && hits[1] && entries[1] < entries[0])
+    {
+        swap(children[0], children[1]);
+        swap(entries[0], entries[1]);
+    }
+
+    bool found = false;
+    for(int i = 0; i < 2; i ++)
+    {
+        if(hits[i]
+            && entries[i] <= maxDistance
+            && cast(
+                hit,
+                children[i],
+                boxMin,
+                boxMax,
+                direction,
+                maxDistance,
+                test))
+        {
+            found = true;
+        }
+    }
+    return found;
 }
 
-void KdTree::listAllNodes(vector<shared_ptr<Collider>> &list) const
+void KdTree::queryBox(
+        vector<shared_ptr<Collider>> &list,
+        const Box &box,
+        const QueryFilter &filter) const
+{
+    if(box.count() == 0)
+        return;
+
+    float min[3] = { box.min()[0], box.min()[1], box.min()[2] };
+    float max[3] = { box.max()[0], box.max()[1], box.max()[2] };
+    query(list, ROOT, min, max, 0, filter);
+}
+
+void KdTree::querySphere(
+        vector<shared_ptr<Collider>> &list,
+        const Vector3f &center,
+        float radius,
+        const QueryFilter &filter) const
+{
+    /* A sphere is a box of size zero grown by the radius. */
+    float point[3] = { center[0], center[1], center[2] };
+    query(list, ROOT, point, point, radius * radius, filter);
+}
+
+void KdTree::query(
+        vector<shared_ptr<Collider>> &list,
+        uint32_t index,
+        const float *min,
+        const float *max,
+        float radiusSquared,
+        const QueryFilter &filter) const
+{
+    const Node &node = nodes_[index];
+    if(distanceSquared(node, min, max) > radiusSquared)
+        return;
+
+    if(node.isLeaf())
+    {
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
+        {
+            uint32_t slot = items_[i];
+            if(distanceSquared(slots_[slot], min, max) <= radiusSquared
+                && filter.accepts(*colliders_[slot]))
+            {
+                list.push_back(colliders_[slot]);
+            }
+        }
+        return;
+    }
+
+    query(list, node.left, min, max, radiusSquared, filter);
+    query(list, node.right, min, max, radiusSquared, filter);
+}
+
+void KdTree::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        const Vector3f &point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
+{
+    float p[3] = { point[0], point[1], point[2] };
+    queryNearest(list, ROOT, p, count, maxDistance, filter);
+}
+
+void KdTree::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        uint32_t index,
+        const float *point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
 {
-    /* If the node is a leaf node. */
-    if(nodes.size() > 0)
+    /* Once the list is full, only nearer colliders are of interest. */
+    if(list.size() >= count)
     {
-        /* Add this nodes nodes to the list. */
-        list.insert(end(list), begin(nodes), end(nodes));
+        if(count == 0)
+            return;
+        maxDistance = min(maxDistance, list.back().first);
     }
-    /* If the node is an inner node. */
-    else
+
+    const Node &node = nodes_[index];
+    if(node.isLeaf())
     {
-        assert(left && right);
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
+        {
+            uint32_t slot = items_[i];
+            float distance = distanceSquared(slots_[slot], point, point);
+            if(distance > maxDistance * maxDistance
+                || !filter.accepts(*colliders_[slot]))
+            {
+                continue;
+            }
 
-        left->listAllNodes(list);
-        right->listAllNodes(list);
+            CollisionPruner::insertNearest(
+                    list,
+                    count,
+                    sqrt(distance),
+                    colliders_[slot]);
+            if(list.size() >= count)
+                maxDistance = min(maxDistance, list.back().first);
+        }
+        return;
+    }
+
+    /* Visit the nearer child first so that more of the other is skipped. */
+    uint32_t children[2] = { node.left, node.right };
+    float distances[2] = {
+        distanceSquared(nodes_[node.left], point, point),
+        distanceSquared(nodes_[node.right], point, point)
+    };
+    if(distances[1] < distances[0])
+    {
+        swap(children[0], children[1]);
+        swap(distances[0], distances[1]);
+    }
+
+    for(int i = 0; i < 2; i ++)
+    {
+        if(list.size() >= count)
+            maxDistance = min(maxDistance, list.back().first);
+        if(distances[i] <= maxDistance * maxDistance)
+            queryNearest(list, children[i], point, count, maxDistance, filter);
     }
 }
 
 void KdTree::regenerate()
 {
-    /* If the node is a leaf node. */
-    if(nodes.size() > 0)
+    regenerate(ROOT);
+    updateBox();
+}
+
+void KdTree::regenerate(uint32_t index)
+{
+    scratch_.clear();
+    listSlots(index);
+
+    /* Regenerating the whole tree can start from empty lists. */
+    if(index == ROOT)
     {
-        generate();
+        nodes_.resize(1);
+        items_.clear();
+        garbageNodes_ = 0;
+        garbageItems_ = 0;
     }
-    /*
-     * If the node is an inner node, collect all of the colliders and re-add
-     * them.
-     */
     else
     {
-        left->listAllNodes(nodes);
-        right->listAllNodes(nodes);
-
-        left = nullptr;
-        right = nullptr;
-        box_.clear();
-        totalNodes = nodes.size();
-
-        generate();
+        garbageNodes_ += countNodes(index) - 1;
+        garbageItems_ += scratch_.size();
     }
+
+    generate(index, 0, scratch_.size());
 }
 
-void KdTree::clearVisited() const
+void KdTree::listSlots(uint32_t index)
 {
-    visited_ = false;
-    if(left)
+    const Node &node = nodes_[index];
+    if(node.isLeaf())
     {
-        assert(right);
-        left->clearVisited();
-        right->clearVisited();
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
+        {
+            uint32_t slot = items_[i];
+
+            /* Make sure the bounds are up to date before splitting. */
+            copyBounds(slot);
+            slots_[slot].isStatic = colliders_[slot]->isStatic();
+            scratch_.push_back(slot);
+        }
+    }
+    else
+    {
+        listSlots(node.left);
+        listSlots(node.right);
     }
 }
 
-void KdTree::generate()
+size_t KdTree::countNodes(uint32_t index) const
 {
-    assert(left == nullptr);
-    assert(right == nullptr);
+    const Node &node = nodes_[index];
+    if(node.isLeaf())
+        return 1;
+    return 1 + countNodes(node.left) + countNodes(node.right);
+}
 
+void KdTree::generate(uint32_t index, uint32_t begin, uint32_t end)
+{
     const auto tolerance = 0.0001f;
 
+    /*
+     * Build the node separately, since generating the children adds nodes to
+     * the list.
+     */
+    Node node;
+    node.parent = nodes_[index].parent;
+    node.left = NONE;
+    node.right = NONE;
+    node.first = items_.size();
+    node.count = 0;
+    node.total = end - begin;
+    node.axisIndex = 0;
+    node.median = 0;
+    node.hasNonStaticNodes = false;
+    node.dirty = false;
+
     /*
      * The box that contains all of the centers. We need to split using this box
      * to avoid cases where the median of the bounding box contains the centers
      * on one side.
      */
-    Box centerBox;
+    float centerMin[3], centerMax[3];
 
     /* Calculate the bounds of the nodes. */
-    box_.clear();
-    for(auto node : nodes)
+    empty(node.min, node.max);
+    empty(centerMin, centerMax);
+    for(uint32_t i = begin; i < end; i ++)
     {
-        box_.add(node->box());
-        centerBox.add(node->box().center());
+        const Slot &slot = slots_[scratch_[i]];
+        float center[3];
+        for(int j = 0; j < 3; j ++)
+            center[j] = (slot.min[j] + slot.max[j]) * 0.5f;
+
+        grow(node.min, node.max, slot.min, slot.max);
+        grow(centerMin, centerMax, center, center);
+        if(!slot.isStatic)
+            node.hasNonStaticNodes = true;
     }
 
-    /* Find the longest axis. */
-    Vector3f size = centerBox.size();
-    unsigned int longAxisIndex = 0;
-    float longAxisLength = size[longAxisIndex];
+    if(begin == end)
+    {
+        nodes_[index] = node;
+        return;
+    }
 
+    /* Split along the longest axis. */
     for(int i = 1; i < 3; i ++)
     {
-        if(size[i] > longAxisLength)
+        if(centerMax[i] - centerMin[i]
+            > centerMax[node.axisIndex] - centerMin[node.axisIndex])
         {
-            longAxisLength = size[i];
-            longAxisIndex = i;
+            node.axisIndex = i;
         }
     }
 
-    /* Split along the longest axis. */
-    axisIndex = longAxisIndex;
-    median = centerBox.center()[axisIndex];
+    const uint32_t axis = node.axisIndex;
+    float median = (centerMin[axis] + centerMax[axis]) * 0.5f;
 
     /* If we are at the correct number of nodes, stop generating. */
-    if(static_cast<unsigned int>(nodes.size()) <= maxNodesPerLeaf_)
+    if(end - begin <= maxNodesPerLeaf_)
     {
+        node.median = median;
+        node.count = end - begin;
+        for(uint32_t i = begin; i < end; i ++)
+        {
+            uint32_t slot = scratch_[i];
+            slots_[slot].leaf = index;
+            slots_[slot].position = items_.size();
+            items_.push_back(slot);
+        }
+        nodes_[index] = node;
         return;
     }
 
-    /* Create the left and right subtrees. */
-    left = make_unique<KdTree>();
-    right = make_unique<KdTree>();
-
     /* Split the nodes based on their center. */
-    int leftCount = 0, rightCount = 0;
-    for(auto node : nodes)
+    uint32_t middle = begin;
+    for(uint32_t i = begin; i < end; i ++)
     {
-        auto center = node->box().center()[axisIndex];
+        const Slot &slot = slots_[scratch_[i]];
+        float center = (slot.min[axis] + slot.max[axis]) * 0.5f;
+        uint32_t leftCount = middle - begin;
+        uint32_t rightCount = i - begin - leftCount;
         if(center < median
             || (abs(center - median) < tolerance && leftCount < rightCount))
         {
-            left->add(node);
-            leftCount ++;
+            swap(scratch_[i], scratch_[middle]);
+            middle ++;
         }
-        else
+    }
+
+    assert(middle > begin && middle < end);
+
+    /* Generate the children in depth first order. */
+    node.median = (node.min[axis] + node.max[axis]) * 0.5f;
+    nodes_[index] = node;
+
+    uint32_t left = nodes_.size();
+    nodes_.emplace_back();
+    nodes_[left].parent = index;
+    generate(left, begin, middle);
+
+    uint32_t right = nodes_.size();
+    nodes_.emplace_back();
+    nodes_[right].parent = index;
+    generate(right, middle, end);
+
+    nodes_[index].left = left;
+    nodes_[index].right = right;
+}
+
+void KdTree::compact()
+{
+    vector<Node> nodes;
+    vector<uint32_t> items;
+    nodes.reserve(nodes_.size() - garbageNodes_);
+    items.reserve(items_.size() - garbageItems_);
+
+    compact(ROOT, NONE, nodes, items);
+
+    swap(nodes, nodes_);
+    swap(items, items_);
+    garbageNodes_ = 0;
+    garbageItems_ = 0;
+}
+
+uint32_t KdTree::compact(
+        uint32_t index,
+        uint32_t parent,
+        vector<Node> &nodes,
+        vector<uint32_t> &items)
+{
+    uint32_t newIndex = nodes.size();
+    nodes.push_back(nodes_[index]);
+    nodes[newIndex].parent = parent;
+
+    const Node &node = nodes_[index];
+    if(node.isLeaf())
+    {
+        nodes[newIndex].first = items.size();
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
         {
-            right->add(node);
-            rightCount ++;
+            uint32_t slot = items_[i];
+            slots_[slot].leaf = newIndex;
+            slots_[slot].position = items.size();
+            items.push_back(slot);
         }
     }
+    else
+    {
+        uint32_t left = compact(node.left, newIndex, nodes, items);
+        uint32_t right = compact(node.right, newIndex, nodes, items);
+        nodes[newIndex].left = left;
+        nodes[newIndex].right = right;
+    }
+    return newIndex;
+}
 
-    assert(left->nodes.size() > 0 && right->nodes.size() > 0);
-    nodes.clear();
+int KdTree::depth()
+{
+    return depth(ROOT);
+}
 
-    left->generate();
-    right->generate();
-    median = box_.center()[longAxisIndex];
+int KdTree::depth(uint32_t index) const
+{
+    const Node &node = nodes_[index];
+    if(node.isLeaf())
+        return 1;
+    return 1 + max(depth(node.left), depth(node.right));
 }
 
-KdTreePruner::KdTreePruner(std::shared_ptr<KdTree> kdTree)
-    : kdTree_(kdTree)
+KdTreePruner::KdTreePruner(
+        shared_ptr<KdTree> kdTree,
+        shared_ptr<KdTree> staticTree)
+    : kdTree_(kdTree),
+      staticTree_(
+              staticTree
+              ? staticTree
+              : make_shared<KdTree>(kdTree->maxNodesPerLeaf())),
+      staticTreeChanged_(false)
 {
+    assert(kdTree_ != staticTree_);
 }
 
 void KdTreePruner::listOverlappingNodes(
         vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list) const
 {
-    kdTree_->listOverlappingNodes(list);
+    if(threadPool_)
+    {
+        kdTree_->listOverlappingNodes(list, *threadPool_);
+        kdTree_->listOverlappingNodes(list, *staticTree_, *threadPool_);
+    }
+    else
+    {
+        kdTree_->listOverlappingNodes(list);
+        kdTree_->listOverlappingNodes(list, *staticTree_);
+    }
 }
 
 void KdTreePruner::add(shared_ptr<Collider> collider)
 {
-    kdTree_->add(collider);
+    if(collider->isStatic())
+    {
+        staticTree_->add(collider);
+        staticTreeChanged_ = true;
+    }
+    else
+        kdTree_->add(collider);
 }
 
 void KdTreePruner::remove(shared_ptr<Collider> collider)
 {
-    vector<shared_ptr<Collider>> colliders;
+    if(!kdTree_->remove(collider))
+        staticTree_->remove(collider);
+}
 
-    /* Get all of the colliders. */
-    kdTree_->listAllNodes(colliders);
+void KdTreePruner::update()
+{
+    kdTree_->update();
 
-    /* Regenerate the tree excluding the given collider. */
-    kdTree_->clear();
-    for(auto &c : colliders)
+    if(staticTreeChanged_)
     {
-        if(c != collider)
-        {
-            kdTree_->add(c);
-        }
+        staticTree_->update();
+        staticTreeChanged_ = false;
     }
 }
 
-int KdTree::depth()
+void KdTreePruner::staticColliderMoved(shared_ptr<Collider>)
 {
-    return 1 + max(
-        left ? left->depth() : 0,
-        right ? right->depth() : 0);
+    staticTreeChanged_ = true;
 }
 
-void KdTreePruner::update()
+void KdTreePruner::listAllNodes(vector<shared_ptr<Collider>> &list) const
 {
-    kdTree_->update();
+    kdTree_->listAllNodes(list);
+    staticTree_->listAllNodes(list);
+}
+
+bool KdTreePruner::raycast(
+        RaycastHit &hit,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    Vector3f unitDirection = direction.normalized();
+
+    /* The second search only needs to look in front of the first hit. */
+    bool hitStatic =
+        staticTree_->raycast(hit, origin, unitDirection, maxDistance);
+    if(hitStatic)
+        maxDistance = hit.distance;
+
+    bool hitDynamic =
+        kdTree_->raycast(hit, origin, unitDirection, maxDistance);
+    return hitStatic || hitDynamic;
 }
 
+bool KdTreePruner::sweep(
+        RaycastHit &hit,
+        const Shape &shape,
+        const Matrix4f &from,
+        const Matrix4f &to) const
+{
+    Vector3f direction;
+    float maxDistance;
+    sweepPath(direction, maxDistance, from, to);
+
+    bool hitStatic =
+        staticTree_->sweep(hit, shape, from, direction, maxDistance);
+    if(hitStatic)
+        maxDistance = hit.distance;
+
+    bool hitDynamic =
+        kdTree_->sweep(hit, shape, from, direction, maxDistance);
+    return hitStatic || hitDynamic;
+}
+
+void KdTreePruner::queryBox(
+        vector<shared_ptr<Collider>> &list,
+        const Box &box,
+        const QueryFilter &filter) const
+{
+    /* The trees are split by isStatic(), so whole trees can be skipped. */
+    if(filter.dynamicColliders)
+        kdTree_->queryBox(list, box, filter);
+    if(filter.staticColliders)
+        staticTree_->queryBox(list, box, filter);
+}
+
+void KdTreePruner::querySphere(
+        vector<shared_ptr<Collider>> &list,
+        const Vector3f &center,
+        float radius,
+        const QueryFilter &filter) const
+{
+    if(filter.dynamicColliders)
+        kdTree_->querySphere(list, center, radius, filter);
+    if(filter.staticColliders)
+        staticTree_->querySphere(list, center, radius, filter);
+}
+
+void KdTreePruner::queryNearest(
+        vector<pair<float, shared_ptr<Collider>>> &list,
+        const Vector3f &point,
+        size_t count,
+        float maxDistance,
+        const QueryFilter &filter) const
+{
+    list.clear();
+    if(filter.dynamicColliders)
+        kdTree_->queryNearest(list, point, count, maxDistance, filter);
+    if(filter.staticColliders)
+        staticTree_->queryNearest(list, point, count, maxDistance, filter);
+}
@@ -38,6 +38,12 @@ ModelBuilder &ModelBuilder::loadPhysics(bool loadMesh)
     return *this;
 }
 
+ModelBuilder &ModelBuilder::physicsMode(ObjParser::PhysicsMode mode)
+{
+    physicsMode_ = mode;
+    return *this;
+}
+
 ModelBuilder &ModelBuilder::materials(const MaterialMapping &materials)
 {
     materials_ = materials;
@@ -106,11 +112,11 @@ std::shared_ptr<Node> ModelBuilder::build()
     }
     else if (!loadMesh_ && loadPhysics_)
     {
-        const auto node = objParser_->buildPhysicsNode();
+        node = objParser_->buildPhysicsNode(physicsMode_);
     }
     else
     {
-        node = objParser_->buildPhysicsNode();
+        node = objParser_->buildPhysicsNode(physicsMode_);
         node->add(objParser_->buildRendererNode(materials));
     }
 
@@ -1,4 +1,5 @@
 #include "gnid/objparser.hpp"
+#include <algorithm>
 #include <unordered_map>
 
 using namespace gnid;
@@ -144,10 +145,25 @@ ObjParser::Mesh &ObjParser::mesh()
     if (meshes.empty())
     {
         meshes.emplace_back();
+        meshes.back().object = objects;
     }
     return meshes.back();
 }
 
+void ObjParser::startObject()
+{
+    objects ++;
+
+    /* Keep using the current material in the new object. */
+    if(!meshes.empty() && !mesh().vIndices.empty())
+    {
+        std::string material = mesh().material;
+        meshes.emplace_back();
+        mesh().material = material;
+    }
+    mesh().object = objects;
+}
+
 bool ObjParser::parseVertex()
 {
     if(accept(TokenType::VERTEX))
@@ -299,6 +315,7 @@ bool ObjParser::parseUseMtl()
 
         meshes.emplace_back();
         mesh().material = name;
+        mesh().object = objects;
 
         return true;
     }
@@ -324,6 +341,7 @@ bool ObjParser::parseObject()
         parseString();
         expect(TokenType::STRING);
         std::string name = token;
+        startObject();
 
         return true;
     }
@@ -337,6 +355,7 @@ bool ObjParser::parseGroup()
         parseString();
         expect(TokenType::STRING);
         std::string name = token;
+        startObject();
 
         return true;
     }
@@ -400,9 +419,56 @@ void ObjParser::parse()
     done = true;
 }
 
-std::shared_ptr<Node> ObjParser::buildPhysicsNode()
+std::shared_ptr<Node> ObjParser::buildPhysicsNode(PhysicsMode mode)
 {
     std::shared_ptr<EmptyNode> ret = std::make_shared<EmptyNode>();
+    if (mode == HULLS) {
+        /* Gather the corners of every object, each one only once. */
+        std::vector<std::vector<int>> objectIndices(objects + 1);
+        for (const Mesh &mesh : meshes) {
+            std::vector<int> &indices = objectIndices[mesh.object];
+            indices.insert(
+                indices.end(),
+                mesh.vIndices.begin(),
+                mesh.vIndices.end());
+        }
+
+        for (std::vector<int> &indices : objectIndices) {
+            if (indices.empty())
+                continue;
+
+            std::sort(indices.begin(), indices.end());
+            indices.erase(
+                std::unique(indices.begin(), indices.end()),
+                indices.end());
+
+            std::vector<tmat::Vector3f> points;
+            for (int index : indices)
+                points.push_back(vertices[index].cut());
+            std::shared_ptr<Collider> collider = std::make_shared<Collider>(
+                std::make_shared<Hull>(points));
+            ret->add(collider);
+        }
+        return ret;
+    }
+
+    if (mode == MESH) {
+        std::vector<tmat::Vector3f> points;
+        for (const tmat::Vector4f &vertex : vertices)
+            points.push_back(vertex.cut());
+
+        std::vector<uint32_t> indices;
+        for (const Mesh &mesh : meshes)
+            indices.insert(
+                indices.end(),
+                mesh.vIndices.begin(),
+                mesh.vIndices.end());
+
+        ret->add(std::make_shared<Collider>(
+            std::make_shared<TriangleMesh>(points, indices)));
+        return ret;
+    }
+
     for (const Mesh &mesh : meshes) {
         for (int i = 0; i < mesh.vIndices.size(); i += 3) {
             std::vector<tmat::Vector3f> points;
@@ -0,0 +1,359 @@
+#include "gnid/quickhull.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "gnid/matrix/matrix.hpp"
+
+using namespace gnid;
+using namespace std;
+using namespace tmat;
+
+QuickHull::QuickHull(const vector<Vector3f> &points)
+    : failed_(false)
+{
+    points_.reserve(points.size());
+    for(auto &point : points)
+        points_.push_back(Point { point[0], point[1], point[2] });
+
+    /*
+     * Points within the rounding error of float coordinates of a face are
+     * treated as being on it.
+     */
+    Point largest = Point::zero;
+    for(auto &point : points_)
+    {
+        for(int i = 0; i < 3; i ++)
+            largest[i] = max(largest[i], fabs(point[i]));
+    }
+    tolerance_ = 3 * numeric_limits<float>::epsilon()
+        * (largest[0] + largest[1] + largest[2]);
+
+    uint32_t initial[4];
+    if(!findInitialPoints(initial))
+        return;
+
+    /* Wind the triangles so that their normals face out. */
+    Point ab = points_[initial[1]] - points_[initial[0]];
+    Point ac = points_[initial[2]] - points_[initial[0]];
+    Point ad = points_[initial[3]] - points_[initial[0]];
+    if(ab.cross(ac).dot(ad) > 0)
+        swap(initial[1], initial[2]);
+
+    addFace(initial[0], initial[1], initial[2]);
+    addFace(initial[0], initial[3], initial[1]);
+    addFace(initial[1], initial[3], initial[2]);
+    addFace(initial[2], initial[3], initial[0]);
+    connect(0);
+
+    vector<uint32_t> remaining;
+    for(uint32_t i = 0; i < points_.size(); i ++)
+    {
+        if(find(initial, initial + 4, i) == initial + 4)
+            remaining.push_back(i);
+    }
+    assign(remaining, 0);
+
+    /*
+     * Faces are only ever added to the end, and a face's outside points are
+     * only set when it is added, so one pass finishes the hull.
+     */
+    for(uint32_t i = 0; i < hull_.size() && !failed_; i ++)
+    {
+        if(!hull_[i].removed && !hull_[i].outside.empty())
+            addPoint(i);
+    }
+
+    /* Give up if rounding broke the hull. */
+    if(failed_)
+    {
+        hull_ = vector<Face>();
+        return;
+    }
+
+    for(auto &face : hull_)
+    {
+        if(face.removed)
+            continue;
+
+        faces_.push_back({
+                face.vertices[0],
+                face.vertices[1],
+                face.vertices[2] });
+        vertices_.insert(
+                vertices_.end(),
+                face.vertices,
+                face.vertices + 3);
+    }
+    sort(vertices_.begin(), vertices_.end());
+    vertices_.erase(
+            unique(vertices_.begin(), vertices_.end()),
+            vertices_.end());
+
+    /* Free the working space. */
+    hull_ = vector<Face>();
+}
+
+bool QuickHull::findInitialPoints(uint32_t *initial) const
+{
+    if(points_.size() < 4)
+        return false;
+
+    /* Start with the two furthest apart of the extreme points on each axis. */
+    uint32_t minimums[3] = { 0, 0, 0 };
+    uint32_t maximums[3] = { 0, 0, 0 };
+    for(uint32_t i = 0; i < points_.size(); i ++)
+    {
+        for(int j = 0; j < 3; j ++)
+        {
+            if(points_[i][j] < points_[minimums[j]][j])
+                minimums[j] = i;
+            if(points_[i][j] > points_[maximums[j]][j])
+                maximums[j] = i;
+        }
+    }
+
+    double furthest = 0;
+    for(int j = 0; j < 3; j ++)
+    {
+        Point offset = points_[maximums[j]] - points_[minimums[j]];
+        if(offset.magnitude() > furthest)
+        {
+            furthest = offset.magnitude();
+            initial[0] = minimums[j];
+            initial[1] = maximums[j];
+        }
+    }
+    if(furthest <= tolerance_)
+        return false;
+
+    /* Then the point furthest from the line through them. */
+    Point direction =
+        (points_[initial[1]] - points_[initial[0]]).normalized();
+    furthest = 0;
+    for(uint32_t i = 0; i < points_.size(); i ++)
+    {
+        double distance =
+            (points_[i] - points_[initial[0]]).cross(direction).magnitude();
+        if(distance > furthest)
+        {
+            furthest = distance;
+            initial[2] = i;
+        }
+    }
+    if(furthest <= tolerance_)
+        return false;
+
+    /* Then the point furthest from the plane through all three. */
+    Point normal =
+        (points_[initial[1]] - points_[initial[0]])
+            .cross(points_[initial[2]] - points_[initial[0]])
+            .normalized();
+    furthest = 0;
+    for(uint32_t i = 0; i < points_.size(); i ++)
+    {
+        double distance = fabs((points_[i] - points_[initial[0]]).dot(normal));
+        if(distance > furthest)
+        {
+            furthest = distance;
+            initial[3] = i;
+        }
+    }
+    return furthest > tolerance_;
+}
+
+void QuickHull::addFace(uint32_t a, uint32_t b, uint32_t c)
+{
+    Face face;
+    face.vertices[0] = a;
+    face.vertices[1] = b;
+    face.vertices[2] = c;
+    for(int i = 0; i < 3; i ++)
+    {
+        face.neighbors[i] = NONE;
+        face.neighborEdges[i] = NONE;
+    }
+    face.removed = false;
+
+    Point ab = points_[b] - points_[a];
+    Point ac = points_[c] - points_[a];
+    face.normal = ab.cross(ac);
+
+    /* A face with no area has nothing in front of it. */
+    if(face.normal == Point::zero)
+    {
+        face.distance = numeric_limits<double>::infinity();
+    }
+    else
+    {
+        face.normal.normalize();
+        face.distance = face.normal.dot(points_[a]);
+    }
+
+    hull_.push_back(move(face));
+}
+
+void QuickHull::link(
+        uint32_t first,
+        uint32_t firstEdge,
+        uint32_t second,
+        uint32_t secondEdge)
+{
+    hull_[first].neighbors[firstEdge] = second;
+    hull_[first].neighborEdges[firstEdge] = secondEdge;
+    hull_[second].neighbors[secondEdge] = first;
+    hull_[second].neighborEdges[secondEdge] = firstEdge;
+}
+
+void QuickHull::connect(uint32_t first)
+{
+    /* Neighbors share the same edge, going the opposite way. */
+    for(uint32_t i = first; i < hull_.size(); i ++)
+    {
+        for(uint32_t edge = 0; edge < 3; edge ++)
+        {
+            if(hull_[i].neighbors[edge] != NONE)
+                continue;
+
+            uint32_t start = hull_[i].vertices[edge];
+            uint32_t end = hull_[i].vertices[(edge + 1) % 3];
+            for(uint32_t j = i + 1; j < hull_.size(); j ++)
+            {
+                for(uint32_t other = 0; other < 3; other ++)
+                {
+                    if(hull_[j].vertices[other] == end
+                        && hull_[j].vertices[(other + 1) % 3] == start)
+                    {
+                        link(i, edge, j, other);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void QuickHull::assign(const vector<uint32_t> &points, uint32_t first)
+{
+    for(uint32_t point : points)
+    {
+        for(uint32_t i = first; i < hull_.size(); i ++)
+        {
+            Face &face = hull_[i];
+            if(face.normal.dot(points_[point]) - face.distance > tolerance_)
+            {
+                face.outside.push_back(point);
+                break;
+            }
+        }
+    }
+}
+
+void QuickHull::addPoint(uint32_t visible)
+{
+    /* Find the outside point furthest from the face. */
+    const Point &normal = hull_[visible].normal;
+    uint32_t eye = hull_[visible].outside[0];
+    for(uint32_t point : hull_[visible].outside)
+    {
+        if(normal.dot(points_[point]) > normal.dot(points_[eye]))
+            eye = point;
+    }
+
+    stack_.clear();
+    horizon_.clear();
+    orphans_.clear();
+
+    /* Walk from the visible face, stopping at the hidden ones. */
+    hull_[visible].removed = true;
+    orphans_.swap(hull_[visible].outside);
+    for(uint32_t edge = 0; edge < 3; edge ++)
+    {
+        stack_.emplace_back(
+                hull_[visible].neighbors[edge],
+                hull_[visible].neighborEdges[edge]);
+    }
+
+    while(!stack_.empty())
+    {
+        auto [index, edge] = stack_.back();
+        stack_.pop_back();
+
+        Face &face = hull_[index];
+        if(face.removed)
+            continue;
+
+        /* A hidden face's edge is part of the horizon. */
+        if(face.normal.dot(points_[eye]) - face.distance <= 0)
+        {
+            horizon_.emplace_back(index, edge);
+            continue;
+        }
+
+        face.removed = true;
+        orphans_.insert(
+                orphans_.end(),
+                face.outside.begin(),
+                face.outside.end());
+        face.outside = vector<uint32_t>();
+
+        for(uint32_t i = 1; i < 3; i ++)
+        {
+            uint32_t next = (edge + i) % 3;
+            stack_.emplace_back(face.neighbors[next], face.neighborEdges[next]);
+        }
+    }
+
+    if(!isLoop(horizon_))
+    {
+        failed_ = true;
+        return;
+    }
+
+    /* Create new faces from the horizon edges to the eye point. */
+    uint32_t first = hull_.size();
+    for(auto [hidden, edge] : horizon_)
+    {
+        uint32_t start = hull_[hidden].vertices[edge];
+        uint32_t end = hull_[hidden].vertices[(edge + 1) % 3];
+        addFace(end, start, eye);
+        link(hull_.size() - 1, 0, hidden, edge);
+    }
+    connect(first);
+
+    /* Give the points outside of the removed faces to the new ones. */
+    orphans_.erase(
+            remove(orphans_.begin(), orphans_.end(), eye),
+            orphans_.end());
+    assign(orphans_, first);
+}
+
+bool QuickHull::isLoop(const vector<pair<uint32_t, uint32_t>> &edges) const
+{
+    /* Follow the edges from the end of each to the start of the next. */
+    uint32_t current = 0;
+    for(size_t count = 0; count < edges.size(); count ++)
+    {
+        const Face &face = hull_[edges[current].first];
+        uint32_t end = face.vertices[edges[current].second];
+
+        uint32_t next = NONE;
+        for(uint32_t i = 0; i < edges.size(); i ++)
+        {
+            const Face &other = hull_[edges[i].first];
+            if(other.vertices[(edges[i].second + 1) % 3] == end)
+            {
+                /* More than one edge leaves the same corner. */
+                if(next != NONE)
+                    return false;
+                next = i;
+            }
+        }
+
+        /* The loop ends early, or doesn't end. */
+        if(next == NONE || (next == 0) != (count + 1 == edges.size()))
+            return false;
+        current = next;
+    }
+    return true;
+}
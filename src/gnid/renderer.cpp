@@ -18,6 +18,7 @@
 
 using namespace gnid;
 using namespace std;
+using namespace tmat;
 
 Binding::Binding(
     shared_ptr<Material> material,
@@ -46,6 +47,41 @@ bool Binding::operator<(const Binding &other) const
         return false;
 }
 
+Matrix4f Renderer::blend(
+        const Matrix4f &previous,
+        const Matrix4f &current,
+        float alpha)
+{
+    /*
+     * Blending each element keeps the translation exact. The rotation is only
+     * approximate, which is not noticeable over the length of one update.
+     */
+    Matrix4f blended;
+    for(int i = 0; i < 4; i ++)
+        blended[i] = previous[i] * (1 - alpha) + current[i] * alpha;
+    return blended;
+}
+
+Matrix4f Renderer::modelMatrix(const Binding &binding, float alpha)
+{
+    const Matrix4f &current = binding.node->worldMatrix();
+    if(alpha >= 1 || !binding.hasPreviousWorldMatrix)
+        return current;
+    return blend(binding.previousWorldMatrix, current, alpha);
+}
+
+Matrix4f Renderer::viewMatrix(const Camera &camera, float alpha)
+{
+    if(alpha >= 1 || !camera.hasPreviousWorldMatrix())
+        return camera.viewMatrix();
+
+    /* The camera moves with the nodes, so that they don't jitter in view. */
+    return blend(
+            camera.previousWorldMatrix(),
+            camera.worldMatrix(),
+            alpha).inverse();
+}
+
 void Renderer::renderMesh(
     shared_ptr<RendererMesh> mesh,
     int instanceCount) const
@@ -73,12 +109,13 @@ void Renderer::updateLights(
     }
 }
 
-void Renderer::render(shared_ptr<Camera> camera) const
+void Renderer::render(shared_ptr<Camera> camera, float alpha) const
 {
     /* The material and mesh currently in use. */
     shared_ptr<Material> material = nullptr;
     shared_ptr<RendererMesh> mesh = nullptr;
     int instanceCount = 0;
+    Matrix4f view = viewMatrix(*camera, alpha);
 
     for(auto it = begin(bindings);
         it != end(bindings);
@@ -106,7 +143,7 @@ void Renderer::render(shared_ptr<Camera> camera) const
             glBindVertexArray(mesh->vao);
             it->material->shader()->setModelViewMatrix(
                     0,
-                    camera->viewMatrix() * it->node->worldMatrix());
+                    view * modelMatrix(*it, alpha));
             instanceCount = 1;
         }
         else if(it->mesh != mesh)
@@ -120,7 +157,7 @@ void Renderer::render(shared_ptr<Camera> camera) const
             glBindVertexArray(mesh->vao);
             it->material->shader()->setModelViewMatrix(
                     0,
-                    camera->viewMatrix() * it->node->worldMatrix());
+                    view * modelMatrix(*it, alpha));
             instanceCount = 1;
             updateLights(camera, it->material->shader());
         }
@@ -136,7 +173,7 @@ void Renderer::render(shared_ptr<Camera> camera) const
 
             it->material->shader()->setModelViewMatrix(
                     instanceCount,
-                    camera->viewMatrix() * it->node->worldMatrix());
+                    view * modelMatrix(*it, alpha));
             updateLights(camera, it->material->shader());
             instanceCount ++;
         }
@@ -148,6 +185,18 @@ void Renderer::render(shared_ptr<Camera> camera) const
     }
 }
 
+void Renderer::savePreviousMatrices(const list<shared_ptr<Camera>> &cameras)
+{
+    for(auto &binding : bindings)
+    {
+        binding.previousWorldMatrix = binding.node->worldMatrix();
+        binding.hasPreviousWorldMatrix = true;
+    }
+
+    for(auto &camera : cameras)
+        camera->savePreviousMatrix();
+}
+
 void Renderer::add(Binding binding)
 {
     bindings.insert(binding);
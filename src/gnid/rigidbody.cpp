@@ -7,25 +7,61 @@ using namespace tmat;
 using namespace gnid;
 
 Rigidbody::Rigidbody(float mass)
-    : mass_(mass)
+    : sleeping_(false),
+      mass_(mass),
+      continuous_(false),
+      restingFrames_(0),
+      store_(nullptr),
+      index_(0)
 {
 }
 
-void Rigidbody::physicsUpdate(float dt)
+void Rigidbody::addImpulse(const Vector3f &impulse)
 {
-    transformWorld(getTranslateMatrix(velocity_ * dt));
+    if(impulse == Vector3f::zero)
+        return;
+    wake();
+    velocityRef() += impulse * inverseMass();
 }
 
-void Rigidbody::addImpulse(const Vector3f &impulse)
+void Rigidbody::wake()
+{
+    if(!sleeping())
+        return;
+
+    if(store_)
+        store_->flags[index_] &= ~BodyStore::SLEEPING;
+    else
+        sleeping_ = false;
+    restingFrames_ = 0;
+}
+
+void Rigidbody::sleep()
 {
-    velocity_ += impulse * (1.0f / mass_);
+    if(store_)
+        store_->flags[index_] |= BodyStore::SLEEPING;
+    else
+        sleeping_ = true;
+    velocityRef() = Vector3f::zero;
 }
 
-float &Rigidbody::mass()
+float Rigidbody::mass() const
 {
     return mass_;
 }
 
+void Rigidbody::setMass(float mass)
+{
+    mass_ = mass;
+    if(store_)
+        store_->inverseMasses[index_] = inverseMass();
+}
+
+bool &Rigidbody::continuous()
+{
+    return continuous_;
+}
+
 void Rigidbody::onSceneChanged(shared_ptr<Scene> newScene)
 {
     auto oldScene = getScene().lock();
@@ -1,6 +1,8 @@
 #include "gnid/scene.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <set>
 
 #include "gnid/renderernode.hpp"
@@ -9,17 +11,49 @@
 #include "gnid/spatialnode.hpp"
 #include "gnid/collider.hpp"
 #include "gnid/collision.hpp"
+#include "gnid/distanceresult.hpp"
+#include "gnid/queryfilter.hpp"
+#include "gnid/raycasthit.hpp"
 #include "gnid/rigidbody.hpp"
+#include "gnid/threadpool.hpp"
 
 using namespace tmat;
 using namespace gnid;
 using namespace std;
 
+/*
+ * How far short of a hit a continuous rigidbody is stopped, so that it is
+ * left just apart from what it hit.
+ */
+static const float CONTINUOUS_SKIN = 0.001f;
+
+/*
+ * The number of pairs checked together by one thread. The results of each
+ * group are kept in their own list, so that threads do not share any lists.
+ */
+static const size_t PAIR_GROUP_SIZE = 64;
+
+/**
+ * \brief Wake the rigid bodies of two colliders, if they have any
+ */
+static void wakeBodies(
+        const shared_ptr<Collider> &a,
+        const shared_ptr<Collider> &b)
+{
+    for(auto &collider : { a, b })
+    {
+        auto rb = collider->findAncestorByType<Rigidbody>();
+        if(rb)
+            rb->wake();
+    }
+}
+
 Scene::Scene()
     : root(make_shared<EmptyNode>()),
-      kdTree(make_shared<KdTree>()),
-      pruner(kdTree),
-      gravity_ { 0.0f, -9.8f, 0.0f }
+      pruner_(make_shared<KdTreePruner>(make_shared<KdTree>())),
+      gravity_ { 0.0f, -9.8f, 0.0f },
+      sleepVelocity_(0.05f),
+      sleepFrames_(60)
 {
 }
 
@@ -36,10 +70,19 @@ void Scene::handleCollision(
     Collision collision(a, b, overlap);
     auto item = collisions.insert(collision);
 
+    /* The collision may have been stored with the colliders the other way. */
+    const auto &colliders = item.first->colliders();
+    Vector3f relativeOverlap = colliders[0] == a ? overlap : -overlap;
+    item.first->manifold_.update(
+            *colliders[0],
+            *colliders[1],
+            relativeOverlap);
+    frameCollisions_.push_back(&*item.first);
+
     /* Collision already exists, send collisionStayed event. */
     if(!item.second)
     {
-        item.first->overlap_ = overlap;
+        item.first->overlap_ = relativeOverlap;
         item.first->visited_ = true;
         
         item.first->colliders()[0]->notifyCollisionObservers(
@@ -59,140 +102,340 @@ void Scene::handleCollision(
                 item.first->swapped(),
                 item.first->colliders()[1]->collisionEnteredObservers);
     }
+}
 
-    /* Move the objects away from each other if necessary. */
-    auto as = a->findAncestorByType<Rigidbody>();
-    auto bs = b->findAncestorByType<Rigidbody>();
-
-    auto lenOverlap = overlap.magnitude();
+void Scene::moveContinuous(
+        const shared_ptr<Rigidbody> &rb,
+        const Vector3f &motion)
+{
+    float distance = motion.magnitude();
+
+    /*
+     * Find the solid colliders of the body, and the smallest half size of
+     * their boxes. A body moving less than that can't pass through anything
+     * without the discrete checks seeing the overlap.
+     */
+    continuousNodes_.clear();
+    continuousColliders_.clear();
+    rb->listDescendants(continuousNodes_);
+
+    float extent = numeric_limits<float>::infinity();
+    for(auto &node : continuousNodes_)
+    {
+        auto collider = dynamic_pointer_cast<Collider>(node);
+        if(!collider || !collider->isActive() || collider->isTrigger())
+            continue;
+        if(collider->findAncestorByType<Rigidbody>() != rb)
+            continue;
+
+        Box box;
+        box.add(
+                *collider->shape(),
+                collider->worldMatrix(),
+                collider->worldMatrixInverse());
+        Vector3f size = box.size();
+        extent = min(extent, 0.5f * min(size[0], min(size[1], size[2])));
+        continuousColliders_.push_back(collider);
+    }
 
-    /* Nothing to do if no overlap. */
-    if(lenOverlap == 0)
+    if(distance <= extent)
+    {
+        rb->transformWorld(getTranslateMatrix(motion));
         return;
+    }
 
-    const auto normal = overlap * (1.0 / lenOverlap);
+    /* Sweep each collider along the motion and keep the nearest hit. */
+    Vector3f direction = motion * (1.0f / distance);
+    QueryFilter filter;
+    filter.triggers = false;
 
-    /* Nothing to do if either is a trigger. */
-    if(a->isTrigger() || b->isTrigger())
-        return;
-
-    /* If as is a rigidbody. */
-    if(as && as->isActive())
+    RaycastHit nearest;
+    nearest.distance = distance;
+    bool hasHit = false;
+    for(auto &collider : continuousColliders_)
     {
-        float lenVelocityA = as->velocity_.magnitude();
-        /* If they are both rigidbodies, move them away from eachother. */
-        if(bs && bs->isActive())
+        const auto &toWorld = collider->worldMatrix();
+        Box swept;
+        swept.add(*collider->shape(), toWorld, collider->worldMatrixInverse());
+        swept.add(swept.min() + motion);
+        swept.add(swept.max() + motion);
+
+        continuousCandidates_.clear();
+        pruner_->queryBox(continuousCandidates_, swept, filter);
+        for(auto &candidate : continuousCandidates_)
         {
-            float lenVelocityB = bs->velocity_.magnitude();
-            as->transformWorld(getTranslateMatrix(-overlap * 0.5f));
-            bs->transformWorld(getTranslateMatrix(overlap * 0.5f));
+            if(!candidate->isActive()
+                    || candidate->findAncestorByType<Rigidbody>() == rb)
+            {
+                continue;
+            }
 
-            /* Calculate the new velocities. */
-            if(lenVelocityA > 0)
+            /*
+             * The sweep starts from further back, so that a body already
+             * touching the other one still finds the normal between them.
+             */
+            RaycastHit hit;
+            if(!candidate->sweep(
+                        hit,
+                        *collider->shape(),
+                        getTranslateMatrix(-direction * extent) * toWorld,
+                        direction,
+                        nearest.distance + extent)
+                    || hit.distance == 0
+                    || hit.normal.dot(direction) >= 0)
             {
-                as->velocity_ -= normal * as->velocity_.dot(normal);
-                /* Apply friction. TODO change constant. */
-                as->velocity_ *= 0.9;
+                continue;
             }
+            hit.distance -= extent;
 
-            if(lenVelocityB > 0)
+            /*
+             * A hit behind the start only counts if the body touches the other
+             * one now, rather than having already moved past it.
+             */
+            if(hit.distance <= 0)
             {
-                bs->velocity_ -= normal * bs->velocity_.dot(normal);
-                /* Apply friction. TODO change constant. */
-                bs->velocity_ *= 0.9;
+                DistanceResult gap;
+                if(collider->getDistance(gap, candidate, extent)
+                        && gap.distance > CONTINUOUS_SKIN)
+                {
+                    continue;
+                }
+                hit.distance = 0;
             }
-        }
-        /* If just as is a rigidbody, move it away. */
-        else
-        {
-            as->transformWorld(getTranslateMatrix(-overlap));
 
-            /* Calculate the new velocity. */
-            if(lenVelocityA > 0)
+            if(!hasHit || hit.distance < nearest.distance)
             {
-                as->velocity_ -= normal * as->velocity_.dot(normal);
-                /* Apply friction. TODO change constant. */
-                as->velocity_ *= 0.9;
+                nearest = hit;
+                hasHit = true;
             }
         }
     }
-    /* If as is not a rigidbody. */
-    else
+
+    if(!hasHit)
     {
-        /* If bs is a rigidbody, move it away. */
-        if(bs && bs->isActive())
-        {
-            float lenVelocityB = bs->velocity_.magnitude();
-            bs->transformWorld(getTranslateMatrix(overlap));
+        rb->transformWorld(getTranslateMatrix(motion));
+        return;
+    }
 
-            if(lenVelocityB > 0)
-            {
-                bs->velocity_ -= normal * bs->velocity_.dot(normal);
-                /* Apply friction. TODO change constant. */
-                bs->velocity_ *= 0.9;
-            }
+    /*
+     * Stop at the time of impact and drop the velocity into the surface. The
+     * rest of the motion this update is lost.
+     */
+    float travel = max(0.0f, nearest.distance - CONTINUOUS_SKIN);
+    rb->transformWorld(getTranslateMatrix(direction * travel));
+
+    Vector3f &velocity = rb->velocityRef();
+    float into = velocity.dot(nearest.normal);
+    if(into < 0)
+        velocity -= nearest.normal * into;
+}
+
+bool Scene::checkPair(
+        PairResult &result,
+        const shared_ptr<Collider> &a,
+        const shared_ptr<Collider> &b,
+        bool tracksPairs,
+        const unordered_set<Collision> &newPairs) const
+{
+    /* We only need to check if either collider is active. */
+    if(!a->isActive() || !b->isActive())
+        return false;
+
+    auto as = a->findAncestorByType<Rigidbody>();
+    auto bs = b->findAncestorByType<Rigidbody>();
+    if(!as && !bs)
+        return false;
+
+    result.a = a;
+    result.b = b;
+    result.overlapping = false;
+    result.checked = false;
+
+    Collision pair(a, b, Vector3f::zero);
+    bool unchanged = tracksPairs
+        && !a->moved() && !b->moved()
+        && lastResolvedBodies_.find(as) == end(lastResolvedBodies_)
+        && lastResolvedBodies_.find(bs) == end(lastResolvedBodies_)
+        && newPairs.find(pair) == end(newPairs);
+
+    /*
+     * Nothing moves between sleeping bodies and static colliders either,
+     * unless one of the colliders was moved by something else, or the pair
+     * was not checked before.
+     */
+    if(!unchanged)
+    {
+        unchanged = (!as || as->sleeping()) && (!bs || bs->sleeping())
+            && !a->moved() && !b->moved()
+            && separatingAxes_.find(pair) != end(separatingAxes_)
+            && newPairs.find(pair) == end(newPairs);
+    }
+
+    /* Reuse the last result if nothing changed. */
+    if(unchanged)
+    {
+        auto it = collisions.find(pair);
+        if(it != end(collisions))
+        {
+            result.overlapping = true;
+            result.overlap =
+                it->colliders()[0] == a ? it->overlap() : -it->overlap();
         }
-        /* Otherwise neither are rigidbodies, so nothing to do. */
+        return true;
+    }
+
+    /* Start from the axis found last time. */
+    Vector3f initialAxis = Vector3f::right;
+    auto axis = separatingAxes_.find(pair);
+    if(axis != end(separatingAxes_))
+    {
+        bool flipped = axis->first.colliders()[0] != a;
+        initialAxis = flipped ? -axis->second : axis->second;
     }
+
+    result.overlapping = a->getOverlap(result.overlap, initialAxis, b);
+    result.axis = initialAxis;
+    result.checked = true;
+    return true;
 }
 
 void Scene::update(float dt)
 {
+    renderer.savePreviousMatrices(cameras);
+
     vector<shared_ptr<Node>> nodes;
     root->listDescendants(nodes);
-    for(const auto node : nodes)
-        node->newFrame();
     for(const auto node : nodes)
         node->update(dt);
 
-    Vector3f overlap;
+    /*
+     * Update the rigid bodies. Gravity is added after moving, so that the
+     * contact solver can take it away again from bodies that rest on
+     * something.
+     */
+    bodyStore_.readPositions();
+    bodyStore_.integrate(dt, gravity_, threadPool_.get());
 
-    /* Update the rigid bodies. */
-    for(auto &rb : rigidbodies)
+    /* Write the new positions back to the nodes. */
+    for(size_t i = 0; i < bodyStore_.size(); i ++)
     {
-        rb->addImpulse(gravity_ * rb->mass() * dt);
-        rb->physicsUpdate(dt);
+        if(bodyStore_.flags[i] & BodyStore::SLEEPING)
+            continue;
+
+        auto &rb = bodyStore_.bodies[i];
+        Vector3f motion = bodyStore_.positions[i] - rb->position();
+        if(rb->continuous())
+            moveContinuous(rb, motion);
+        else if(!(motion == Vector3f::zero))
+            rb->transformWorld(getTranslateMatrix(motion));
     }
 
 
     /* Update the boxes for all the colliders. */
     for(auto &collider : colliders)
-        collider->calcBox();
-    pruner.update();
+    {
+        if(collider->calcBox() && collider->isStatic())
+            pruner_->staticColliderMoved(collider);
+    }
+    pruner_->update();
     
     vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> overlappingNodes;
-    pruner.listOverlappingNodes(overlappingNodes);
-
-    /* Mark all collisions as unvisited. */
+    pruner_->listOverlappingNodes(overlappingNodes);
+
+    /*
+     * If the pruner keeps track of its pairs between updates, find the pairs
+     * that are new this frame. A pair that is not new and whose colliders have
+     * not moved since it was last checked has the same result as last time.
+     */
+    vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> addedPairs;
+    vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> removedPairs;
+    unordered_set<Collision> newPairs;
+    bool tracksPairs = pruner_->listPairChanges(addedPairs, removedPairs);
+    for(auto &addedPair : addedPairs)
+        newPairs.emplace(addedPair.first, addedPair.second, Vector3f::zero);
+
+    /*
+     * Bodies pushed apart last frame were moved after their colliders were
+     * checked, even though they have not moved this frame.
+     */
+    swap(resolvedBodies_, lastResolvedBodies_);
+    resolvedBodies_.clear();
+    frameCollisions_.clear();
+
+    /* Mark all collisions and cached axes as unvisited. */
     for(auto it = begin(collisions);
             it != end(collisions);
             ++ it)
     {
         it->visited_ = false;
     }
+    for(auto &axis : separatingAxes_)
+        axis.first.visited_ = false;
+
+    /*
+     * Check the pairs for overlap in groups, which may run in parallel since
+     * the checks only read the scene. Updating the boxes above also brought
+     * the world matrices of the colliders up to date, so reading them does
+     * not write to them.
+     */
+    size_t groupCount =
+        (overlappingNodes.size() + PAIR_GROUP_SIZE - 1) / PAIR_GROUP_SIZE;
+    if(pairResults_.size() < groupCount)
+        pairResults_.resize(groupCount);
+
+    auto checkGroup = [&](size_t group)
+    {
+        vector<PairResult> &results = pairResults_[group];
+        results.clear();
 
-    /* Find overlapping colliders. */
-    for(auto &overlappingPair : overlappingNodes)
+        size_t first = group * PAIR_GROUP_SIZE;
+        size_t last = min(first + PAIR_GROUP_SIZE, overlappingNodes.size());
+        PairResult result;
+        for(size_t i = first; i < last; i ++)
+        {
+            auto &[a, b] = overlappingNodes[i];
+            if(checkPair(result, a, b, tracksPairs, newPairs))
+                results.push_back(move(result));
+        }
+    };
+
+    if(threadPool_)
+        threadPool_->parallelFor(groupCount, checkGroup);
+    else
     {
-        auto &a = overlappingPair.first;
-        auto &b = overlappingPair.second;
+        for(size_t group = 0; group < groupCount; group ++)
+            checkGroup(group);
+    }
 
-        /* We only need to check if either collider is active. */
-        if(a->isActive() && b->isActive())
+    /* Handle the collisions in the order the pruner listed the pairs. */
+    for(size_t group = 0; group < groupCount; group ++)
+    {
+        for(auto &result : pairResults_[group])
         {
-            auto as = a->findAncestorByType<Rigidbody>();
-            auto bs = b->findAncestorByType<Rigidbody>();
+            /* Keep the axis for as long as the pruner lists the pair. */
+            Collision pair(result.a, result.b, Vector3f::zero);
+            auto axis =
+                separatingAxes_.try_emplace(pair, Vector3f::right).first;
+            axis->first.visited_ = true;
 
-            if(as || bs)
+            if(result.checked)
             {
-                Vector3f initialAxis = Vector3f::right;
-                /* If there is overlap, handle the collision. */
-                if(a->getOverlap(overlap, initialAxis, b))
-                {
-                    handleCollision(a, b, overlap);
-                }
+                bool flipped = axis->first.colliders()[0] != result.a;
+                axis->second = flipped ? -result.axis : result.axis;
+            }
+
+            /*
+             * A checked overlap may come from a collider moved into a
+             * sleeping body, which has to wake up to respond to it.
+             */
+            if(result.overlapping)
+            {
+                if(result.checked)
+                    wakeBodies(result.a, result.b);
+                handleCollision(result.a, result.b, result.overlap);
             }
         }
+        pairResults_[group].clear();
     }
 
     /* Find unvisited collision objects. */
@@ -200,11 +443,16 @@ void Scene::update(float dt)
             it != end(collisions);
             /* pass */)
     {
-        /* The objects are not colliding anymore, call collisionExited. */
+        /*
+         * The objects are not colliding anymore, call collisionExited. A
+         * sleeping body loses its support, for example when the collider it
+         * rests on is moved or removed, so it wakes up.
+         */
         if(!it->visited_)
         {
             auto a = it->colliders()[0];
             auto b = it->colliders()[1];
+            wakeBodies(a, b);
 
             a->notifyCollisionObservers(
                     *it,
@@ -218,9 +466,113 @@ void Scene::update(float dt)
         else
             ++ it;
     }
+
+    solver_.solve(frameCollisions_, dt, resolvedBodies_);
+    updateIslands();
+
+    /* Forget the axes of pairs that are no longer near each other. */
+    for(auto it = begin(separatingAxes_);
+            it != end(separatingAxes_);
+            /* pass */)
+    {
+        if(!it->first.visited_)
+            it = separatingAxes_.erase(it);
+        else
+            ++ it;
+    }
+
+    /*
+     * Forget which nodes moved only now, so that nodes moved between updates
+     * are still seen as moved by the next update.
+     */
+    for(const auto node : nodes)
+        node->newFrame();
 }
 
-void Scene::render()
+void Scene::updateIslands()
+{
+    if(sleepFrames_ <= 0)
+        return;
+
+    /* Each rigid body starts in its own island, named by its index. */
+    const auto &bodies = bodyStore_.bodies;
+    islandParents_.resize(bodies.size());
+    for(size_t i = 0; i < bodies.size(); i ++)
+    {
+        islandParents_[i] = i;
+
+        /* Count how long each awake body has been moving slowly. */
+        if(!(bodyStore_.flags[i] & BodyStore::SLEEPING))
+        {
+            const Vector3f &velocity = bodyStore_.velocities[i];
+            if(velocity.dot(velocity) < sleepVelocity_ * sleepVelocity_)
+                bodies[i]->restingFrames_ ++;
+            else
+                bodies[i]->restingFrames_ = 0;
+        }
+    }
+
+    auto findRoot = [&](size_t i)
+    {
+        while(islandParents_[i] != i)
+        {
+            islandParents_[i] = islandParents_[islandParents_[i]];
+            i = islandParents_[i];
+        }
+        return i;
+    };
+
+    /* Join the bodies touching each other into islands. */
+    for(auto &collision : collisions)
+    {
+        const auto &colliders = collision.colliders();
+        if(colliders[0]->isTrigger() || colliders[1]->isTrigger())
+            continue;
+
+        auto as = colliders[0]->findAncestorByType<Rigidbody>();
+        auto bs = colliders[1]->findAncestorByType<Rigidbody>();
+        if(!as || !bs || as == bs || !as->isActive() || !bs->isActive())
+            continue;
+        if(as->store_ != &bodyStore_ || bs->store_ != &bodyStore_)
+            continue;
+
+        islandParents_[findRoot(as->index_)] = findRoot(bs->index_);
+    }
+
+    /*
+     * An island with any body awake wakes up, so that a body landing on a
+     * sleeping pile wakes the whole pile. An island sleeps once every body
+     * in it has been resting long enough.
+     */
+    islandResting_.assign(bodies.size(), true);
+    islandAwake_.assign(bodies.size(), false);
+    for(size_t i = 0; i < bodies.size(); i ++)
+    {
+        auto &rb = bodies[i];
+        size_t root = findRoot(i);
+        if(!rb->sleeping())
+        {
+            islandAwake_[root] = true;
+            if(rb->restingFrames_ < sleepFrames_)
+                islandResting_[root] = false;
+        }
+    }
+
+    for(size_t i = 0; i < bodies.size(); i ++)
+    {
+        auto &rb = bodies[i];
+        size_t root = findRoot(i);
+        if(!islandAwake_[root])
+            continue;
+
+        if(islandResting_[root])
+            rb->sleep();
+        else
+            rb->wake();
+    }
+}
+
+void Scene::render(float alpha)
 {
     double startTime = glfwGetTime();
     bool hasCamera = false;
@@ -231,7 +583,7 @@ void Scene::render()
     {
         if((*it)->isActive())
         {
-            renderer.render(*it);
+            renderer.render(*it, alpha);
             hasCamera = true;
         }
     }
@@ -245,13 +597,16 @@ void Scene::render()
 void Scene::registerNode(shared_ptr<Collider> collider)
 {
     colliders.push_front(collider);
-    pruner.add(collider);
+
+    /* The pruner needs the box of colliders added after the first update. */
+    collider->calcBox();
+    pruner_->add(collider);
 }
 
 void Scene::unregisterNode(shared_ptr<Collider> collider)
 {
     colliders.remove(collider);
-    pruner.remove(collider);
+    pruner_->remove(collider);
 }
 
 void Scene::registerNode(shared_ptr<Camera> camera)
@@ -288,11 +643,47 @@ void Scene::unregisterNode(shared_ptr<LightNode> lightNode)
 
 void Scene::registerNode(shared_ptr<Rigidbody> rigidbody)
 {
-    rigidbodies.push_back(rigidbody);
+    bodyStore_.add(rigidbody);
 }
 
 void Scene::unregisterNode(shared_ptr<Rigidbody> rigidbody)
 {
-    rigidbodies.remove(rigidbody);
+    bodyStore_.remove(rigidbody);
+}
+
+Vector3f &Scene::gravity()
+{
+    return gravity_;
+}
+
+shared_ptr<ThreadPool> &Scene::threadPool()
+{
+    return threadPool_;
 }
 
+float &Scene::sleepVelocity()
+{
+    return sleepVelocity_;
+}
+
+int &Scene::sleepFrames()
+{
+    return sleepFrames_;
+}
+
+ContactSolver &Scene::solver()
+{
+    return solver_;
+}
+
+const shared_ptr<CollisionPruner> &Scene::pruner() const
+{
+    return pruner_;
+}
+
+void Scene::setPruner(shared_ptr<CollisionPruner> pruner)
+{
+    for(auto &collider : colliders)
+        pruner->add(collider);
+    pruner_ = pruner;
+}
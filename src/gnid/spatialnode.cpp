@@ -39,7 +39,13 @@ const Matrix4f &SpatialNode::worldMatrix() const
 
     if(moved() || p->moved())
     {
-        worldMatrix_ = p->worldMatrix() * localMatrix();
+        /*
+         * Only store the matrix if it changed, so that once it is up to date
+         * it can be read from several threads at once.
+         */
+        Matrix4f matrix = p->worldMatrix() * localMatrix();
+        if(!(matrix == worldMatrix_))
+            worldMatrix_ = matrix;
         return worldMatrix_;
     }
 
@@ -0,0 +1,44 @@
+#include "gnid/stepaccumulator.hpp"
+
+#include <cmath>
+
+using namespace std;
+using namespace gnid;
+
+float &StepAccumulator::step()
+{
+    return step_;
+}
+
+int &StepAccumulator::maxSubsteps()
+{
+    return maxSubsteps_;
+}
+
+int StepAccumulator::advance(float dt)
+{
+    if(step_ <= 0)
+        return 1;
+
+    accumulator_ += dt;
+
+    int steps = 0;
+    while(accumulator_ >= step_ && steps < maxSubsteps_)
+    {
+        accumulator_ -= step_;
+        steps ++;
+    }
+
+    /* Drop the time that could not be caught up on. */
+    if(accumulator_ >= step_)
+        accumulator_ = fmod(accumulator_, step_);
+
+    return steps;
+}
+
+float StepAccumulator::alpha() const
+{
+    if(step_ <= 0)
+        return 1;
+    return accumulator_ / step_;
+}
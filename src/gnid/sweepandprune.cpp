@@ -0,0 +1,399 @@
+#include "gnid/sweepandprune.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#include "gnid/collider.hpp"
+
+using namespace std;
+using namespace gnid;
+
+SweepAndPrunePruner::SweepAndPrunePruner()
+{
+}
+
+uint64_t SweepAndPrunePruner::pairKey(uint32_t a, uint32_t b)
+{
+    if(a > b)
+        swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+void SweepAndPrunePruner::addPair(uint32_t a, uint32_t b)
+{
+    uint64_t key = pairKey(a, b);
+    if(pairs_.insert(key).second)
+        changes_.emplace(key, false);
+}
+
+void SweepAndPrunePruner::removePair(uint32_t a, uint32_t b)
+{
+    uint64_t key = pairKey(a, b);
+    if(pairs_.erase(key))
+        changes_.emplace(key, true);
+}
+
+bool SweepAndPrunePruner::overlaps(uint32_t a, uint32_t b) const
+{
+    const Proxy &first = proxies_[a];
+    const Proxy &second = proxies_[b];
+
+    /* Static colliders never need to be checked against each other. */
+    if(first.isStatic && second.isStatic)
+        return false;
+
+    for(int i = 0; i < 3; i ++)
+    {
+        if(first.max[i] < second.min[i] || first.min[i] > second.max[i])
+            return false;
+    }
+    return true;
+}
+
+void SweepAndPrunePruner::add(shared_ptr<Collider> collider)
+{
+    assert(proxyIndices_.find(collider.get()) == end(proxyIndices_));
+
+    uint32_t index;
+    if(freeProxies_.empty())
+    {
+        index = proxies_.size();
+        proxies_.emplace_back();
+    }
+    else
+    {
+        index = freeProxies_.back();
+        freeProxies_.pop_back();
+    }
+
+    Proxy &proxy = proxies_[index];
+    proxy.collider = collider;
+    proxy.isStatic = collider->isStatic();
+    proxy.inUse = true;
+    proxyIndices_[collider.get()] = index;
+
+    /*
+     * The endpoints are merged into the lists by the next update, which will
+     * also find the new pairs.
+     */
+    proxy.pending = true;
+    pendingProxies_.push_back(index);
+}
+
+void SweepAndPrunePruner::remove(shared_ptr<Collider> collider)
+{
+    auto it = proxyIndices_.find(collider.get());
+    if(it != end(proxyIndices_))
+        removeProxy(it->second);
+}
+
+void SweepAndPrunePruner::removeProxy(uint32_t index)
+{
+    Proxy &proxy = proxies_[index];
+    proxy.inUse = false;
+    proxyIndices_.erase(proxy.collider.get());
+
+    /*
+     * Keep the collider until the next update so that the removed pairs can
+     * be reported. The index is not reused until then either, so a new
+     * collider can't be mistaken for the old one.
+     */
+    removedProxies_.push_back(index);
+}
+
+void SweepAndPrunePruner::flushRemoved()
+{
+    /* Pending proxies have neither endpoints nor pairs yet. */
+    bool listed = false;
+    for(auto index : removedProxies_)
+    {
+        if(!proxies_[index].pending)
+            listed = true;
+    }
+    if(!listed)
+        return;
+
+    for(int i = 0; i < 3; i ++)
+    {
+        endpoints_[i].erase(
+                remove_if(
+                    begin(endpoints_[i]),
+                    end(endpoints_[i]),
+                    [this](const Endpoint &endpoint)
+                    {
+                        return !proxies_[endpoint.proxy()].inUse;
+                    }),
+                end(endpoints_[i]));
+    }
+
+    for(auto it = begin(pairs_); it != end(pairs_); /* pass */)
+    {
+        if(!proxies_[*it >> 32].inUse || !proxies_[*it & 0xFFFFFFFF].inUse)
+        {
+            changes_.emplace(*it, true);
+            it = pairs_.erase(it);
+        }
+        else
+            ++ it;
+    }
+}
+
+void SweepAndPrunePruner::flushPending()
+{
+    if(pendingProxies_.empty())
+        return;
+
+    /* Sort the new endpoints and merge them with the sorted lists. */
+    for(int i = 0; i < 3; i ++)
+    {
+        newEndpoints_.clear();
+        for(auto index : pendingProxies_)
+        {
+            const Proxy &proxy = proxies_[index];
+            if(!proxy.inUse)
+                continue;
+            newEndpoints_.push_back({ proxy.min[i], index << 1 });
+            newEndpoints_.push_back({ proxy.max[i], (index << 1) | 1 });
+        }
+        sort(begin(newEndpoints_), end(newEndpoints_));
+
+        mergedEndpoints_.clear();
+        mergedEndpoints_.reserve(endpoints_[i].size() + newEndpoints_.size());
+        merge(
+                begin(endpoints_[i]), end(endpoints_[i]),
+                begin(newEndpoints_), end(newEndpoints_),
+                back_inserter(mergedEndpoints_));
+        swap(endpoints_[i], mergedEndpoints_);
+    }
+
+    /*
+     * Sweep along the first axis, keeping the boxes that are open. Each new
+     * box is checked against every open box, and each old box only against
+     * the open new boxes, since the pairs between old boxes are known.
+     */
+    activeOld_.clear();
+    activeNew_.clear();
+    activePositions_.resize(proxies_.size());
+    for(auto &endpoint : endpoints_[0])
+    {
+        uint32_t index = endpoint.proxy();
+        bool isNew = proxies_[index].pending;
+        auto &active = isNew ? activeNew_ : activeOld_;
+
+        if(endpoint.isMax())
+        {
+            uint32_t position = activePositions_[index];
+            active[position] = active.back();
+            activePositions_[active[position]] = position;
+            active.pop_back();
+            continue;
+        }
+
+        for(auto other : activeNew_)
+        {
+            if(overlaps(index, other))
+                addPair(index, other);
+        }
+        if(isNew)
+        {
+            for(auto other : activeOld_)
+            {
+                if(overlaps(index, other))
+                    addPair(index, other);
+            }
+        }
+
+        activePositions_[index] = active.size();
+        active.push_back(index);
+    }
+
+    for(auto index : pendingProxies_)
+        proxies_[index].pending = false;
+    pendingProxies_.clear();
+}
+
+void SweepAndPrunePruner::sortAxis(int axis)
+{
+    auto &endpoints = endpoints_[axis];
+
+    for(size_t i = 1; i < endpoints.size(); i ++)
+    {
+        const Endpoint endpoint = endpoints[i];
+        size_t j = i;
+
+        while(j > 0 && endpoint < endpoints[j - 1])
+        {
+            const Endpoint &other = endpoints[j - 1];
+
+            /* A start moving past an end means the boxes might now overlap. */
+            if(!endpoint.isMax() && other.isMax())
+            {
+                if(overlaps(endpoint.proxy(), other.proxy()))
+                    addPair(endpoint.proxy(), other.proxy());
+            }
+            /* An end moving past a start means the boxes no longer overlap. */
+            else if(endpoint.isMax() && !other.isMax())
+            {
+                removePair(endpoint.proxy(), other.proxy());
+            }
+
+            endpoints[j] = other;
+            j --;
+        }
+
+        endpoints[j] = endpoint;
+    }
+}
+
+void SweepAndPrunePruner::update()
+{
+    /* Re-add colliders that became static or stopped being static. */
+    const size_t proxyCount = proxies_.size();
+    for(size_t i = 0; i < proxyCount; i ++)
+    {
+        Proxy &proxy = proxies_[i];
+        if(proxy.inUse && proxy.collider->isStatic() != proxy.isStatic)
+        {
+            auto collider = proxy.collider;
+            removeProxy(i);
+            add(collider);
+        }
+    }
+
+    flushRemoved();
+
+    /* Copy the new bounding boxes. */
+    for(auto &proxy : proxies_)
+    {
+        if(!proxy.inUse)
+            continue;
+
+        const Box &box = proxy.collider->box();
+        for(int i = 0; i < 3; i ++)
+        {
+            proxy.min[i] = box.min()[i];
+            proxy.max[i] = box.max()[i];
+        }
+    }
+
+    /* Update the endpoints and sort them. */
+    for(int i = 0; i < 3; i ++)
+    {
+        for(auto &endpoint : endpoints_[i])
+        {
+            const Proxy &proxy = proxies_[endpoint.proxy()];
+            endpoint.value = endpoint.isMax() ? proxy.max[i] : proxy.min[i];
+        }
+        sortAxis(i);
+    }
+
+    flushPending();
+
+    /* Find the pairs that actually changed since the last update. */
+    added_.clear();
+    removed_.clear();
+    for(auto &[key, existed] : changes_)
+    {
+        bool exists = pairs_.find(key) != end(pairs_);
+        if(exists == existed)
+            continue;
+
+        const auto &a = proxies_[key >> 32].collider;
+        const auto &b = proxies_[key & 0xFFFFFFFF].collider;
+        if(exists)
+            added_.emplace_back(a, b);
+        else
+            removed_.emplace_back(a, b);
+    }
+    changes_.clear();
+
+    /*
+     * A collider removed and added back between updates has a new proxy, so
+     * its pairs were removed and added again even though they did not change.
+     */
+    if(!removedProxies_.empty() && !added_.empty() && !removed_.empty())
+        cancelReadded();
+
+    /* The removed proxies can now be reused. */
+    for(auto index : removedProxies_)
+    {
+        proxies_[index].collider = nullptr;
+        proxies_[index].pending = false;
+        freeProxies_.push_back(index);
+    }
+    removedProxies_.clear();
+}
+
+void SweepAndPrunePruner::cancelReadded()
+{
+    typedef pair<shared_ptr<Collider>, shared_ptr<Collider>> ColliderPair;
+    auto ordered = [](const ColliderPair &p)
+    {
+        return p.first < p.second
+            ? make_pair(p.first.get(), p.second.get())
+            : make_pair(p.second.get(), p.first.get());
+    };
+    auto before = [&](const ColliderPair &a, const ColliderPair &b)
+    {
+        return ordered(a) < ordered(b);
+    };
+
+    sort(begin(added_), end(added_), before);
+    sort(begin(removed_), end(removed_), before);
+
+    /* Drop the pairs found in both lists, which are now sorted the same. */
+    size_t addedCount = 0, removedCount = 0;
+    size_t i = 0, j = 0;
+    while(i < added_.size() || j < removed_.size())
+    {
+        if(j == removed_.size()
+                || (i < added_.size() && before(added_[i], removed_[j])))
+        {
+            added_[addedCount ++] = added_[i ++];
+        }
+        else if(i == added_.size() || before(removed_[j], added_[i]))
+            removed_[removedCount ++] = removed_[j ++];
+        else
+        {
+            i ++;
+            j ++;
+        }
+    }
+    added_.resize(addedCount);
+    removed_.resize(removedCount);
+}
+
+void SweepAndPrunePruner::listOverlappingNodes(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &list) const
+{
+    for(auto key : pairs_)
+    {
+        /* Pairs of removed colliders are only taken out by update(). */
+        if(!proxies_[key >> 32].inUse || !proxies_[key & 0xFFFFFFFF].inUse)
+            continue;
+
+        list.emplace_back(
+                proxies_[key >> 32].collider,
+                proxies_[key & 0xFFFFFFFF].collider);
+    }
+}
+
+void SweepAndPrunePruner::listAllNodes(
+        vector<shared_ptr<Collider>> &list) const
+{
+    for(auto &proxy : proxies_)
+    {
+        if(proxy.inUse)
+            list.push_back(proxy.collider);
+    }
+}
+
+bool SweepAndPrunePruner::listPairChanges(
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &added,
+        vector<pair<shared_ptr<Collider>, shared_ptr<Collider>>> &removed) const
+{
+    added.insert(end(added), begin(added_), end(added_));
+    removed.insert(end(removed), begin(removed_), end(removed_));
+    return true;
+}
@@ -0,0 +1,99 @@
+#include "gnid/threadpool.hpp"
+
+#include <cassert>
+
+using namespace std;
+using namespace gnid;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : function_(nullptr),
+      count_(0),
+      next_(0),
+      generation_(0),
+      busyWorkers_(0),
+      stopping_(false)
+{
+    /* hardware_concurrency() may return zero if it is not known. */
+    for(unsigned int i = 1; i < threadCount; i ++)
+        workers_.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    started_.notify_all();
+
+    for(auto &worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t)> &function)
+{
+    if(count == 0)
+        return;
+
+    lock_guard<mutex> loopLock(loopMutex_);
+
+    /* Run small loops and loops without workers on this thread. */
+    if(count == 1 || workers_.empty())
+    {
+        for(size_t i = 0; i < count; i ++)
+            function(i);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        function_ = &function;
+        count_ = count;
+        next_ = 0;
+        busyWorkers_ = workers_.size();
+        generation_ ++;
+    }
+    started_.notify_all();
+
+    work();
+
+    /* Wait for the workers, since they may still be running iterations. */
+    unique_lock<mutex> lock(mutex_);
+    finished_.wait(lock, [this]() { return busyWorkers_ == 0; });
+    function_ = nullptr;
+}
+
+void ThreadPool::work()
+{
+    for(size_t i = next_ ++; i < count_; i = next_ ++)
+        (*function_)(i);
+}
+
+void ThreadPool::run()
+{
+    uint64_t generation = 0;
+
+    while(true)
+    {
+        {
+            unique_lock<mutex> lock(mutex_);
+            started_.wait(lock, [this, generation]()
+            {
+                return stopping_ || generation_ != generation;
+            });
+
+            if(stopping_)
+                return;
+            generation = generation_;
+        }
+
+        work();
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            assert(busyWorkers_ > 0);
+            busyWorkers_ --;
+        }
+        finished_.notify_one();
+    }
+}
@@ -0,0 +1,285 @@
+#include "gnid/trianglemesh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "gnid/matrix/matrix.hpp"
+
+using namespace gnid;
+using namespace std;
+using namespace tmat;
+
+/* Deeper than any tree built by splitting 2^32 triangles in half. */
+static const int MAX_DEPTH = 64;
+
+TriangleMesh::TriangleMesh(
+        const vector<Vector3f> &vertices,
+        const vector<uint32_t> &indices,
+        unsigned int maxTrianglesPerLeaf)
+    : maxTrianglesPerLeaf_(maxTrianglesPerLeaf),
+      vertices_(vertices)
+{
+    assert(indices.size() % 3 == 0);
+    assert(maxTrianglesPerLeaf_ > 0);
+
+    vector<Vector3f> centers;
+    for(size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        array<uint32_t, 3> t = { indices[i], indices[i + 1], indices[i + 2] };
+        const Vector3f &a = vertices_[t[0]];
+        if((vertices_[t[1]] - a).cross(vertices_[t[2]] - a) == Vector3f::zero)
+            continue;
+
+        Box box;
+        for(uint32_t vertex : t)
+            box.add(vertices_[vertex]);
+        triangles_.push_back(t);
+        centers.push_back(box.center());
+    }
+
+    if(triangles_.empty())
+        return;
+
+    vector<uint32_t> order(triangles_.size());
+    for(uint32_t i = 0; i < order.size(); i ++)
+        order[i] = i;
+    build(0, order.size(), order, centers);
+
+    /* Put the triangles in the order the leaves refer to them. */
+    vector<array<uint32_t, 3>> sorted;
+    sorted.reserve(triangles_.size());
+    for(uint32_t i : order)
+        sorted.push_back(triangles_[i]);
+    triangles_.swap(sorted);
+}
+
+void TriangleMesh::build(
+        uint32_t first,
+        uint32_t count,
+        vector<uint32_t> &order,
+        const vector<Vector3f> &centers)
+{
+    const uint32_t index = nodes_.size();
+    nodes_.emplace_back();
+
+    Box box;
+    Box centerBox;
+    for(uint32_t i = first; i < first + count; i ++)
+    {
+        for(uint32_t vertex : triangles_[order[i]])
+            box.add(vertices_[vertex]);
+        centerBox.add(centers[order[i]]);
+    }
+    for(int j = 0; j < 3; j ++)
+    {
+        nodes_[index].min[j] = box.min()[j];
+        nodes_[index].max[j] = box.max()[j];
+    }
+
+    /* Stop if there are few enough triangles for a leaf. */
+    if(count <= maxTrianglesPerLeaf_)
+    {
+        nodes_[index].first = first;
+        nodes_[index].count = count;
+        return;
+    }
+
+    /*
+     * Split in half along the longest axis of the centers. This keeps the
+     * tree balanced, which is all static geometry needs.
+     */
+    Vector3f size = centerBox.size();
+    int axis = 0;
+    if(size[1] > size[axis])
+        axis = 1;
+    if(size[2] > size[axis])
+        axis = 2;
+
+    uint32_t leftCount = count / 2;
+    nth_element(
+            order.begin() + first,
+            order.begin() + first + leftCount,
+            order.begin() + first + count,
+            [&centers, axis](uint32_t a, uint32_t b)
+            {
+                return centers[a][axis] < centers[b][axis];
+            });
+
+    nodes_[index].count = 0;
+    build(first, leftCount, order, centers);
+    nodes_[index].right = nodes_.size();
+    build(first + leftCount, count - leftCount, order, centers);
+}
+
+Vector3f TriangleMesh::support(const Vector3f &d) const
+{
+    float currentMax = -numeric_limits<float>::infinity();
+    Vector3f currentPoint = Vector3f::zero;
+
+    for(auto &vertex : vertices_)
+    {
+        float dot = d.dot(vertex);
+        if(dot >= currentMax)
+        {
+            currentMax = dot;
+            currentPoint = vertex;
+        }
+    }
+
+    return currentPoint;
+}
+
+void TriangleMesh::listOverlappingTriangles(
+        const Box &box,
+        vector<uint32_t> &list) const
+{
+    if(nodes_.empty())
+        return;
+
+    uint32_t stack[MAX_DEPTH];
+    int size = 0;
+    stack[size ++] = 0;
+
+    while(size > 0)
+    {
+        uint32_t index = stack[-- size];
+        const Node &node = nodes_[index];
+
+        bool overlaps = true;
+        for(int i = 0; i < 3; i ++)
+        {
+            if(node.max[i] < box.min()[i] || node.min[i] > box.max()[i])
+                overlaps = false;
+        }
+        if(!overlaps)
+            continue;
+
+        if(node.isLeaf())
+        {
+            for(uint32_t i = node.first; i < node.first + node.count; i ++)
+            {
+                Box bounds;
+                for(uint32_t vertex : triangles_[i])
+                    bounds.add(vertices_[vertex]);
+                if(bounds.overlaps(box))
+                    list.push_back(i);
+            }
+        }
+        else
+        {
+            assert(size + 2 <= MAX_DEPTH);
+            stack[size ++] = node.right;
+            stack[size ++] = index + 1;
+        }
+    }
+}
+
+/**
+ * \brief Returns true if the ray hits the bounds within maxDistance
+ *
+ * \details
+ *     This is the same test as Box::raycast(), on the bounds of a node.
+ */
+static bool rayHitsBounds(
+        const float *min,
+        const float *max,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance)
+{
+    float enter = 0;
+    float exit = maxDistance;
+    for(int i = 0; i < 3; i ++)
+    {
+        if(direction[i] == 0)
+        {
+            if(origin[i] < min[i] || origin[i] > max[i])
+                return false;
+            continue;
+        }
+
+        float near = (min[i] - origin[i]) / direction[i];
+        float far = (max[i] - origin[i]) / direction[i];
+        if(near > far)
+            swap(near, far);
+
+        if(near > enter)
+            enter = near;
+        if(far < exit)
+            exit = far;
+        if(enter > exit)
+            return false;
+    }
+    return true;
+}
+
+bool TriangleMesh::raycast(
+        float &distance,
+        uint32_t &triangle,
+        const Vector3f &origin,
+        const Vector3f &direction,
+        float maxDistance) const
+{
+    if(nodes_.empty())
+        return false;
+
+    float nearest = maxDistance;
+    bool hit = false;
+
+    uint32_t stack[MAX_DEPTH];
+    int size = 0;
+    stack[size ++] = 0;
+
+    while(size > 0)
+    {
+        uint32_t index = stack[-- size];
+        const Node &node = nodes_[index];
+        if(!rayHitsBounds(node.min, node.max, origin, direction, nearest))
+            continue;
+
+        if(!node.isLeaf())
+        {
+            assert(size + 2 <= MAX_DEPTH);
+            stack[size ++] = node.right;
+            stack[size ++] = index + 1;
+            continue;
+        }
+
+        /* Moller and Trumbore's ray triangle test. */
+        for(uint32_t i = node.first; i < node.first + node.count; i ++)
+        {
+            const Vector3f &a = vertices_[triangles_[i][0]];
+            Vector3f ab = vertices_[triangles_[i][1]] - a;
+            Vector3f ac = vertices_[triangles_[i][2]] - a;
+
+            Vector3f p = direction.cross(ac);
+            float determinant = ab.dot(p);
+            if(determinant == 0)
+                continue;
+
+            Vector3f offset = origin - a;
+            float u = offset.dot(p) / determinant;
+            if(u < 0 || u > 1)
+                continue;
+
+            Vector3f q = offset.cross(ab);
+            float v = direction.dot(q) / determinant;
+            if(v < 0 || u + v > 1)
+                continue;
+
+            float t = ac.dot(q) / determinant;
+            if(t >= 0 && t <= nearest)
+            {
+                nearest = t;
+                triangle = i;
+                hit = true;
+            }
+        }
+    }
+
+    if(hit)
+        distance = nearest;
+    return hit;
+}
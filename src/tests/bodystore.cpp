@@ -0,0 +1,128 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "gnid/bodystore.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/scene.hpp"
+#include "gnid/threadpool.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+int main(int argc, char *argv[])
+{
+    /* Rigid bodies keep their state when they are added and removed. */
+    {
+        BodyStore store;
+        auto a = make_shared<Rigidbody>(2.0f);
+        auto b = make_shared<Rigidbody>();
+        auto c = make_shared<Rigidbody>();
+        a->addImpulse(Vector3f { 2, 0, 0 });
+        c->addImpulse(Vector3f { 0, 0, 3 });
+
+        store.add(a);
+        store.add(b);
+        store.add(c);
+        assert(store.size() == 3);
+        assert(store.velocities[0] == (Vector3f { 1, 0, 0 }));
+        assert(store.inverseMasses[0] == 0.5f);
+        assert(a->velocity() == (Vector3f { 1, 0, 0 }));
+
+        /* Impulses change the velocities in the store. */
+        b->addImpulse(Vector3f { 0, 1, 0 });
+        assert(store.velocities[1] == (Vector3f { 0, 1, 0 }));
+
+        b->setMass(4.0f);
+        assert(store.inverseMasses[1] == 0.25f);
+
+        /* The last body takes the place of the removed one. */
+        store.remove(a);
+        assert(store.size() == 2);
+        assert(store.bodies[0] == c);
+        assert(c->velocity() == (Vector3f { 0, 0, 3 }));
+        assert(a->velocity() == (Vector3f { 1, 0, 0 }));
+
+        a->addImpulse(Vector3f { 2, 0, 0 });
+        assert(a->velocity() == (Vector3f { 2, 0, 0 }));
+    }
+
+    /* The integrated positions do not depend on the number of threads. */
+    {
+        const size_t count = 10000;
+        const Vector3f gravity { 0, -9.8f, 0 };
+        BodyStore serial;
+        BodyStore parallel;
+        vector<shared_ptr<Rigidbody>> bodies;
+
+        /* Spatial nodes need a parent to have a world matrix. */
+        auto root = make_shared<EmptyNode>();
+        for(size_t i = 0; i < count; i ++)
+        {
+            auto body = make_shared<Rigidbody>();
+            body->transformWorld(getTranslateMatrix(
+                        Vector3f { static_cast<float>(i), 0, 0 }));
+            body->addImpulse(Vector3f { 0, static_cast<float>(i % 7), 1 });
+            bodies.push_back(body);
+            serial.add(body);
+        }
+        for(auto &body : bodies)
+        {
+            auto clone = body->clone()->as<Rigidbody>();
+            root->add(body);
+            root->add(clone);
+            parallel.add(clone);
+        }
+        parallel.flags[5] = BodyStore::SLEEPING;
+
+        ThreadPool pool(4);
+        serial.readPositions();
+        parallel.readPositions();
+        serial.integrate(0.1f, gravity, nullptr);
+        parallel.integrate(0.1f, gravity, &pool);
+        for(size_t i = 0; i < count; i ++)
+        {
+            if(i == 5)
+                continue;
+            assert(serial.positions[i] == parallel.positions[i]);
+            assert(serial.velocities[i] == parallel.velocities[i]);
+        }
+
+        /* Sleeping bodies are not integrated. */
+        assert(parallel.positions[5] == (Vector3f::zero));
+        assert(parallel.velocities[5] == (Vector3f { 0, 5, 1 }));
+        assert(fabs(serial.velocities[5][1] - 4.02f) < 0.0001f);
+    }
+
+    /* A scene writes the integrated positions back to the nodes. */
+    {
+        auto scene = make_shared<Scene>();
+        scene->init();
+        auto body = make_shared<Rigidbody>();
+        body->addImpulse(Vector3f { 1, 0, 0 });
+        scene->root->add(body);
+
+        scene->update(0.5f);
+        Vector3f position = body->position();
+        assert(position[0] == 0.5f && position[1] == 0);
+        assert(body->velocity() == (Vector3f { 1, -4.9f, 0 }));
+
+        /* Bodies without a mass do not fall. */
+        auto massless = make_shared<Rigidbody>(0.0f);
+        scene->root->add(massless);
+        scene->update(0.5f);
+        assert(massless->velocity() == Vector3f::zero);
+        assert(massless->position() == Vector3f::zero);
+
+        /* Removing the body from the scene keeps its velocity. */
+        Vector3f velocity = body->velocity();
+        scene->root->remove(body);
+        assert(body->velocity() == velocity);
+    }
+
+    cout << "ok" << endl;
+    return 0;
+}
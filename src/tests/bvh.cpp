@@ -0,0 +1,50 @@
+#include <cassert>
+#include <iostream>
+
+#include "gnid/bvh.hpp"
+#include "gnid/emptynode.hpp"
+#include "prunertest.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+    auto bvh = make_shared<Bvh>(4);
+    BvhPruner pruner(bvh);
+
+    ColliderList colliders;
+    vector<shared_ptr<SpatialNode>> parents;
+    addRandomSpheres(root, colliders, parents, 400, 20);
+    for(auto &collider : colliders)
+        pruner.add(collider);
+
+    /* The tree should match a brute force search. */
+    checkPairs(pruner, colliders);
+    assert(bvh->depth() > 1);
+
+    /* Move the nodes around a few times. */
+    for(int frame = 0; frame < 10; frame ++)
+    {
+        moveRandomly(parents);
+        checkPairs(pruner, colliders);
+    }
+
+    /* Remove some colliders. */
+    for(int i = 0; i < 100; i ++)
+    {
+        pruner.remove(colliders.back());
+        colliders.pop_back();
+    }
+    checkPairs(pruner, colliders);
+
+    /* Leaf size should be respected. */
+    auto single = make_shared<Bvh>(1);
+    BvhPruner singlePruner(single);
+    for(auto &collider : colliders)
+        singlePruner.add(collider);
+    checkPairs(singlePruner, colliders);
+    assert(single->nodeCount() == 2 * colliders.size() - 1);
+}
@@ -0,0 +1,54 @@
+#include <cassert>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/scene.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/**
+ * \brief Fire a small ball at a thin wall and return where it ends up
+ */
+static Vector3f fire(bool continuous)
+{
+    auto scene = make_shared<Scene>();
+    scene->init();
+    scene->gravity() = Vector3f::zero;
+
+    auto wall = make_shared<Box>();
+    wall->add(Vector3f { -5, -5, -0.05f });
+    wall->add(Vector3f { 5, 5, 0.05f });
+    scene->root->add(make_shared<Collider>(wall));
+
+    auto ball = make_shared<Rigidbody>();
+    ball->continuous() = continuous;
+    ball->transformWorld(getTranslateMatrix(Vector3f { 0, 0, -3 }));
+    ball->add(make_shared<Collider>(make_shared<Sphere>(0.1f)));
+    scene->root->add(ball);
+
+    /* Fast enough to move two meters each update. */
+    ball->addImpulse(Vector3f { 0, 0, 120 });
+    for(int i = 0; i < 10; i ++)
+        scene->update(1.0f / 60.0f);
+    return ball->position();
+}
+
+int main(int argc, char *argv[])
+{
+    /* Without continuous collision detection, the ball passes the wall. */
+    assert(fire(false)[2] > 1);
+
+    /* With it, the ball stops at the wall. */
+    Vector3f position = fire(true);
+    assert(position[2] < -0.14f && position[2] > -0.16f);
+
+    cout << "ok" << endl;
+    return 0;
+}
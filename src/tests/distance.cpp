@@ -0,0 +1,143 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/distanceresult.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/trianglemesh.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+static Vector3f randomVector(float min, float max)
+{
+    return Vector3f {
+        randomFloat(min, max),
+        randomFloat(min, max),
+        randomFloat(min, max) };
+}
+
+static shared_ptr<Box> makeBox(const Vector3f &min, const Vector3f &max)
+{
+    auto box = make_shared<Box>();
+    box->add(min);
+    box->add(max);
+    return box;
+}
+
+static shared_ptr<Collider> makeCollider(
+        const shared_ptr<EmptyNode> &root,
+        const shared_ptr<Shape> &shape,
+        const Vector3f &position)
+{
+    auto parent = make_shared<SpatialNode>();
+    parent->transformWorld(getTranslateMatrix(position));
+    auto collider = make_shared<Collider>(shape);
+    parent->add(collider);
+    root->add(parent);
+    return collider;
+}
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+
+    /* The gap between spheres is along the line through their centers. */
+    for(int i = 0; i < 200; i ++)
+    {
+        float radii[2] = { randomFloat(0.2f, 1), randomFloat(0.2f, 1) };
+        Vector3f centers[2] = { randomVector(-5, 5), randomVector(-5, 5) };
+        auto a = makeCollider(root, make_shared<Sphere>(radii[0]), centers[0]);
+        auto b = makeCollider(root, make_shared<Sphere>(radii[1]), centers[1]);
+
+        float gap = (centers[1] - centers[0]).magnitude() - radii[0] - radii[1];
+        DistanceResult result;
+        bool apart = a->getDistance(result, b);
+        if(gap < -0.01f)
+        {
+            assert(!apart);
+            assert(result.distance == 0);
+        }
+        if(gap > 0.01f)
+        {
+            assert(apart);
+            assert(fabs(result.distance - gap) < 0.01f);
+            assert(result.simplexSize >= 1 && result.simplexSize <= 3);
+            for(int j = 0; j < 2; j ++)
+            {
+                float fromCenter =
+                    (result.points[j] - centers[j]).magnitude();
+                assert(fabs(fromCenter - radii[j]) < 0.01f);
+            }
+            Vector3f gapVector = result.points[1] - result.points[0];
+            assert((gapVector - result.normal * result.distance)
+                    .magnitude() < 0.01f);
+
+            /* The other way around gives the same distance. */
+            DistanceResult reversed;
+            assert(b->getDistance(reversed, a));
+            assert(fabs(reversed.distance - result.distance) < 0.01f);
+            assert((reversed.normal + result.normal).magnitude() < 0.1f);
+        }
+    }
+
+    /* Boxes side by side are apart by the gap between their faces. */
+    auto unit = makeBox(Vector3f { -1, -1, -1 }, Vector3f { 1, 1, 1 });
+    auto left = makeCollider(root, unit, Vector3f::zero);
+    auto right = makeCollider(root, unit, Vector3f { 2.5f, 0.5f, -0.3f });
+    DistanceResult result;
+    assert(left->getDistance(result, right));
+    assert(fabs(result.distance - 0.5f) < 0.001f);
+    assert((result.normal - Vector3f::right).magnitude() < 0.001f);
+    assert(fabs(result.points[0][0] - 1) < 0.001f);
+    assert(fabs(result.points[1][0] - 1.5f) < 0.001f);
+
+    auto inside = makeCollider(root, unit, Vector3f { 1.5f, 0, 0 });
+    assert(!left->getDistance(result, inside));
+    assert(result.distance == 0);
+
+    /* A mesh floor is measured to its nearest triangle. */
+    vector<Vector3f> vertices {
+        Vector3f { 0, 0, 0 },
+        Vector3f { 10, 0, 0 },
+        Vector3f { 0, 0, 10 },
+        Vector3f { 10, 0, 10 } };
+    vector<uint32_t> indices { 0, 2, 1, 1, 2, 3 };
+    auto floor = makeCollider(
+            root,
+            make_shared<TriangleMesh>(vertices, indices),
+            Vector3f { 0, 1, 0 });
+    auto ball = makeCollider(
+            root,
+            make_shared<Sphere>(0.5f),
+            Vector3f { 3, 3, 4 });
+
+    assert(ball->getDistance(result, floor));
+    assert(fabs(result.distance - 1.5f) < 0.001f);
+    assert((result.normal + Vector3f::up).magnitude() < 0.001f);
+    assert((result.points[1] - Vector3f { 3, 1, 4 }).magnitude() < 0.01f);
+
+    assert(floor->getDistance(result, ball, 2));
+    assert(fabs(result.distance - 1.5f) < 0.001f);
+    assert((result.normal - Vector3f::up).magnitude() < 0.001f);
+    assert((result.points[0] - Vector3f { 3, 1, 4 }).magnitude() < 0.01f);
+
+    /* Triangles further than the maximum distance are not checked. */
+    assert(floor->getDistance(result, ball, 1));
+    assert(isinf(result.distance));
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <cassert>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/hashgrid.hpp"
+#include "prunertest.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+    HashGridPruner pruner(2.0f);
+
+    ColliderList colliders;
+    vector<shared_ptr<SpatialNode>> parents;
+    addRandomSpheres(root, colliders, parents, 400, 20);
+
+    /* Add a large static collider that covers many cells. */
+    auto ground = make_shared<SpatialNode>();
+    Box groundBox;
+    groundBox.add(Vector3f { -30, -1, -30 });
+    groundBox.add(Vector3f { 30, 1, 30 });
+    auto groundCollider = make_shared<Collider>(make_shared<Box>(groundBox));
+    ground->add(groundCollider);
+    root->add(ground);
+    colliders.push_back(groundCollider);
+
+    for(auto &collider : colliders)
+        pruner.add(collider);
+
+    checkPairs(pruner, colliders);
+    assert(pruner.cellCount() > 0);
+
+    /* Move the nodes around a few times. */
+    for(int frame = 0; frame < 10; frame ++)
+    {
+        moveRandomly(parents);
+        checkPairs(pruner, colliders);
+    }
+
+    /* Remove some colliders and add them back. */
+    ColliderList removedColliders;
+    for(int i = 0; i < 100; i ++)
+    {
+        pruner.remove(colliders.back());
+        removedColliders.push_back(colliders.back());
+        colliders.pop_back();
+    }
+    checkPairs(pruner, colliders);
+
+    for(auto &collider : removedColliders)
+    {
+        pruner.add(collider);
+        colliders.push_back(collider);
+    }
+    checkPairs(pruner, colliders);
+}
@@ -0,0 +1,110 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+#include "gnid/hull.hpp"
+#include "gnid/quickhull.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+static Vector3f randomVector(float min, float max)
+{
+    return Vector3f {
+        randomFloat(min, max),
+        randomFloat(min, max),
+        randomFloat(min, max) };
+}
+
+/**
+ * \brief Checks that the hull of the points contains all of them
+ */
+static void checkQuickHull(const vector<Vector3f> &points, size_t corners)
+{
+    QuickHull hull(points);
+    assert(hull.isValid());
+    assert(hull.vertices().size() == corners);
+
+    /* A closed surface made of triangles has two less than twice as many. */
+    assert(hull.faces().size() == 2 * hull.vertices().size() - 4);
+
+    for(auto &face : hull.faces())
+    {
+        Vector3f a = points[face[0]];
+        Vector3f normal =
+            (points[face[1]] - a).cross(points[face[2]] - a).normalized();
+        for(auto &point : points)
+            assert(normal.dot(point - a) < 0.0001f);
+    }
+}
+
+/**
+ * \brief Checks support() against the furthest point along random directions
+ */
+static void checkSupport(
+        const vector<Vector3f> &points,
+        size_t corners,
+        bool climbs)
+{
+    Hull hull(points);
+    assert(hull.points().size() == corners);
+    assert(hull.climbs() == climbs);
+
+    for(int i = 0; i < 1000; i ++)
+    {
+        Vector3f d = randomVector(-1, 1);
+        float expected = -numeric_limits<float>::infinity();
+        for(auto &point : points)
+            expected = max(expected, d.dot(point));
+        assert(fabs(d.dot(hull.support(d)) - expected) < 0.0001f);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    /* Points on a sphere are all corners. */
+    vector<Vector3f> sphere;
+    for(int i = 0; i < 200; i ++)
+        sphere.push_back(randomVector(-1, 1).normalized());
+    checkQuickHull(sphere, sphere.size());
+    checkSupport(sphere, sphere.size(), true);
+
+    /* Points inside the sphere are not. */
+    vector<Vector3f> ball = sphere;
+    for(int i = 0; i < 300; i ++)
+        ball.push_back(randomVector(-0.5f, 0.5f));
+    checkQuickHull(ball, sphere.size());
+    checkSupport(ball, sphere.size(), true);
+
+    /* Only the corners of a grid are on its hull. */
+    vector<Vector3f> grid;
+    for(float x = 0; x < 5; x ++)
+    {
+        for(float y = 0; y < 5; y ++)
+        {
+            for(float z = 0; z < 5; z ++)
+                grid.push_back(Vector3f { x, y, z } * 0.5f);
+        }
+    }
+    checkQuickHull(grid, 8);
+    checkSupport(grid, 8, false);
+
+    /* Flat points have no hull, so every point is kept and checked. */
+    vector<Vector3f> flat;
+    for(int i = 0; i < 100; i ++)
+        flat.push_back(Vector3f { randomFloat(-1, 1), 0, randomFloat(-1, 1) });
+    assert(!QuickHull(flat).isValid());
+    checkSupport(flat, flat.size(), false);
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <cassert>
+#include <iostream>
+
+#include "gnid/emptynode.hpp"
+#include "gnid/kdtree.hpp"
+#include "gnid/threadpool.hpp"
+#include "prunertest.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+    auto kdTree = make_shared<KdTree>();
+    KdTreePruner pruner(kdTree);
+
+    ColliderList colliders;
+    vector<shared_ptr<SpatialNode>> parents;
+    addRandomSpheres(root, colliders, parents, 400, 20);
+    for(auto &collider : colliders)
+        pruner.add(collider);
+
+    checkPairs(pruner, colliders);
+    int depth = kdTree->depth();
+
+    /*
+     * Finding the pairs in parallel should list the same pairs in the same
+     * order no matter how many threads are used.
+     */
+    PairList serial;
+    pruner.listOverlappingNodes(serial);
+    pruner.threadPool() = make_shared<ThreadPool>(1);
+    checkPairs(pruner, colliders);
+    PairList single, multiple;
+    pruner.listOverlappingNodes(single);
+    pruner.threadPool() = make_shared<ThreadPool>(4);
+    pruner.listOverlappingNodes(multiple);
+    assert(toSet(single) == toSet(serial));
+    assert(single == multiple);
+
+    /* The static colliders should be kept in their own tree. */
+    ColliderList dynamicColliders, staticColliders;
+    kdTree->listAllNodes(dynamicColliders);
+    pruner.staticTree()->listAllNodes(staticColliders);
+    assert(dynamicColliders.size() == 200 && staticColliders.size() == 200);
+    for(auto &collider : staticColliders)
+        assert(collider->isStatic());
+
+    /* Remove colliders from all over the tree. */
+    for(int i = 0; i < 300; i ++)
+    {
+        size_t index = rand() % colliders.size();
+        pruner.remove(colliders[index]);
+        colliders.erase(begin(colliders) + index);
+
+        ColliderList remaining;
+        kdTree->listAllNodes(remaining);
+        pruner.staticTree()->listAllNodes(remaining);
+        assert(remaining.size() == colliders.size());
+
+        if(i % 10 == 0)
+            checkPairs(pruner, colliders);
+    }
+    checkPairs(pruner, colliders);
+
+    /* Empty leaves should have been collapsed. */
+    assert(kdTree->depth() < depth);
+
+    /* Removing a collider twice should do nothing. */
+    auto last = colliders.back();
+    auto tree = last->isStatic() ? pruner.staticTree() : kdTree;
+    assert(tree->remove(last));
+    assert(!tree->remove(last));
+    colliders.pop_back();
+
+    /* Move the remaining nodes and add some back. */
+    moveRandomly(parents);
+    checkPairs(pruner, colliders);
+
+    /* Remove everything, then reuse the tree. */
+    for(auto &collider : colliders)
+        pruner.remove(collider);
+    colliders.clear();
+    checkPairs(pruner, colliders);
+
+    for(int i = 0; i < 200; i ++)
+    {
+        auto collider = make_shared<Collider>(
+                make_shared<Sphere>(randomFloat(0.25f, 2.0f)));
+        parents[i]->add(collider);
+        collider->calcBox();
+        colliders.push_back(collider);
+        pruner.add(collider);
+    }
+    checkPairs(pruner, colliders);
+
+    /* Leaves holding several colliders should list the same pairs. */
+    auto wide = make_shared<KdTree>(4);
+    KdTreePruner widePruner(wide);
+    for(auto &collider : colliders)
+        widePruner.add(collider);
+    checkPairs(widePruner, colliders);
+
+    for(int i = 0; i < 10; i ++)
+    {
+        widePruner.remove(colliders.back());
+        colliders.pop_back();
+    }
+    checkPairs(widePruner, colliders);
+}
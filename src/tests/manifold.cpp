@@ -0,0 +1,147 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/contactmanifold.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/trianglemesh.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static shared_ptr<Box> makeBox(const Vector3f &min, const Vector3f &max)
+{
+    auto box = make_shared<Box>();
+    box->add(min);
+    box->add(max);
+    return box;
+}
+
+static shared_ptr<Collider> makeCollider(
+        const shared_ptr<EmptyNode> &root,
+        const shared_ptr<Shape> &shape,
+        const Vector3f &position)
+{
+    auto parent = make_shared<SpatialNode>();
+    parent->transformWorld(getTranslateMatrix(position));
+    auto collider = make_shared<Collider>(shape);
+    parent->add(collider);
+    root->add(parent);
+    return collider;
+}
+
+static void move(const shared_ptr<Collider> &collider, const Vector3f &offset)
+{
+    collider->findAncestorByType<SpatialNode>()->transformWorld(
+            getTranslateMatrix(offset));
+}
+
+/**
+ * \brief Update the manifold from the overlap of the colliders
+ */
+static void update(
+        ContactManifold &manifold,
+        const shared_ptr<Collider> &a,
+        const shared_ptr<Collider> &b)
+{
+    Vector3f overlap = Vector3f::zero;
+    Vector3f initialAxis = Vector3f::right;
+    if(!a->getOverlap(overlap, initialAxis, b))
+        overlap = Vector3f::zero;
+    manifold.update(*a, *b, overlap);
+}
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+    auto floor = makeCollider(
+            root,
+            makeBox(Vector3f { -5, -1, -5 }, Vector3f { 5, 0, 5 }),
+            Vector3f::zero);
+
+    /* A box sunk slightly into the floor touches it at each bottom corner. */
+    auto box = makeCollider(
+            root,
+            makeBox(Vector3f { -1, -1, -1 } * 0.5f, Vector3f { 1, 1, 1 } * 0.5f),
+            Vector3f { 1, 0.49f, 2 });
+
+    ContactManifold manifold;
+    update(manifold, box, floor);
+    assert(manifold.size() == 4);
+    assert((manifold.normal() + Vector3f::up).magnitude() < 0.001f);
+    for(auto &point : manifold)
+    {
+        assert(fabs(point.depth - 0.01f) < 0.001f);
+        assert(fabs(point.points[0][1] + 0.01f) < 0.001f);
+        assert(fabs(fabs(point.points[0][0] - 1) - 0.5f) < 0.001f);
+        assert(fabs(fabs(point.points[0][2] - 2) - 0.5f) < 0.001f);
+        assert(point.lifetime == 0);
+    }
+
+    /* Moving a little keeps the same points. */
+    move(box, Vector3f { 0.005f, 0, 0 });
+    update(manifold, box, floor);
+    assert(manifold.size() == 4);
+    for(auto &point : manifold)
+    {
+        assert(point.lifetime == 1);
+        assert(fabs(fabs(point.points[0][0] - 1.005f) - 0.5f) < 0.001f);
+    }
+
+    /* Swapping the colliders turns the manifold around. */
+    ContactManifold swapped = manifold;
+    swapped.swapColliders();
+    assert((swapped.normal() - Vector3f::up).magnitude() < 0.001f);
+    for(size_t i = 0; i < swapped.size(); i ++)
+    {
+        assert(swapped[i].points[0] == manifold[i].points[1]);
+        assert(swapped[i].points[1] == manifold[i].points[0]);
+    }
+
+    /* Lifting the box away drops the points. */
+    move(box, Vector3f { 0, 0.1f, 0 });
+    update(manifold, box, floor);
+    assert(manifold.empty());
+
+    /* A sphere touches at a single point. */
+    auto sphere = makeCollider(
+            root,
+            make_shared<Sphere>(0.5f),
+            Vector3f { -2, 0.45f, 0 });
+    ContactManifold sphereManifold;
+    update(sphereManifold, floor, sphere);
+    assert(sphereManifold.size() == 1);
+    assert((sphereManifold.normal() - Vector3f::up).magnitude() < 0.001f);
+    assert(fabs(sphereManifold[0].depth - 0.05f) < 0.001f);
+    assert((sphereManifold[0].points[1] - Vector3f { -2, -0.05f, 0 })
+            .magnitude() < 0.001f);
+
+    /* A box resting on a mesh floor touches it at each bottom corner. */
+    auto meshRoot = make_shared<EmptyNode>();
+    vector<Vector3f> vertices {
+        Vector3f { -5, 0, -5 }, Vector3f { 5, 0, -5 },
+        Vector3f { 5, 0, 5 }, Vector3f { -5, 0, 5 } };
+    vector<uint32_t> indices { 0, 2, 1, 0, 3, 2 };
+    auto meshFloor = makeCollider(
+            meshRoot,
+            make_shared<TriangleMesh>(vertices, indices),
+            Vector3f::zero);
+    auto meshBox = makeCollider(
+            meshRoot,
+            makeBox(Vector3f { -1, -1, -1 } * 0.5f, Vector3f { 1, 1, 1 } * 0.5f),
+            Vector3f { 1, 0.49f, 2 });
+    ContactManifold meshManifold;
+    update(meshManifold, meshBox, meshFloor);
+    assert(meshManifold.size() == 4);
+    for(auto &point : meshManifold)
+        assert(fabs(point.depth - 0.01f) < 0.001f);
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "gnid/collider.hpp"
+#include "gnid/hull.hpp"
+#include "gnid/node.hpp"
+#include "gnid/objparser.hpp"
+#include "gnid/trianglemesh.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/*
+ * A cube whose faces use two materials, followed by a group holding a
+ * tetrahedron. Building physics nodes does not need an OpenGL context.
+ */
+static const char *obj = R"END(
+o Cube
+v 1.000000 1.000000 -1.000000
+v 1.000000 -1.000000 -1.000000
+v 1.000000 1.000000 1.000000
+v 1.000000 -1.000000 1.000000
+v -1.000000 1.000000 -1.000000
+v -1.000000 -1.000000 -1.000000
+v -1.000000 1.000000 1.000000
+v -1.000000 -1.000000 1.000000
+usemtl Red
+f 1 5 7 3
+f 4 3 7 8
+f 8 7 5 6
+usemtl Blue
+f 6 2 4 8
+f 2 1 3 4
+f 6 5 1 2
+g Wedge
+v 3.000000 0.000000 0.000000
+v 4.000000 0.000000 0.000000
+v 3.000000 1.000000 0.000000
+v 3.000000 0.000000 1.000000
+f 9 11 10
+f 9 10 12
+f 9 12 11
+f 10 11 12
+)END";
+
+static vector<shared_ptr<Collider>> build(ObjParser::PhysicsMode mode)
+{
+    stringstream stream;
+    stream << obj;
+    ObjParser parser(stream);
+    parser.parse();
+
+    vector<shared_ptr<Node>> nodes;
+    parser.buildPhysicsNode(mode)->listDescendants(nodes);
+
+    vector<shared_ptr<Collider>> colliders;
+    for(auto &node : nodes)
+    {
+        auto collider = dynamic_pointer_cast<Collider>(node);
+        if(collider)
+            colliders.push_back(collider);
+    }
+    return colliders;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Each object or group is one hull, even across materials. */
+    {
+        auto colliders = build(ObjParser::HULLS);
+        assert(colliders.size() == 2);
+
+        /* The order of the children is not part of the interface. */
+        auto cube = dynamic_pointer_cast<Hull>(colliders[0]->shape());
+        auto wedge = dynamic_pointer_cast<Hull>(colliders[1]->shape());
+        assert(cube && wedge);
+        if(cube->points().size() < wedge->points().size())
+            swap(cube, wedge);
+
+        assert(cube->points().size() == 8);
+        for(auto &point : cube->points())
+        {
+            for(int i = 0; i < 3; i ++)
+                assert(point[i] == 1 || point[i] == -1);
+        }
+
+        assert(wedge->points().size() == 4);
+        for(auto &point : wedge->points())
+            assert(point[0] >= 3 && point[0] <= 4);
+    }
+
+    /* Every triangle is a collider of its own by default. */
+    assert(build(ObjParser::TRIANGLES).size() == 16);
+
+    /* A mesh holds every triangle in a single collider. */
+    {
+        auto colliders = build(ObjParser::MESH);
+        assert(colliders.size() == 1);
+        assert(dynamic_pointer_cast<TriangleMesh>(colliders[0]->shape()));
+    }
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/capsule.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+static Vector3f randomVector(float min, float max)
+{
+    return Vector3f {
+        randomFloat(min, max),
+        randomFloat(min, max),
+        randomFloat(min, max) };
+}
+
+static shared_ptr<Collider> makeCollider(
+        const shared_ptr<EmptyNode> &root,
+        const shared_ptr<Shape> &shape,
+        const Matrix4f &toWorld)
+{
+    auto parent = make_shared<SpatialNode>();
+    parent->transformWorld(toWorld);
+    auto collider = make_shared<Collider>(shape);
+    parent->add(collider);
+    root->add(parent);
+    return collider;
+}
+
+static shared_ptr<Collider> makeCollider(
+        const shared_ptr<EmptyNode> &root,
+        const shared_ptr<Shape> &shape,
+        const Vector3f &position)
+{
+    return makeCollider(root, shape, getTranslateMatrix(position));
+}
+
+/**
+ * \brief A shape without a type, so that it always goes through GJK
+ */
+class GenericShape : public Shape
+{
+public:
+    GenericShape(const shared_ptr<Shape> &shape) : shape_(shape) {}
+
+    Vector3f support(const Vector3f &d) const override
+    {
+        return shape_->support(d);
+    }
+
+private:
+    shared_ptr<Shape> shape_;
+};
+
+static shared_ptr<Shape> makeShape(int index)
+{
+    switch(index % 3)
+    {
+    case 0:
+        return make_shared<Sphere>(randomFloat(0.2f, 1.0f));
+    case 1:
+        return make_shared<Capsule>(
+                randomFloat(0.2f, 0.5f),
+                randomVector(-0.5f, 0.5f),
+                randomVector(-0.5f, 0.5f));
+    default:
+    {
+        auto box = make_shared<Box>();
+        box->add(randomVector(-1.0f, -0.2f));
+        box->add(randomVector(0.2f, 1.0f));
+        return box;
+    }
+    }
+}
+
+static Matrix4f randomTransform()
+{
+    return getTranslateMatrix(randomVector(-1.5f, 1.5f))
+        * getRotateMatrix(
+                randomFloat(0, 6.3f),
+                randomVector(-1, 1).normalized())
+        * getScaleMatrix(Vector3f { 1, 1, 1 } * randomFloat(0.5f, 1.5f));
+}
+
+/**
+ * \brief Check the overlap found by EPA against the expected depth
+ *
+ * \details
+ *     Returns the overlap found, which should be zero if the colliders are
+ *     not overlapping.
+ */
+static Vector3f checkOverlap(
+        const shared_ptr<Collider> &a,
+        const shared_ptr<Collider> &b,
+        float expectedDepth)
+{
+    Vector3f overlap = Vector3f::zero;
+    Vector3f initialAxis = Vector3f::right;
+    bool overlapping = a->getOverlap(overlap, initialAxis, b);
+
+    if(expectedDepth < -0.01f)
+        assert(!overlapping);
+    if(expectedDepth > 0.01f)
+    {
+        assert(overlapping);
+        assert(fabs(overlap.magnitude() - expectedDepth) < 0.01f);
+    }
+
+    /* Starting from the axis found should give the same result. */
+    Vector3f warmOverlap = Vector3f::zero;
+    assert(a->getOverlap(warmOverlap, initialAxis, b) == overlapping);
+    assert(fabs(warmOverlap.magnitude() - overlap.magnitude()) < 0.01f);
+    return overlap;
+}
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+
+    /* Spheres overlap by the sum of their radii minus their distance. */
+    for(int i = 0; i < 500; i ++)
+    {
+        float radiusA = randomFloat(0.2f, 1.0f);
+        float radiusB = randomFloat(0.2f, 1.0f);
+        Vector3f offset = randomVector(-1.5f, 1.5f);
+
+        auto a = makeCollider(
+                root,
+                make_shared<Sphere>(radiusA),
+                Vector3f::zero);
+        auto b = makeCollider(root, make_shared<Sphere>(radiusB), offset);
+
+        float depth = radiusA + radiusB - offset.magnitude();
+        Vector3f overlap = checkOverlap(a, b, depth);
+
+        /*
+         * The overlap should point from one center to the other. Spheres with
+         * nearly the same center can be pushed apart in almost any direction,
+         * so those are skipped.
+         */
+        if(depth > 0.01f && offset.magnitude() > 0.5f)
+        {
+            float alignment = overlap.normalized().dot(offset.normalized());
+            assert(fabs(alignment) > 0.99f);
+        }
+    }
+
+    /* Boxes overlap by their smallest overlap along any axis. */
+    for(int i = 0; i < 500; i ++)
+    {
+        Box boxA, boxB;
+        boxA.add(randomVector(-1.0f, -0.2f));
+        boxA.add(randomVector(0.2f, 1.0f));
+        boxB.add(randomVector(-1.0f, -0.2f));
+        boxB.add(randomVector(0.2f, 1.0f));
+        Vector3f offset = randomVector(-1.5f, 1.5f);
+
+        auto a = makeCollider(root, make_shared<Box>(boxA), Vector3f::zero);
+        auto b = makeCollider(root, make_shared<Box>(boxB), offset);
+
+        float depth = numeric_limits<float>::infinity();
+        for(int j = 0; j < 3; j ++)
+        {
+            float overlap = min(
+                    boxA.max()[j] - (boxB.min()[j] + offset[j]),
+                    (boxB.max()[j] + offset[j]) - boxA.min()[j]);
+            depth = min(depth, overlap);
+        }
+        checkOverlap(a, b, depth);
+    }
+
+    /* A sphere against the side of a capsule. */
+    for(int i = 0; i < 500; i ++)
+    {
+        float radius = randomFloat(0.2f, 1.0f);
+        float capsuleRadius = randomFloat(0.2f, 0.5f);
+        float height = randomFloat(0.5f, 1.0f);
+        Vector3f offset = Vector3f {
+            randomFloat(-1.5f, 1.5f),
+            randomFloat(-height, height),
+            randomFloat(-1.5f, 1.5f) };
+
+        auto a = makeCollider(root, make_shared<Sphere>(radius), offset);
+        auto b = makeCollider(
+                root,
+                make_shared<Capsule>(
+                    capsuleRadius,
+                    Vector3f { 0, -height, 0 },
+                    Vector3f { 0, height, 0 }),
+                Vector3f::zero);
+
+        float distance = Vector3f { offset[0], 0, offset[2] }.magnitude();
+        checkOverlap(a, b, radius + capsuleRadius - distance);
+    }
+
+    /* The closed form tests should agree with GJK and EPA. */
+    int overlaps = 0;
+    for(int i = 0; i < 3000; i ++)
+    {
+        auto shapeA = makeShape(i);
+        auto shapeB = makeShape(i / 3);
+        Matrix4f toWorldA = randomTransform();
+        Matrix4f toWorldB = randomTransform();
+
+        auto a = makeCollider(root, shapeA, toWorldA);
+        auto b = makeCollider(root, shapeB, toWorldB);
+        auto genericA = makeCollider(
+                root,
+                make_shared<GenericShape>(shapeA),
+                toWorldA);
+        auto genericB = makeCollider(
+                root,
+                make_shared<GenericShape>(shapeB),
+                toWorldB);
+
+        Vector3f overlap = Vector3f::zero;
+        Vector3f expected = Vector3f::zero;
+        Vector3f initialAxis = Vector3f::right;
+        bool overlapping = a->getOverlap(overlap, initialAxis, b);
+        initialAxis = Vector3f::right;
+        bool expectedOverlapping =
+            genericA->getOverlap(expected, initialAxis, genericB);
+
+        /* Shapes that are barely touching could go either way. */
+        if(overlapping != expectedOverlapping)
+        {
+            assert(overlap.magnitude() < 0.01f);
+            assert(expected.magnitude() < 0.01f);
+            continue;
+        }
+        if(!overlapping)
+            continue;
+
+        overlaps ++;
+        assert(fabs(overlap.magnitude() - expected.magnitude()) < 0.03f);
+    }
+    assert(overlaps > 0);
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,175 @@
+#ifndef PRUNERTEST_HPP
+#define PRUNERTEST_HPP
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/collisionpruner.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+/*
+ * Helpers shared by the collision pruner tests, which check the pruners
+ * against brute force searches over random spheres.
+ */
+
+typedef std::vector<std::shared_ptr<gnid::Collider>> ColliderList;
+typedef std::vector<
+    std::pair<std::shared_ptr<gnid::Collider>, std::shared_ptr<gnid::Collider>>
+> PairList;
+typedef std::set<std::pair<gnid::Collider *, gnid::Collider *>> PairSet;
+
+inline float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+inline tmat::Vector3f randomVector(float min, float max)
+{
+    return tmat::Vector3f {
+        randomFloat(min, max),
+        randomFloat(min, max),
+        randomFloat(min, max) };
+}
+
+inline std::pair<gnid::Collider *, gnid::Collider *> makePair(
+        gnid::Collider *a,
+        gnid::Collider *b)
+{
+    return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+}
+
+inline PairSet toSet(const PairList &list)
+{
+    PairSet ret;
+    for(auto &p : list)
+    {
+        auto key = makePair(p.first.get(), p.second.get());
+        /* Each pair should only be listed once. */
+        assert(ret.count(key) == 0);
+        ret.insert(key);
+    }
+    return ret;
+}
+
+inline std::set<gnid::Collider *> toSet(const ColliderList &list)
+{
+    std::set<gnid::Collider *> ret;
+    for(auto &collider : list)
+    {
+        /* Each collider should only be listed once. */
+        assert(ret.count(collider.get()) == 0);
+        ret.insert(collider.get());
+    }
+    return ret;
+}
+
+/**
+ * \brief Returns every pair of overlapping colliders that is not static
+ */
+inline PairSet bruteForce(const ColliderList &colliders)
+{
+    PairSet ret;
+    for(size_t i = 0; i < colliders.size(); i ++)
+    {
+        for(size_t j = i + 1; j < colliders.size(); j ++)
+        {
+            auto &a = colliders[i], &b = colliders[j];
+            if((!a->isStatic() || !b->isStatic())
+                && a->box().overlaps(b->box()))
+            {
+                ret.insert(makePair(a.get(), b.get()));
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * \brief
+ *     Update the pruner and check that it lists the same pairs as a brute
+ *     force search, then return them
+ */
+inline PairSet checkPairs(
+        gnid::CollisionPruner &pruner,
+        const ColliderList &colliders)
+{
+    for(auto &collider : colliders)
+    {
+        if(collider->calcBox() && collider->isStatic())
+            pruner.staticColliderMoved(collider);
+    }
+    pruner.update();
+
+    PairList list;
+    pruner.listOverlappingNodes(list);
+
+    PairSet expected = bruteForce(colliders);
+    PairSet actual = toSet(list);
+    std::cout << actual.size() << " pairs, expected " << expected.size()
+        << std::endl;
+    assert(actual == expected);
+    return actual;
+}
+
+/**
+ * \brief Add spheres at random positions to the root
+ *
+ * \details
+ *     Every other sphere is static, and the rest have a rigidbody. The
+ *     spheres and their parents are added to the lists.
+ */
+inline void addRandomSpheres(
+        const std::shared_ptr<gnid::Node> &root,
+        ColliderList &colliders,
+        std::vector<std::shared_ptr<gnid::SpatialNode>> &parents,
+        int count,
+        float range,
+        float minRadius = 0.25f,
+        float maxRadius = 2.0f)
+{
+    for(int i = 0; i < count; i ++)
+    {
+        std::shared_ptr<gnid::SpatialNode> parent;
+        if(i % 2)
+            parent = std::make_shared<gnid::Rigidbody>();
+        else
+            parent = std::make_shared<gnid::SpatialNode>();
+        parent->transformWorld(
+                tmat::getTranslateMatrix(randomVector(-range, range)));
+
+        auto collider = std::make_shared<gnid::Collider>(
+                std::make_shared<gnid::Sphere>(
+                    randomFloat(minRadius, maxRadius)));
+        parent->add(collider);
+        root->add(parent);
+        collider->calcBox();
+
+        colliders.push_back(collider);
+        parents.push_back(parent);
+    }
+}
+
+/**
+ * \brief Start a new frame and move each node a little in a random direction
+ */
+inline void moveRandomly(
+        const std::vector<std::shared_ptr<gnid::SpatialNode>> &parents)
+{
+    for(auto &parent : parents)
+    {
+        parent->newFrame();
+        parent->transformWorld(tmat::getTranslateMatrix(randomVector(-1, 1)));
+    }
+}
+
+#endif
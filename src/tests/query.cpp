@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include "gnid/box.hpp"
+#include "gnid/bvh.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/hashgrid.hpp"
+#include "gnid/kdtree.hpp"
+#include "gnid/queryfilter.hpp"
+#include "gnid/sweepandprune.hpp"
+#include "prunertest.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+typedef vector<pair<float, shared_ptr<Collider>>> NearestList;
+
+static void checkNearest(const NearestList &actual, const NearestList &expected)
+{
+    assert(actual.size() == expected.size());
+    for(size_t i = 0; i < actual.size(); i ++)
+    {
+        assert(fabs(actual[i].first - expected[i].first) < 0.0001f);
+        if(i > 0)
+            assert(actual[i - 1].first <= actual[i].first);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+    SweepAndPrunePruner bruteForce;
+
+    /* The small cells make large queries check every collider instead. */
+    shared_ptr<CollisionPruner> pruners[] = {
+        make_shared<KdTreePruner>(make_shared<KdTree>(2)),
+        make_shared<BvhPruner>(make_shared<Bvh>(2)),
+        make_shared<HashGridPruner>(2.0f)
+    };
+
+    ColliderList colliders;
+    vector<shared_ptr<SpatialNode>> parents;
+    addRandomSpheres(root, colliders, parents, 500, 30);
+
+    for(size_t i = 0; i < colliders.size(); i ++)
+    {
+        auto &collider = colliders[i];
+        collider->isTrigger() = (i % 3 == 0);
+        bruteForce.add(collider);
+        for(auto &pruner : pruners)
+        {
+            pruner->add(collider);
+            if(collider->isStatic())
+                pruner->staticColliderMoved(collider);
+        }
+    }
+    bruteForce.update();
+    for(auto &pruner : pruners)
+        pruner->update();
+
+    QueryFilter filters[3];
+    filters[1].staticColliders = false;
+    filters[2].triggers = false;
+
+    ColliderList actual, expected;
+    NearestList nearest, expectedNearest;
+    actual.reserve(colliders.size());
+    nearest.reserve(10);
+
+    for(int i = 0; i < 200; i ++)
+    {
+        const QueryFilter &filter = filters[i % 3];
+
+        Box box;
+        box.add(randomVector(-30, 30));
+        box.add(box.min() + randomVector(0, 15));
+
+        expected.clear();
+        bruteForce.queryBox(expected, box, filter);
+        for(auto &pruner : pruners)
+        {
+            actual.clear();
+            pruner->queryBox(actual, box, filter);
+            assert(toSet(actual) == toSet(expected));
+        }
+
+        Vector3f center = randomVector(-30, 30);
+        float radius = randomFloat(0, 10);
+
+        expected.clear();
+        bruteForce.querySphere(expected, center, radius, filter);
+        for(auto &pruner : pruners)
+        {
+            actual.clear();
+            pruner->querySphere(actual, center, radius, filter);
+            assert(toSet(actual) == toSet(expected));
+
+            for(auto &collider : actual)
+                assert(filter.accepts(*collider));
+        }
+
+        size_t count = i % 11;
+        float maxDistance = (i % 2) ? 5.0f : numeric_limits<float>::infinity();
+        bruteForce.queryNearest(
+                expectedNearest,
+                center,
+                count,
+                maxDistance,
+                filter);
+        for(auto &pruner : pruners)
+        {
+            pruner->queryNearest(nearest, center, count, maxDistance, filter);
+            checkNearest(nearest, expectedNearest);
+        }
+    }
+
+    /* Queries with enough room in the list should not grow it. */
+    auto capacity = nearest.capacity();
+    for(auto &pruner : pruners)
+    {
+        pruner->queryNearest(nearest, Vector3f::zero, 10);
+        assert(nearest.size() == 10);
+        assert(nearest.capacity() == capacity);
+    }
+
+    /*
+     * Colliders removed since the last update are not found, and the others
+     * still are, including where the removed ones were.
+     */
+    auto removed = colliders.front();
+    bruteForce.remove(removed);
+    for(auto &pruner : pruners)
+        pruner->remove(removed);
+
+    Box removedBox = removed->box();
+    Box lastBox = colliders.back()->box();
+    for(const Box *box : { &removedBox, &lastBox })
+    {
+        expected.clear();
+        bruteForce.queryBox(expected, *box);
+        assert(!expected.empty());
+        for(auto &pruner : pruners)
+        {
+            actual.clear();
+            pruner->queryBox(actual, *box);
+            assert(toSet(actual) == toSet(expected));
+        }
+
+        Vector3f center = box->center();
+        bruteForce.queryNearest(expectedNearest, center, 5);
+        for(auto &pruner : pruners)
+        {
+            pruner->queryNearest(nearest, center, 5);
+            checkNearest(nearest, expectedNearest);
+            for(auto &item : nearest)
+                assert(item.second != removed);
+        }
+    }
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include "gnid/box.hpp"
+#include "gnid/bvh.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/kdtree.hpp"
+#include "gnid/raycasthit.hpp"
+#include "gnid/sweepandprune.hpp"
+#include "prunertest.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+/**
+ * \brief Returns the distance a ray travels before hitting a sphere
+ */
+static float raySphere(
+        const Vector3f &origin,
+        const Vector3f &direction,
+        const Vector3f &center,
+        float radius)
+{
+    Vector3f offset = origin - center;
+    float c = offset.dot(offset) - radius * radius;
+    if(c <= 0)
+        return 0;
+
+    float b = offset.dot(direction);
+    float discriminant = b * b - c;
+    if(b > 0 || discriminant < 0)
+        return numeric_limits<float>::infinity();
+    return -b - sqrt(discriminant);
+}
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+    SweepAndPrunePruner bruteForce;
+    shared_ptr<CollisionPruner> pruners[] = {
+        make_shared<KdTreePruner>(make_shared<KdTree>(2)),
+        make_shared<BvhPruner>(make_shared<Bvh>(2))
+    };
+
+    ColliderList spheres;
+    vector<shared_ptr<SpatialNode>> parents;
+    addRandomSpheres(root, spheres, parents, 300, 20, 0.25f, 1.5f);
+
+    vector<Vector3f> centers;
+    vector<float> radii;
+    for(size_t i = 0; i < spheres.size(); i ++)
+    {
+        centers.push_back(parents[i]->position());
+        radii.push_back(
+                static_pointer_cast<Sphere>(spheres[i]->shape())->radius());
+    }
+
+    /* Add a large static box below the spheres. */
+    auto ground = make_shared<SpatialNode>();
+    Box groundBox;
+    groundBox.add(Vector3f { -30, -25, -30 });
+    groundBox.add(Vector3f { 30, -23, 30 });
+    auto groundCollider = make_shared<Collider>(make_shared<Box>(groundBox));
+    ground->add(groundCollider);
+    root->add(ground);
+
+    ColliderList colliders = spheres;
+    colliders.push_back(groundCollider);
+    for(auto &collider : colliders)
+    {
+        collider->calcBox();
+        bruteForce.add(collider);
+        for(auto &pruner : pruners)
+            pruner->add(collider);
+    }
+    bruteForce.update();
+    for(auto &pruner : pruners)
+    {
+        pruner->staticColliderMoved(groundCollider);
+        pruner->update();
+    }
+
+    /* Check rays against the exact distances. */
+    int hits = 0;
+    for(int i = 0; i < 500; i ++)
+    {
+        Vector3f origin = randomVector(-25, 25);
+        Vector3f direction = randomVector(-1, 1);
+        float maxDistance = randomFloat(5, 60);
+
+        Vector3f unitDirection = direction.normalized();
+        float expected = numeric_limits<float>::infinity();
+        shared_ptr<Collider> expectedCollider;
+        for(size_t j = 0; j < spheres.size(); j ++)
+        {
+            float distance = raySphere(
+                    origin,
+                    unitDirection,
+                    centers[j],
+                    radii[j]);
+            if(distance < expected)
+            {
+                expected = distance;
+                expectedCollider = spheres[j];
+            }
+        }
+
+        float distance;
+        if(groundBox.raycast(distance, origin, unitDirection, expected))
+        {
+            expected = distance;
+            expectedCollider = groundCollider;
+        }
+
+        for(auto &pruner : pruners)
+        {
+            RaycastHit hit;
+            bool found = pruner->raycast(hit, origin, direction, maxDistance);
+            assert(found == (expected <= maxDistance));
+            if(!found)
+                continue;
+
+            hits ++;
+            assert(fabs(hit.distance - expected) < 0.01f);
+            assert(fabs(hit.normal.magnitude() - 1) < 0.001f);
+            assert((hit.point - (origin + unitDirection * hit.distance))
+                    .magnitude() < 0.01f);
+            if(hit.collider != expectedCollider)
+                cout << "tie at " << hit.distance << endl;
+
+            RaycastHit other;
+            assert(bruteForce.raycast(other, origin, direction, maxDistance));
+            assert(fabs(other.distance - hit.distance) < 0.01f);
+        }
+    }
+    cout << hits << " rays hit" << endl;
+    assert(hits > 0);
+
+    /* Check that sweeps find the same hits as the brute force search. */
+    Sphere ball(0.5f);
+    Box crate;
+    crate.add(Vector3f { -0.5f, -0.25f, -1 });
+    crate.add(Vector3f { 0.5f, 0.25f, 1 });
+
+    hits = 0;
+    for(int i = 0; i < 500; i ++)
+    {
+        const Shape &shape = (i % 2) ? static_cast<const Shape &>(ball) : crate;
+        auto from = getTranslateMatrix(randomVector(-25, 25));
+        auto to = getTranslateMatrix(randomVector(-25, 25));
+
+        for(auto &pruner : pruners)
+        {
+            RaycastHit hit, other;
+            bool found = pruner->sweep(hit, shape, from, to);
+            assert(found == bruteForce.sweep(other, shape, from, to));
+            if(!found)
+                continue;
+
+            hits ++;
+            assert(fabs(hit.distance - other.distance) < 0.01f);
+
+            /* Spheres swept against spheres hit at the sum of their radii. */
+            if(&shape == &ball && hit.collider != groundCollider)
+            {
+                size_t j = find(begin(spheres), end(spheres), hit.collider)
+                    - begin(spheres);
+                Vector3f origin = transform(from, Vector3f::zero);
+                Vector3f direction =
+                    (transform(to, Vector3f::zero) - origin).normalized();
+                float expected = raySphere(
+                        origin,
+                        direction,
+                        centers[j],
+                        radii[j] + ball.radius());
+                assert(fabs(hit.distance - expected) < 0.01f);
+            }
+        }
+    }
+    cout << hits << " sweeps hit" << endl;
+    assert(hits > 0);
+
+    /* A sweep that does not move only hits what it overlaps. */
+    for(auto &pruner : pruners)
+    {
+        RaycastHit hit;
+        auto at = getTranslateMatrix(centers[0]);
+        assert(pruner->sweep(hit, ball, at, at));
+        assert(hit.distance == 0);
+        at = getTranslateMatrix(Vector3f { 100, 100, 100 });
+        assert(!pruner->sweep(hit, ball, at, at));
+    }
+
+    return 0;
+}
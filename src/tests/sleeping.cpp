@@ -0,0 +1,129 @@
+#include <cassert>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/scene.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static shared_ptr<Box> makeBox(const Vector3f &min, const Vector3f &max)
+{
+    auto box = make_shared<Box>();
+    box->add(min);
+    box->add(max);
+    return box;
+}
+
+static shared_ptr<Rigidbody> addCrate(
+        const shared_ptr<Scene> &scene,
+        const Vector3f &position)
+{
+    auto crate = make_shared<Rigidbody>();
+    crate->transformWorld(getTranslateMatrix(position));
+    crate->add(make_shared<Collider>(
+                makeBox(Vector3f { -0.5f, -0.5f, -0.5f },
+                    Vector3f { 0.5f, 0.5f, 0.5f })));
+    scene->root->add(crate);
+    return crate;
+}
+
+int main(int argc, char *argv[])
+{
+    const float dt = 1.0f / 60.0f;
+
+    auto scene = make_shared<Scene>();
+    scene->init();
+    scene->root->add(make_shared<Collider>(
+                makeBox(Vector3f { -10, -1, -10 }, Vector3f { 10, 0, 10 })));
+
+    /* A stack of two crates resting on the floor falls asleep. */
+    auto bottom = addCrate(scene, Vector3f { 0, 0.5f, 0 });
+    auto top = addCrate(scene, Vector3f { 0, 1.5f, 0 });
+    for(int i = 0; i < scene->sleepFrames() + 10; i ++)
+        scene->update(dt);
+    assert(bottom->sleeping() && top->sleeping());
+
+    /* Sleeping crates stay where they are. */
+    Vector3f position = top->position();
+    for(int i = 0; i < 10; i ++)
+        scene->update(dt);
+    assert(top->position() == position);
+    assert(top->sleeping());
+
+    /* An impulse wakes a crate, which wakes the rest of its island. */
+    top->addImpulse(Vector3f { 0, 0.01f, 0 });
+    assert(!top->sleeping());
+    scene->update(dt);
+    assert(!bottom->sleeping());
+
+    for(int i = 0; i < scene->sleepFrames() + 10; i ++)
+        scene->update(dt);
+    assert(bottom->sleeping() && top->sleeping());
+
+    /* A crate landing on the stack wakes it up. */
+    auto falling = addCrate(scene, Vector3f { 0.2f, 4, 0 });
+    bool woken = false;
+    for(int i = 0; i < 3 * scene->sleepFrames(); i ++)
+    {
+        scene->update(dt);
+        if(!bottom->sleeping())
+            woken = true;
+    }
+    assert(woken);
+    assert(falling->position()[1] > 2.4f && falling->position()[1] < 2.6f);
+    assert(bottom->sleeping() && top->sleeping() && falling->sleeping());
+
+    /* Moving the floor away wakes the crate resting on it. */
+    {
+        auto scene = make_shared<Scene>();
+        scene->init();
+        auto floor = make_shared<SpatialNode>();
+        floor->add(make_shared<Collider>(
+                    makeBox(Vector3f { -10, -1, -10 },
+                        Vector3f { 10, 0, 10 })));
+        scene->root->add(floor);
+        auto crate = addCrate(scene, Vector3f { 0, 0.5f, 0 });
+        for(int i = 0; i < scene->sleepFrames() + 10; i ++)
+            scene->update(dt);
+        assert(crate->sleeping());
+
+        floor->transformWorld(getTranslateMatrix(Vector3f { 0, -10, 0 }));
+        for(int i = 0; i < 10; i ++)
+            scene->update(dt);
+        assert(!crate->sleeping());
+        assert(crate->position()[1] < 0.4f);
+    }
+
+    /* A static collider moved into a sleeping crate wakes it. */
+    {
+        auto scene = make_shared<Scene>();
+        scene->init();
+        scene->root->add(make_shared<Collider>(
+                    makeBox(Vector3f { -10, -1, -10 },
+                        Vector3f { 10, 0, 10 })));
+        auto crate = addCrate(scene, Vector3f { 0, 0.5f, 0 });
+        auto pusher = make_shared<SpatialNode>();
+        pusher->add(make_shared<Collider>(
+                    makeBox(Vector3f { -0.5f, 0, -0.5f },
+                        Vector3f { 0.5f, 1, 0.5f })));
+        pusher->transformWorld(getTranslateMatrix(Vector3f { 3, 0, 0 }));
+        scene->root->add(pusher);
+        for(int i = 0; i < scene->sleepFrames() + 10; i ++)
+            scene->update(dt);
+        assert(crate->sleeping());
+
+        pusher->transformWorld(getTranslateMatrix(Vector3f { -2.2f, 0, 0 }));
+        scene->update(dt);
+        assert(!crate->sleeping());
+    }
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/rigidbody.hpp"
+#include "gnid/scene.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static const float dt = 1.0f / 60.0f;
+
+static shared_ptr<Box> makeBox(const Vector3f &min, const Vector3f &max)
+{
+    auto box = make_shared<Box>();
+    box->add(min);
+    box->add(max);
+    return box;
+}
+
+static shared_ptr<Scene> makeScene(float friction = 0.5f)
+{
+    auto scene = make_shared<Scene>();
+    scene->init();
+    scene->sleepFrames() = 0;
+
+    auto floor = make_shared<Collider>(
+            makeBox(Vector3f { -50, -1, -50 }, Vector3f { 50, 0, 50 }));
+    floor->friction() = friction;
+    scene->root->add(floor);
+    return scene;
+}
+
+static shared_ptr<Rigidbody> addCrate(
+        const shared_ptr<Scene> &scene,
+        const Vector3f &position,
+        float friction = 0.5f,
+        float restitution = 0)
+{
+    auto crate = make_shared<Rigidbody>();
+    crate->transformWorld(getTranslateMatrix(position));
+    auto collider = make_shared<Collider>(
+            makeBox(Vector3f { -0.5f, -0.5f, -0.5f },
+                Vector3f { 0.5f, 0.5f, 0.5f }));
+    collider->friction() = friction;
+    collider->restitution() = restitution;
+    crate->add(collider);
+    scene->root->add(crate);
+    return crate;
+}
+
+int main(int argc, char *argv[])
+{
+    /* A stack of crates settles without sinking into each other. */
+    {
+        auto scene = makeScene();
+        vector<shared_ptr<Rigidbody>> stack;
+        for(int i = 0; i < 5; i ++)
+            stack.push_back(addCrate(scene, Vector3f { 0, 0.5f + i, 0 }));
+
+        for(int i = 0; i < 300; i ++)
+            scene->update(dt);
+
+        for(int i = 0; i < 5; i ++)
+        {
+            Vector3f position = stack[i]->position();
+            assert(fabs(position[1] - (0.5f + i)) < 0.05f);
+            assert(fabs(position[0]) < 0.001f && fabs(position[2]) < 0.001f);
+            assert(stack[i]->velocity().magnitude() < 0.05f);
+        }
+
+        /* An update without any time passing leaves the stack as it is. */
+        vector<Vector3f> positions;
+        for(auto &crate : stack)
+            positions.push_back(crate->position());
+        scene->update(0);
+        for(int i = 0; i < 5; i ++)
+            assert(stack[i]->position() == positions[i]);
+        scene->update(dt);
+        for(int i = 0; i < 5; i ++)
+        {
+            Vector3f position = stack[i]->position();
+            for(int j = 0; j < 3; j ++)
+                assert(isfinite(position[j]));
+            assert((position - positions[i]).magnitude() < 0.01f);
+        }
+    }
+
+    /* A bouncy crate bounces back up, and a dull one does not. */
+    {
+        auto scene = makeScene();
+        auto bouncy = addCrate(scene, Vector3f { -2, 3, 0 }, 0.5f, 0.8f);
+        auto dull = addCrate(scene, Vector3f { 2, 3, 0 });
+
+        float bouncyHeight = 0;
+        float dullHeight = 0;
+        bool landed = false;
+        for(int i = 0; i < 240; i ++)
+        {
+            scene->update(dt);
+            if(bouncy->position()[1] < 0.6f)
+                landed = true;
+            if(landed)
+            {
+                bouncyHeight = max(bouncyHeight, bouncy->position()[1]);
+                dullHeight = max(dullHeight, dull->position()[1]);
+            }
+        }
+        assert(landed);
+        assert(bouncyHeight > 1.5f);
+        assert(dullHeight < 0.6f);
+    }
+
+    /* Friction stops a sliding crate, and stops it sooner when higher. */
+    {
+        float distances[2];
+        float frictions[2] = { 0.2f, 0.8f };
+        for(int i = 0; i < 2; i ++)
+        {
+            auto scene = makeScene(frictions[i]);
+            auto crate = addCrate(scene, Vector3f { 0, 0.5f, 0 }, frictions[i]);
+            crate->addImpulse(Vector3f { 5, 0, 0 });
+
+            for(int j = 0; j < 240; j ++)
+                scene->update(dt);
+            assert(fabs(crate->velocity()[0]) < 0.01f);
+            assert(fabs(crate->position()[1] - 0.5f) < 0.05f);
+            distances[i] = crate->position()[0];
+        }
+        assert(distances[0] > distances[1] && distances[1] > 0.5f);
+    }
+
+    /* Overlapping crates are pushed apart by split impulses as well. */
+    {
+        auto scene = makeScene();
+        scene->solver().splitImpulse() = true;
+        auto bottom = addCrate(scene, Vector3f { 0, 0.4f, 0 });
+        auto top = addCrate(scene, Vector3f { 0, 1.2f, 0 });
+
+        for(int i = 0; i < 120; i ++)
+            scene->update(dt);
+        assert(fabs(bottom->position()[1] - 0.5f) < 0.05f);
+        assert(fabs(top->position()[1] - 1.5f) < 0.05f);
+        assert(top->velocity().magnitude() < 0.05f);
+    }
+
+    /*
+     * A body without a mass rests on the floor without being moved, and
+     * stops a crate landing on it.
+     */
+    {
+        auto scene = makeScene();
+        auto platform = make_shared<Rigidbody>(0.0f);
+        platform->transformWorld(getTranslateMatrix(Vector3f { 0, 0.5f, 0 }));
+        platform->add(make_shared<Collider>(
+                    makeBox(Vector3f { -2, -0.5f, -2 },
+                        Vector3f { 2, 0.5f, 2 })));
+        scene->root->add(platform);
+        auto crate = addCrate(scene, Vector3f { 0, 2, 0 });
+
+        for(int i = 0; i < 120; i ++)
+            scene->update(dt);
+        assert(platform->velocity() == Vector3f::zero);
+        assert(platform->position() == (Vector3f { 0, 0.5f, 0 }));
+        assert(fabs(crate->position()[1] - 1.5f) < 0.05f);
+    }
+
+    cout << "ok" << endl;
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "gnid/stepaccumulator.hpp"
+
+using namespace std;
+using namespace gnid;
+
+int main(int argc, char *argv[])
+{
+    /* Without a step, every frame is a single step. */
+    {
+        StepAccumulator steps;
+        assert(steps.advance(0.5f) == 1);
+        assert(steps.advance(0) == 1);
+        assert(steps.alpha() == 1);
+    }
+
+    /* Time left over is carried into the next frame. */
+    {
+        StepAccumulator steps;
+        steps.step() = 0.25f;
+        assert(steps.advance(0.1f) == 0);
+        assert(fabs(steps.alpha() - 0.4f) < 0.0001f);
+        assert(steps.advance(0.2f) == 1);
+        assert(fabs(steps.alpha() - 0.2f) < 0.0001f);
+        assert(steps.advance(0.55f) == 2);
+        assert(fabs(steps.alpha() - 0.4f) < 0.0001f);
+    }
+
+    /* A hitch takes at most maxSubsteps() steps and drops the rest. */
+    {
+        StepAccumulator steps;
+        steps.step() = 0.1f;
+        steps.maxSubsteps() = 3;
+        assert(steps.advance(1.05f) == 3);
+        assert(steps.alpha() >= 0 && steps.alpha() < 1);
+        assert(fabs(steps.alpha() - 0.5f) < 0.001f);
+
+        /* The next frame is not slowed down by the dropped time. */
+        assert(steps.advance(0.1f) == 1);
+        assert(fabs(steps.alpha() - 0.5f) < 0.001f);
+    }
+
+    cout << "ok" << endl;
+    return 0;
+}
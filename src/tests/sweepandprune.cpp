@@ -0,0 +1,100 @@
+#include <cassert>
+#include <iostream>
+
+#include "gnid/emptynode.hpp"
+#include "gnid/sweepandprune.hpp"
+#include "prunertest.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static PairSet previous;
+
+static void check(
+        SweepAndPrunePruner &pruner,
+        const ColliderList &colliders)
+{
+    PairSet actual = checkPairs(pruner, colliders);
+
+    PairList added, removed;
+    assert(pruner.listPairChanges(added, removed));
+    cout << added.size() << " added, " << removed.size() << " removed" << endl;
+
+    /* The changes should be the difference from the last update. */
+    PairSet expectedAdded, expectedRemoved;
+    for(auto &p : actual)
+        if(!previous.count(p))
+            expectedAdded.insert(p);
+    for(auto &p : previous)
+        if(!actual.count(p))
+            expectedRemoved.insert(p);
+    assert(toSet(added) == expectedAdded);
+    assert(toSet(removed) == expectedRemoved);
+
+    previous = actual;
+}
+
+int main(int argc, char *argv[])
+{
+    auto root = make_shared<EmptyNode>();
+    SweepAndPrunePruner pruner;
+
+    ColliderList colliders;
+    vector<shared_ptr<SpatialNode>> parents;
+    addRandomSpheres(root, colliders, parents, 400, 20);
+    for(auto &collider : colliders)
+        pruner.add(collider);
+
+    check(pruner, colliders);
+
+    /* Move the nodes around a few times. */
+    for(int frame = 0; frame < 10; frame ++)
+    {
+        moveRandomly(parents);
+        check(pruner, colliders);
+    }
+
+    /* Nothing moved, so nothing should change. */
+    check(pruner, colliders);
+
+    /* Remove some colliders and add them back. */
+    ColliderList removedColliders;
+    for(int i = 0; i < 100; i ++)
+    {
+        pruner.remove(colliders.back());
+        removedColliders.push_back(colliders.back());
+        colliders.pop_back();
+    }
+    check(pruner, colliders);
+
+    for(auto &collider : removedColliders)
+    {
+        pruner.add(collider);
+        colliders.push_back(collider);
+    }
+    check(pruner, colliders);
+
+    /*
+     * Colliders removed before an update found their pairs, or removed and
+     * added back between updates, are handled by the next update.
+     */
+    for(int i = 0; i < 50; i ++)
+        pruner.remove(removedColliders[i]);
+    for(int i = 0; i < 25; i ++)
+        pruner.add(removedColliders[i]);
+    for(int i = 50; i < 100; i ++)
+        pruner.remove(removedColliders[i]);
+    for(int i = 50; i < 75; i ++)
+        pruner.add(removedColliders[i]);
+    colliders.resize(300);
+    colliders.insert(
+            end(colliders),
+            begin(removedColliders),
+            begin(removedColliders) + 25);
+    colliders.insert(
+            end(colliders),
+            begin(removedColliders) + 50,
+            begin(removedColliders) + 75);
+    check(pruner, colliders);
+}
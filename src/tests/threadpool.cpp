@@ -0,0 +1,46 @@
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "gnid/threadpool.hpp"
+
+using namespace std;
+using namespace gnid;
+
+static void check(ThreadPool &pool, size_t count)
+{
+    vector<atomic<int>> calls(count);
+    for(auto &call : calls)
+        call = 0;
+
+    pool.parallelFor(count, [&](size_t i)
+    {
+        calls[i] ++;
+    });
+
+    /* Every index should be run exactly once. */
+    for(auto &call : calls)
+        assert(call == 1);
+}
+
+int main(int argc, char *argv[])
+{
+    for(unsigned int threadCount : { 0, 1, 2, 8 })
+    {
+        ThreadPool pool(threadCount);
+        cout << threadCount << " threads, using "
+             << pool.threadCount() << endl;
+        assert(pool.threadCount() >= 1);
+
+        /* Run many loops of different sizes to catch missed wakeups. */
+        for(int i = 0; i < 200; i ++)
+            check(pool, i % 50);
+
+        check(pool, 100000);
+    }
+
+    /* The default pool should use at least one thread. */
+    ThreadPool pool;
+    check(pool, 1000);
+}
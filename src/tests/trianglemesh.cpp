@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "gnid/box.hpp"
+#include "gnid/collider.hpp"
+#include "gnid/emptynode.hpp"
+#include "gnid/raycasthit.hpp"
+#include "gnid/sphere.hpp"
+#include "gnid/spatialnode.hpp"
+#include "gnid/trianglemesh.hpp"
+#include "gnid/matrix/matrix.hpp"
+
+using namespace std;
+using namespace gnid;
+using namespace tmat;
+
+static float randomFloat(float min, float max)
+{
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+static Vector3f randomVector(float min, float max)
+{
+    return Vector3f {
+        randomFloat(min, max),
+        randomFloat(min, max),
+        randomFloat(min, max) };
+}
+
+/**
+ * \brief Create a grid of size by size squares on the xz plane
+ *
+ * \details
+ *     Each corner is raised by the height function.
+ */
+template<typename Height>
+static shared_ptr<TriangleMesh> makeGrid(int size, const Height &height)
+{
+    vector<Vector3f> vertices;
+    vector<uint32_t> indices;
+    for(int x = 0; x <= size; x ++)
+    {
+        for(int z = 0; z <= size; z ++)
+            vertices.push_back(Vector3f { (float) x, height(x, z), (float) z });
+    }
+
+    for(int x = 0; x < size; x ++)
+    {
+        for(int z = 0; z < size; z ++)
+        {
+            uint32_t corner = x * (size + 1) + z;
+            uint32_t next = corner + size + 1;
+            indices.insert(indices.end(), { corner, corner + 1, next });
+            indices.insert(indices.end(), { next, corner + 1, next + 1 });
+        }
+    }
+    return make_shared<TriangleMesh>(vertices, indices);
+}
+
+static shared_ptr<Collider> makeCollider(
+        const shared_ptr<EmptyNode> &root,
+        const shared_ptr<Shape> &shape,
+        const Vector3f &position)
+{
+    auto parent = make_shared<SpatialNode>();
+    parent->transformWorld(getTranslateMatrix(position));
+    auto collider = make_shared<Collider>(shape);
+    parent->add(collider);
+    root->add(parent);
+    return collider;
+}
+
+int main(int argc, char *argv[])
+{
+    auto bumpy = makeGrid(
+            30,
+            [](int x, int z) { return sin(x * 0.7f) * cos(z * 0.4f); });
+    assert(bumpy->triangleCount() == 30 * 30 * 2);
+
+    /* The hierarchy should find the same triangles as checking every one. */
+    for(int i = 0; i < 200; i ++)
+    {
+        Box box;
+        box.add(randomVector(-2, 32));
+        box.add(box.min() + randomVector(0, 4));
+
+        vector<uint32_t> found;
+        bumpy->listOverlappingTriangles(box, found);
+        sort(found.begin(), found.end());
+
+        vector<uint32_t> expected;
+        for(uint32_t j = 0; j < bumpy->triangleCount(); j ++)
+        {
+            Box bounds;
+            for(auto &corner : bumpy->triangle(j))
+                bounds.add(corner);
+            if(bounds.overlaps(box))
+                expected.push_back(j);
+        }
+        assert(found == expected);
+    }
+
+    /* Rays should hit the nearest triangle along them. */
+    for(int i = 0; i < 500; i ++)
+    {
+        Vector3f origin = randomVector(0, 30);
+        origin[1] = randomFloat(-2, 2);
+        Vector3f direction = randomVector(-1, 1).normalized();
+
+        float distance;
+        uint32_t triangle;
+        bool hit = bumpy->raycast(distance, triangle, origin, direction, 50);
+
+        /* Intersect the plane of each triangle and check its edges. */
+        float expected = numeric_limits<float>::infinity();
+        for(uint32_t j = 0; j < bumpy->triangleCount(); j ++)
+        {
+            auto corners = bumpy->triangle(j);
+            Vector3f normal =
+                (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+            float t = normal.dot(corners[0] - origin) / normal.dot(direction);
+            if(!(t >= 0 && t <= 50))
+                continue;
+
+            Vector3f point = origin + direction * t;
+            bool inside = true;
+            for(int k = 0; k < 3; k ++)
+            {
+                Vector3f edge = corners[(k + 1) % 3] - corners[k];
+                if(edge.cross(point - corners[k]).dot(normal) < -1e-4f)
+                    inside = false;
+            }
+            if(inside)
+                expected = min(expected, t);
+        }
+
+        if(isinf(expected))
+            continue;
+        assert(hit);
+        assert(fabs(distance - expected) < 0.001f);
+    }
+
+    /* A flat floor at a height of one. */
+    auto root = make_shared<EmptyNode>();
+    auto floor = makeCollider(
+            root,
+            makeGrid(10, [](int x, int z) { return 0.0f; }),
+            Vector3f { 0, 1, 0 });
+
+    /* Spheres resting on the floor overlap it by the depth they sink in. */
+    for(int i = 0; i < 200; i ++)
+    {
+        float radius = randomFloat(0.2f, 1.0f);
+        float height = randomFloat(-0.5f, 1.5f) * radius;
+        Vector3f position { randomFloat(1, 9), 1 + height, randomFloat(1, 9) };
+        auto sphere = makeCollider(root, make_shared<Sphere>(radius), position);
+
+        Vector3f overlap;
+        Vector3f initialAxis = Vector3f::right;
+        bool overlapping = sphere->getOverlap(overlap, initialAxis, floor);
+        float depth = radius - fabs(height);
+        if(depth < -0.01f)
+            assert(!overlapping);
+        if(depth > 0.01f)
+        {
+            assert(overlapping);
+            assert(fabs(overlap.magnitude() - depth) < 0.01f);
+            assert(fabs(overlap.normalized()[1]) > 0.99f);
+
+            /* The other way around gives the opposite overlap. */
+            Vector3f reversed;
+            assert(floor->getOverlap(reversed, initialAxis, sphere));
+            assert((reversed + overlap).magnitude() < 0.01f);
+        }
+    }
+
+    /* Rays and swept shapes hit the floor from above and below. */
+    RaycastHit hit;
+    assert(floor->raycast(hit, Vector3f { 5, 4, 5 }, -Vector3f::up, 10));
+    assert(fabs(hit.distance - 3) < 0.001f);
+    assert((hit.normal - Vector3f::up).magnitude() < 0.001f);
+    assert(floor->raycast(hit, Vector3f { 5, -1, 5 }, Vector3f::up, 10));
+    assert(fabs(hit.distance - 2) < 0.001f);
+    assert((hit.normal + Vector3f::up).magnitude() < 0.001f);
+    assert(!floor->raycast(hit, Vector3f { 5, 4, 5 }, Vector3f::up, 10));
+    assert(!floor->raycast(hit, Vector3f { 5, 4, 5 }, -Vector3f::up, 2));
+
+    Sphere ball(0.5f);
+    assert(floor->sweep(
+                hit,
+                ball,
+                getTranslateMatrix(Vector3f { 5, 4, 5 }),
+                -Vector3f::up,
+                10));
+    assert(fabs(hit.distance - 2.5f) < 0.01f);
+    assert(!floor->sweep(
+                hit,
+                ball,
+                getTranslateMatrix(Vector3f { 5, 4, 5 }),
+                -Vector3f::up,
+                2));
+
+    cout << "ok" << endl;
+    return 0;
+}